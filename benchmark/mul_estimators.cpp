@@ -0,0 +1,155 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <tbb/global_control.h>
+
+#include <mp++/integer.hpp>
+
+#include <obake/config.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+
+#include "sparse_dense_options.hpp"
+
+using namespace obake;
+using namespace obake_benchmark;
+
+using p_type = polynomial<packed_monomial<
+#if defined(OBAKE_PACKABLE_INT64)
+                              std::uint64_t
+#else
+                              std::uint32_t
+#endif
+                              >,
+                          mppp::integer<2>>;
+
+// Run the workload f with both product size estimators,
+// printing the accuracy of the estimates and the timings.
+// f must invoke the functor it is passed after each
+// multiplication, so that the statistics can be recorded.
+template <typename F>
+void run_estimators(const std::string &name, const F &f)
+{
+    for (auto est : {polynomials::mul_estimator::sampling, polynomials::mul_estimator::sketch}) {
+        auto p = polynomials::get_default_mul_policy();
+        p.estimator = est;
+        const polynomials::mul_policy_guard pg(p);
+
+        // The number of multiplications, the accumulated
+        // relative errors and estimation times.
+        unsigned n_mults = 0;
+        double max_err = 0, avg_err = 0, est_time = 0;
+        auto record = [&]() {
+            const auto stats = polynomials::get_last_mul_stats();
+            if (stats.n_terms == 0u || stats.est_n_terms == 0u) {
+                // Not a multi-threaded multiplication.
+                return;
+            }
+
+            const auto err = std::abs(static_cast<double>(stats.est_n_terms) - static_cast<double>(stats.n_terms))
+                             / static_cast<double>(stats.n_terms);
+            ++n_mults;
+            max_err = std::max(max_err, err);
+            avg_err += err;
+            est_time += stats.est_time;
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        f(record);
+        const auto tot_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << name << ", " << (est == polynomials::mul_estimator::sampling ? "sampling" : "sketch")
+                  << " estimator:\n";
+        std::cout << "  Number of MT multiplications: " << n_mults << '\n';
+        if (n_mults > 0u) {
+            std::cout << "  Average relative error      : " << avg_err / n_mults << '\n';
+            std::cout << "  Max relative error          : " << max_err << '\n';
+        }
+        std::cout << "  Estimation time             : " << est_time * 1000 << "ms\n";
+        std::cout << "  Total time                  : " << tot_time * 1000 << "ms\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    try {
+        const auto [nthreads, power] = sparse_dense_options(argc, argv, 12);
+
+        std::optional<tbb::global_control> c;
+        if (nthreads > 0) {
+            c.emplace(tbb::global_control::max_allowed_parallelism, nthreads);
+        }
+
+        // The sparse benchmark.
+        run_estimators("Sparse", [power = power](const auto &record) {
+            auto [x, y, z, t, u] = make_polynomials<p_type>("x", "y", "z", "t", "u");
+
+            auto f = (x + y + z * z * 2 + t * t * t * 3 + u * u * u * u * u * 5 + 1);
+            const auto tmp_f(f);
+            auto g = (u + t + z * z * 2 + y * y * y * 3 + x * x * x * x * x * 5 + 1);
+            const auto tmp_g(g);
+
+            for (int i = 1; i < power; ++i) {
+                f *= tmp_f;
+                g *= tmp_g;
+            }
+
+            const auto ret = f * g;
+            record();
+
+            // The truncated variant.
+            const auto ret_t = truncated_mul(f, g, power * 12);
+            record();
+        });
+
+        // The dense benchmark in 4 variables.
+        run_estimators("Dense (4 variables)", [](const auto &record) {
+            auto [x, y, z, t] = make_polynomials<p_type>("x", "y", "z", "t");
+
+            auto f = x + y + z + t + 1;
+            const auto tmp(f);
+            for (auto i = 1; i < 20; ++i) {
+                f *= tmp;
+            }
+            const auto g = f + 1;
+
+            const auto ret = f * g;
+            record();
+        });
+
+        // The rectangular benchmark.
+        run_estimators("Rectangular", [](const auto &record) {
+            auto [x, y, z] = make_polynomials<p_type>("x", "y", "z");
+
+            auto f = x * y * y * y * z * z + x * x * y * y * z + x * y * y * y * z + x * y * y * z * z
+                     + y * y * y * z * z + y * y * y * z + 2 * y * y * z * z + 2 * x * y * z + y * y * z + y * z * z
+                     + y * y + 2 * y * z + z;
+
+            p_type curr(1);
+            for (auto i = 1; i <= 70; ++i) {
+                curr *= f;
+                record();
+            }
+        });
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
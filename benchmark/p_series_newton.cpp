@@ -0,0 +1,153 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <tbb/global_control.h>
+
+#include <obake/config.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/power_series/power_series.hpp>
+
+#include "sparse_dense_options.hpp"
+
+using namespace obake;
+using namespace obake_benchmark;
+
+using ps_type = p_series<packed_monomial<
+#if defined(OBAKE_PACKABLE_INT64)
+                             std::int64_t
+#else
+                             std::int32_t
+#endif
+                             >,
+                         double>;
+
+// Run f, print its runtime and return its result.
+template <typename F>
+ps_type run(const std::string &name, const F &f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto ret = f();
+    const auto tot_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "  " << name << ": " << tot_time * 1000 << "ms (" << ret.size() << " terms)\n";
+
+    return ret;
+}
+
+// Constant series with value c and the
+// symbol set/truncation of p.
+ps_type constant(const ps_type &p, double c)
+{
+    auto ret(p);
+    ret.clear_terms();
+    ret += c;
+    return ret;
+}
+
+// Max abs value of the coefficients of p.
+double max_abs(const ps_type &p)
+{
+    double ret = 0;
+    for (const auto &t : p) {
+        ret = std::max(ret, std::abs(t.second));
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    try {
+        const auto [nthreads, power] = sparse_dense_options(argc, argv, 16);
+
+        std::optional<tbb::global_control> c;
+        if (nthreads > 0) {
+            c.emplace(tbb::global_control::max_allowed_parallelism, nthreads);
+        }
+
+        auto [x, y, z, t] = make_p_series_t<ps_type>(power, "x", "y", "z", "t");
+
+        // A series without constant term.
+        const auto u = x - y / 2 + z * t + x * y * z / 3 + t * t / 5;
+
+        std::cout << "Truncation degree: " << power << '\n';
+
+        // Reciprocal of 1 + u.
+        std::cout << "Reciprocal:\n";
+        const auto inv_naive = run("naive", [&]() {
+            // 1 / (1 + u) = sum (-u)**k.
+            auto ret = constant(u, 1), cur = ret;
+            for (auto k = 1; k <= power; ++k) {
+                cur *= -u;
+                ret += cur;
+            }
+            return ret;
+        });
+        const auto inv_newton = run("Newton", [&]() { return p_series_inv(1 + u); });
+        std::cout << "  Max abs difference: " << max_abs(inv_naive - inv_newton) << '\n';
+
+        // Exponential of u.
+        std::cout << "Exponential:\n";
+        const auto exp_naive = run("naive", [&]() {
+            // exp(u) = sum u**k / k!.
+            auto ret = constant(u, 1), cur = ret;
+            for (auto k = 1; k <= power; ++k) {
+                cur *= u;
+                cur /= k;
+                ret += cur;
+            }
+            return ret;
+        });
+        const auto exp_newton = run("Newton", [&]() { return p_series_exp(u); });
+        std::cout << "  Max abs difference: " << max_abs(exp_naive - exp_newton) << '\n';
+
+        // Logarithm of 1 + u.
+        std::cout << "Logarithm:\n";
+        const auto log_naive = run("naive", [&]() {
+            // log(1 + u) = sum (-1)**(k + 1) * u**k / k.
+            auto ret = constant(u, 0), cur = constant(u, 1);
+            for (auto k = 1; k <= power; ++k) {
+                cur *= u;
+                ret += (k % 2 == 1 ? 1. : -1.) / k * cur;
+            }
+            return ret;
+        });
+        const auto log_newton = run("Newton", [&]() { return p_series_log(1 + u); });
+        std::cout << "  Max abs difference: " << max_abs(log_naive - log_newton) << '\n';
+
+        // Square root of 1 + u.
+        std::cout << "Square root:\n";
+        const auto sqrt_naive = run("naive", [&]() {
+            // sqrt(1 + u) = sum binomial(1/2, k) * u**k.
+            auto ret = constant(u, 1), cur = ret;
+            double bin = 1;
+            for (auto k = 1; k <= power; ++k) {
+                bin *= (.5 - (k - 1)) / k;
+                cur *= u;
+                ret += bin * cur;
+            }
+            return ret;
+        });
+        const auto sqrt_newton = run("Newton", [&]() { return p_series_sqrt(1 + u); });
+        std::cout << "  Max abs difference: " << max_abs(sqrt_naive - sqrt_newton) << '\n';
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
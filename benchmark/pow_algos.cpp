@@ -0,0 +1,111 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include <tbb/global_control.h>
+
+#include <mp++/integer.hpp>
+
+#include <obake/config.hpp>
+#include <obake/math/pow.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/series.hpp>
+
+#include "sparse_dense_options.hpp"
+
+using namespace obake;
+using namespace obake_benchmark;
+
+using p_type = polynomial<packed_monomial<
+#if defined(OBAKE_PACKABLE_INT64)
+                              std::uint64_t
+#else
+                              std::uint32_t
+#endif
+                              >,
+                          mppp::integer<2>>;
+
+// Time the computation of f**n, starting from an empty
+// pow cache, for increasing values of n and for all
+// the pow algorithms. If 'all_powers' is true, all the powers
+// up to f**n are requested (in increasing order), otherwise
+// only f**n.
+void run_pow_algos(const std::string &name, const p_type &f, int max_power, bool all_powers)
+{
+    std::cout << name << (all_powers ? ", all powers" : ", single power") << ":\n";
+
+    for (auto n = 2; n <= max_power; n *= 2) {
+        std::cout << "  n = " << n << ":";
+
+        for (auto algo : {pow_algo::linear, pow_algo::binary, pow_algo::automatic}) {
+            set_pow_algo(algo);
+            clear_pow_cache();
+
+            const auto start = std::chrono::steady_clock::now();
+            for (auto i = all_powers ? 1 : n; i <= n; ++i) {
+                const auto ret = obake::pow(f, i);
+            }
+            const auto tot_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << "  " << (algo == pow_algo::linear ? "linear" : (algo == pow_algo::binary ? "binary" : "auto"))
+                      << " " << tot_time * 1000 << "ms";
+        }
+
+        std::cout << '\n';
+    }
+
+    set_pow_algo(pow_algo::linear);
+    clear_pow_cache();
+}
+
+int main(int argc, char **argv)
+{
+    try {
+        const auto [nthreads, power] = sparse_dense_options(argc, argv, 64);
+
+        std::optional<tbb::global_control> c;
+        if (nthreads > 0) {
+            c.emplace(tbb::global_control::max_allowed_parallelism, nthreads);
+        }
+
+        // The rectangular base (see rectangular_01.cpp).
+        {
+            auto [x, y, z] = make_polynomials<p_type>("x", "y", "z");
+
+            const auto f = x * y * y * y * z * z + x * x * y * y * z + x * y * y * y * z + x * y * y * z * z
+                           + y * y * y * z * z + y * y * y * z + 2 * y * y * z * z + 2 * x * y * z + y * y * z
+                           + y * z * z + y * y + 2 * y * z + z;
+
+            run_pow_algos("Rectangular", f, power, false);
+            run_pow_algos("Rectangular", f, power, true);
+        }
+
+        // A sparse base (see sparse.cpp).
+        {
+            auto [x, y, z, t, u] = make_polynomials<p_type>("x", "y", "z", "t", "u");
+
+            const auto f = x + y + z * z * 2 + t * t * t * 3 + u * u * u * u * u * 5 + 1;
+
+            run_pow_algos("Sparse", f, power / 4, false);
+            run_pow_algos("Sparse", f, power / 4, true);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,332 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_DETAIL_ACC_TABLE_HPP
+#define OBAKE_DETAIL_ACC_TABLE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <obake/config.hpp>
+#include <obake/exceptions.hpp>
+
+namespace obake::detail
+{
+
+// A minimal open-addressing hash table used to accumulate
+// the terms produced in the inner loops of the polynomial
+// multiplication kernels.
+//
+// The main differences wrt abseil's flat_hash_map are:
+// - the coefficient of a new term is constructed in place
+//   via a user-supplied functor only if the key is not
+//   in the table already (lazy construction),
+// - the table is exception safe: if an insertion throws, the
+//   table is left in a valid state (basic guarantee). If the
+//   exception is raised by the construction of the new key or
+//   coefficient, the terms already in the table are unaffected,
+//   but if it is raised while growing the table, some of the
+//   terms may be moved-from (see
+//   https://github.com/abseil/abseil-cpp/issues/388 for the
+//   reason why we cannot use abseil's tables here).
+//
+// The table supports only insertion/accumulation, clearing
+// and a destructive traversal via consume(). It uses linear
+// probing on a power-of-2 number of slots. The hash of each
+// key is stored alongside the slot, so that rehashing does not
+// need to invoke the hasher again and most failed comparisons
+// are resolved without touching the keys.
+//
+// NOTE: in the multiplication kernels the hash values of
+// all the keys inserted into a table share the same low bits
+// (due to homomorphic hashing and segmentation). Thus, we
+// determine the home slot from the high bits of a
+// multiplicative mix of the hash value.
+template <typename K, typename C, typename Hash, typename Eq>
+class acc_table
+{
+    // The storage for a term: suitably-aligned raw
+    // memory for a key and a coefficient.
+    struct slot {
+        alignas(K) unsigned char m_key[sizeof(K)];
+        alignas(C) unsigned char m_cf[sizeof(C)];
+    };
+
+    // Slot metadata: the hash of the key and a flag
+    // signalling if the slot is occupied.
+    struct meta {
+        ::std::size_t m_hash;
+        bool m_full;
+    };
+
+public:
+    using size_type = ::std::size_t;
+
+    acc_table() = default;
+    acc_table(const acc_table &) = delete;
+    acc_table(acc_table &&) = delete;
+    acc_table &operator=(const acc_table &) = delete;
+    acc_table &operator=(acc_table &&) = delete;
+    ~acc_table()
+    {
+        clear();
+    }
+
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+    bool empty() const noexcept
+    {
+        return m_size == 0u;
+    }
+    size_type capacity() const noexcept
+    {
+        return m_log2_cap == 0u ? size_type(0) : (size_type(1) << m_log2_cap);
+    }
+
+    // Ensure that the table can contain at least n
+    // elements without rehashing.
+    void reserve(size_type n)
+    {
+        unsigned new_log2_cap = min_log2_cap;
+        while (max_load(new_log2_cap) < n) {
+            // LCOV_EXCL_START
+            if (obake_unlikely(new_log2_cap == static_cast<unsigned>(::std::numeric_limits<size_type>::digits) - 1u)) {
+                obake_throw(::std::overflow_error, "Overflow in the computation of the size of an accumulation table");
+            }
+            // LCOV_EXCL_STOP
+            ++new_log2_cap;
+        }
+
+        if (new_log2_cap > m_log2_cap) {
+            rehash(new_log2_cap);
+        }
+    }
+
+    // Look for the key k in the table. If k is not in the table,
+    // a new term will be constructed with key k and coefficient
+    // f(). The return value is a pointer to the coefficient of the
+    // term with key k, and a flag signalling whether the
+    // insertion took place.
+    template <typename F>
+    ::std::pair<C *, bool> lazy_emplace(const K &k, F &&f)
+    {
+        if (obake_unlikely(m_log2_cap == 0u)) {
+            rehash(min_log2_cap);
+        }
+
+        const auto h = static_cast<::std::size_t>(m_hasher(k));
+
+        // Look for k.
+        auto idx = home_slot(h, m_log2_cap);
+        const auto mask = capacity() - 1u;
+        while (m_meta[idx].m_full) {
+            if (m_meta[idx].m_hash == h && m_eq(*key_ptr(idx), k)) {
+                // k is in the table already.
+                return ::std::make_pair(cf_ptr(idx), false);
+            }
+            idx = (idx + 1u) & mask;
+        }
+
+        // k is not in the table. If the insertion
+        // would exceed the max load factor, grow
+        // the table and locate a new free slot.
+        if (obake_unlikely(m_size == max_load(m_log2_cap))) {
+            rehash(m_log2_cap + 1u);
+            idx = find_free_slot(h);
+        }
+
+        // Construct the new term in the free slot.
+        // NOTE: if the functor returns a C prvalue, the coefficient
+        // is constructed directly in the slot.
+        ::new (static_cast<void *>(&m_slots[idx].m_key)) K(k);
+        try {
+            ::new (static_cast<void *>(&m_slots[idx].m_cf)) C(::std::forward<F>(f)());
+        } catch (...) {
+            key_ptr(idx)->~K();
+            throw;
+        }
+
+        // Everything went ok, mark the slot as occupied.
+        m_meta[idx] = meta{h, true};
+        ++m_size;
+
+        return ::std::make_pair(cf_ptr(idx), true);
+    }
+
+    // Destroy all the terms, without releasing memory.
+    void clear() noexcept
+    {
+        const auto cap = capacity();
+        for (size_type i = 0; m_size != 0u && i < cap; ++i) {
+            if (m_meta[i].m_full) {
+                destroy_slot(i);
+            }
+        }
+        assert(m_size == 0u);
+    }
+
+    // Invoke f(k, c) on each term of the table, passing mutable
+    // lvalue references to the key and coefficient (which can thus
+    // be moved away). The table will be empty at the end.
+    // NOTE: if f throws, the table is left in a state in which it can
+    // only be destroyed or cleared.
+    template <typename F>
+    void consume(F &&f)
+    {
+        const auto cap = capacity();
+        for (size_type i = 0; m_size != 0u && i < cap; ++i) {
+            if (m_meta[i].m_full) {
+                f(*key_ptr(i), *cf_ptr(i));
+                destroy_slot(i);
+            }
+        }
+        assert(m_size == 0u);
+    }
+
+private:
+    static constexpr unsigned min_log2_cap = 3;
+
+    // Max number of elements for a given capacity (load factor of 3/4).
+    static size_type max_load(unsigned log2_cap) noexcept
+    {
+        const auto cap = size_type(1) << log2_cap;
+        return cap - cap / 4u;
+    }
+
+    static size_type home_slot(::std::size_t h, unsigned log2_cap) noexcept
+    {
+        // NOTE: Fibonacci hashing, using the top bits.
+        return static_cast<size_type>((static_cast<::std::uint64_t>(h) * 11400714819323198485ull) >> (64u - log2_cap));
+    }
+
+    // Pointers to the key and coefficient stored in the slot s.
+    // NOTE: cast through void * in order to avoid cast-align
+    // warnings from the unsigned char storage.
+    static K *slot_key_ptr(slot &s) noexcept
+    {
+        return ::std::launder(static_cast<K *>(static_cast<void *>(s.m_key)));
+    }
+    static C *slot_cf_ptr(slot &s) noexcept
+    {
+        return ::std::launder(static_cast<C *>(static_cast<void *>(s.m_cf)));
+    }
+
+    K *key_ptr(size_type i) noexcept
+    {
+        return slot_key_ptr(m_slots[i]);
+    }
+    C *cf_ptr(size_type i) noexcept
+    {
+        return slot_cf_ptr(m_slots[i]);
+    }
+
+    void destroy_slot(size_type i) noexcept
+    {
+        assert(m_meta[i].m_full);
+
+        key_ptr(i)->~K();
+        cf_ptr(i)->~C();
+        m_meta[i].m_full = false;
+        --m_size;
+    }
+
+    size_type find_free_slot(::std::size_t h) const noexcept
+    {
+        const auto mask = capacity() - 1u;
+        auto idx = home_slot(h, m_log2_cap);
+        while (m_meta[idx].m_full) {
+            idx = (idx + 1u) & mask;
+        }
+        return idx;
+    }
+
+    // Move the content of the table into new storage
+    // with 2**new_log2_cap slots. If an exception is raised,
+    // the table is left in a valid state (some terms may be
+    // moved-from).
+    void rehash(unsigned new_log2_cap)
+    {
+        assert(new_log2_cap > m_log2_cap);
+        assert(new_log2_cap < static_cast<unsigned>(::std::numeric_limits<size_type>::digits));
+        // NOTE: home_slot() relies on 64-bit multiplication.
+        assert(new_log2_cap <= 64u);
+
+        const auto new_cap = size_type(1) << new_log2_cap;
+        const auto new_mask = new_cap - 1u;
+
+        ::std::unique_ptr<slot[]> new_slots(new slot[new_cap]);
+        ::std::unique_ptr<meta[]> new_meta(new meta[new_cap]);
+        for (size_type i = 0; i < new_cap; ++i) {
+            new_meta[i].m_full = false;
+        }
+
+        const auto old_cap = capacity();
+        try {
+            for (size_type i = 0; i < old_cap; ++i) {
+                if (!m_meta[i].m_full) {
+                    continue;
+                }
+
+                const auto h = m_meta[i].m_hash;
+                auto idx = home_slot(h, new_log2_cap);
+                while (new_meta[idx].m_full) {
+                    idx = (idx + 1u) & new_mask;
+                }
+
+                ::new (static_cast<void *>(&new_slots[idx].m_key)) K(::std::move(*key_ptr(i)));
+                try {
+                    ::new (static_cast<void *>(&new_slots[idx].m_cf)) C(::std::move(*cf_ptr(i)));
+                } catch (...) {
+                    slot_key_ptr(new_slots[idx])->~K();
+                    throw;
+                }
+                new_meta[idx] = meta{h, true};
+            }
+        } catch (...) {
+            // Destroy what was constructed in the new storage. The
+            // (possibly moved-from) terms in the old storage are
+            // still alive and will be handled by the old storage.
+            for (size_type j = 0; j < new_cap; ++j) {
+                if (new_meta[j].m_full) {
+                    slot_key_ptr(new_slots[j])->~K();
+                    slot_cf_ptr(new_slots[j])->~C();
+                }
+            }
+            throw;
+        }
+
+        // Destroy the old terms. This is all noexcept.
+        const auto old_size = m_size;
+        clear();
+
+        m_slots = ::std::move(new_slots);
+        m_meta = ::std::move(new_meta);
+        m_log2_cap = new_log2_cap;
+        m_size = old_size;
+    }
+
+    ::std::unique_ptr<slot[]> m_slots;
+    ::std::unique_ptr<meta[]> m_meta;
+    unsigned m_log2_cap = 0;
+    size_type m_size = 0;
+    Hash m_hasher;
+    Eq m_eq;
+};
+
+} // namespace obake::detail
+
+#endif
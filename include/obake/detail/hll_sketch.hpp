@@ -0,0 +1,121 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_DETAIL_HLL_SKETCH_HPP
+#define OBAKE_DETAIL_HLL_SKETCH_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace obake::detail
+{
+
+// A HyperLogLog sketch for the estimation of the number
+// of distinct elements in a multiset. See:
+//
+// Flajolet et al., "HyperLogLog: the analysis of a near-optimal
+// cardinality estimation algorithm", 2007,
+//
+// with the linear counting correction for small cardinalities
+// from Heule et al., "HyperLogLog in practice", 2013.
+//
+// The elements are added to the sketch via their hash values.
+// The hash values are remixed internally, so that poor hashes
+// (e.g., the homomorphic hashes of the monomials) can be used.
+// The standard error of the estimate is about 1.04 / sqrt(2**P).
+template <unsigned P = 12>
+class hll_sketch
+{
+    static_assert(P >= 4u && P <= 18u);
+
+    static constexpr ::std::size_t n_regs = ::std::size_t(1) << P;
+
+public:
+    hll_sketch() : m_regs(n_regs) {}
+
+    // Add an element with hash value h.
+    void add(::std::uint64_t h)
+    {
+        h = mix(h);
+
+        // The top P bits select the register.
+        const auto idx = static_cast<::std::size_t>(h >> (64u - P));
+
+        // The rank is the position of the leftmost
+        // 1 bit in the remaining bits.
+        auto w = h << P;
+        unsigned char rank = 1;
+        if (w == 0u) {
+            rank = static_cast<unsigned char>(64u - P + 1u);
+        } else {
+            for (; (w & (::std::uint64_t(1) << 63)) == 0u; w <<= 1) {
+                ++rank;
+            }
+        }
+
+        m_regs[idx] = ::std::max(m_regs[idx], rank);
+    }
+
+    // Merge the content of other into this.
+    void merge(const hll_sketch &other)
+    {
+        assert(m_regs.size() == other.m_regs.size());
+
+        for (::std::size_t i = 0; i < n_regs; ++i) {
+            m_regs[i] = ::std::max(m_regs[i], other.m_regs[i]);
+        }
+    }
+
+    // Estimate the number of distinct elements.
+    double estimate() const
+    {
+        constexpr auto m = static_cast<double>(n_regs);
+        constexpr auto alpha = 0.7213 / (1 + 1.079 / m);
+
+        double sum = 0;
+        ::std::size_t n_zeros = 0;
+        for (const auto &r : m_regs) {
+            sum += ::std::ldexp(1., -static_cast<int>(r));
+            n_zeros += static_cast<::std::size_t>(r == 0u);
+        }
+
+        const auto est = alpha * m * m / sum;
+
+        if (est <= 2.5 * m && n_zeros != 0u) {
+            // Small cardinality: use linear counting.
+            return m * ::std::log(m / static_cast<double>(n_zeros));
+        }
+
+        // NOTE: with 64-bit hashes there is no need
+        // for a large cardinality correction.
+        return est;
+    }
+
+private:
+    // The finalizer of splitmix64.
+    static ::std::uint64_t mix(::std::uint64_t h)
+    {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+
+        return h;
+    }
+
+    ::std::vector<unsigned char> m_regs;
+};
+
+} // namespace obake::detail
+
+#endif
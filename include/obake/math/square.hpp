@@ -0,0 +1,96 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_MATH_SQUARE_HPP
+#define OBAKE_MATH_SQUARE_HPP
+
+#include <type_traits>
+#include <utility>
+
+#include <obake/config.hpp>
+#include <obake/detail/priority_tag.hpp>
+#include <obake/detail/ss_func_forward.hpp>
+#include <obake/type_traits.hpp>
+
+namespace obake
+{
+
+namespace customisation
+{
+
+// External customisation point for obake::square().
+struct square_t {
+};
+
+namespace internal
+{
+
+// Internal customisation point for obake::square().
+struct square_t {
+};
+
+} // namespace internal
+
+} // namespace customisation
+
+namespace detail
+{
+
+// Highest priority: explicit user override in the external customisation namespace.
+template <typename T>
+constexpr auto square_impl(T &&x, priority_tag<3>)
+    OBAKE_SS_FORWARD_FUNCTION(square(customisation::square_t{}, ::std::forward<T>(x)));
+
+// Unqualified function call implementation.
+template <typename T>
+constexpr auto square_impl(T &&x, priority_tag<2>) OBAKE_SS_FORWARD_FUNCTION(square(::std::forward<T>(x)));
+
+// Explicit override in the internal customisation namespace.
+template <typename T>
+constexpr auto square_impl(T &&x, priority_tag<1>)
+    OBAKE_SS_FORWARD_FUNCTION(square(customisation::internal::square_t{}, ::std::forward<T>(x)));
+
+// Lowest-priority: implementation based on the multiplication
+// of x by itself.
+// NOTE: x is passed as the same const lvalue reference to both
+// sides of the multiplication. This allows the multiplication
+// operator to detect squaring (e.g., polynomial multiplication
+// switches to a dedicated squaring kernel in such case).
+template <typename T>
+constexpr auto square_impl(T &&x, priority_tag<0>)
+    OBAKE_SS_FORWARD_FUNCTION(static_cast<const ::std::remove_reference_t<T> &>(x)
+                              * static_cast<const ::std::remove_reference_t<T> &>(x));
+
+} // namespace detail
+
+inline constexpr auto square = [](auto &&x)
+    OBAKE_SS_FORWARD_LAMBDA(detail::square_impl(::std::forward<decltype(x)>(x), detail::priority_tag<3>{}));
+
+namespace detail
+{
+
+template <typename T>
+using square_t = decltype(::obake::square(::std::declval<T>()));
+
+}
+
+template <typename T>
+using is_squarable = is_detected<detail::square_t, T>;
+
+template <typename T>
+inline constexpr bool is_squarable_v = is_squarable<T>::value;
+
+template <typename T>
+concept Squarable = requires(T &&x)
+{
+    ::obake::square(::std::forward<T>(x));
+};
+
+} // namespace obake
+
+#endif
@@ -0,0 +1,313 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_POLYNOMIALS_EVALUATOR_HPP
+#define OBAKE_POLYNOMIALS_EVALUATOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <obake/config.hpp>
+#include <obake/detail/to_string.hpp>
+#include <obake/exceptions.hpp>
+#include <obake/math/pow.hpp>
+#include <obake/math/safe_cast.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/series.hpp>
+#include <obake/symbols.hpp>
+#include <obake/type_traits.hpp>
+
+namespace obake
+{
+
+namespace polynomials::detail
+{
+
+// Metaprogramming for the selection of the
+// evaluation algorithm of polynomial_evaluator.
+// K and C are the key and coefficient types of the
+// polynomial, U the type of the values of the variables.
+template <typename K, typename C, typename U>
+constexpr auto evaluator_algorithm_impl()
+{
+    [[maybe_unused]] constexpr auto failure = ::std::make_pair(0, ::obake::detail::type_c<void>{});
+
+    // NOTE: the coefficients are stored and used as-is
+    // in the evaluation, thus we cannot support coefficients
+    // which would need to be evaluated in turn.
+    if constexpr (::std::disjunction_v<is_cvr_series<C>, ::std::negation<is_detected<poly_unpack_exp_t, K>>>) {
+        return failure;
+    } else if constexpr (!is_exponentiable_v<const U &, const poly_unpack_exp_t<K> &>) {
+        return failure;
+    } else {
+        // The type of the evaluation of the monomials.
+        using key_eval_t = ::obake::detail::pow_t<const U &, const poly_unpack_exp_t<K> &>;
+        // The return type.
+        using ret_t = detected_t<::obake::detail::mul_t, const key_eval_t &, const C &>;
+
+        if constexpr (::std::conjunction_v<
+                          ::std::is_constructible<key_eval_t, int>,
+                          is_in_place_multipliable<::std::add_lvalue_reference_t<key_eval_t>, const key_eval_t &>,
+                          is_semi_regular<key_eval_t>,
+                          // NOTE: these will also verify that ret_t is detected.
+                          is_in_place_addable<::std::add_lvalue_reference_t<ret_t>, ret_t>,
+                          ::std::is_constructible<ret_t, int>, is_semi_regular<ret_t>, is_returnable<ret_t>,
+                          ::std::is_copy_constructible<U>>) {
+            return ::std::make_pair(1, ::obake::detail::type_c<ret_t>{});
+        } else {
+            return failure;
+        }
+    }
+}
+
+template <typename K, typename C, typename U>
+inline constexpr auto evaluator_algorithm = detail::evaluator_algorithm_impl<K, C, U>();
+
+template <typename K, typename C, typename U>
+inline constexpr int evaluator_algo = evaluator_algorithm<K, C, U>.first;
+
+template <typename K, typename C, typename U>
+using evaluator_ret_t = typename decltype(evaluator_algorithm<K, C, U>.second)::type;
+
+} // namespace polynomials::detail
+
+// A polynomial flattened for repeated numerical evaluation.
+//
+// At construction, the exponents of the monomials are unpacked
+// once and for all. For each variable, the distinct nonzero exponents
+// are collected, and each term is represented as a list of indices into
+// a table of powers (in compressed sparse row format: the zero exponents
+// are not stored), plus the coefficient.
+//
+// The evaluation is done on batches of points. For each batch, the table
+// of the powers of each variable is computed first (one exponentiation
+// per variable, distinct exponent and point), and then the terms are
+// accumulated with the points in the innermost loop. For C++ arithmetic
+// types the inner loops operate on contiguous arrays and they can thus be
+// vectorised by the compiler. The batches are processed in parallel.
+//
+// For each point, the terms are summed serially, in the same order
+// as in the serial implementation of obake::evaluate(). For floating-point
+// types, the results are thus equal to those of obake::evaluate() only up
+// to the summation order: large segmented polynomials are evaluated by
+// obake::evaluate() via a parallel reduction over the segments (which may
+// also be compensated, see set_evaluate_compensated()), and the compiler
+// may contract floating-point operations differently.
+template <typename K, typename C>
+class polynomial_evaluator
+{
+    using exp_t = polynomials::detail::poly_unpack_exp_t<K>;
+
+public:
+    using size_type = ::std::size_t;
+
+    // Number of points in a batch.
+    static constexpr size_type batch_size = 64;
+
+    explicit polynomial_evaluator(const polynomial<K, C> &p) : m_ss(p.get_symbol_set())
+    {
+        // NOTE: because the keys are compatible with the symbol set,
+        // the static cast is safe.
+        const auto nv = static_cast<unsigned>(m_ss.size());
+
+        const auto nt = ::obake::safe_cast<size_type>(p.size());
+        m_cfs.reserve(nt);
+
+        // Unpack all the exponents and copy the coefficients.
+        // NOTE: the terms are iterated in the same order
+        // as in the serial implementation of obake::evaluate().
+        ::std::vector<exp_t> all_exps;
+        all_exps.resize(::obake::safe_cast<decltype(all_exps.size())>(nt * nv));
+        {
+            auto out = all_exps.data();
+            for (const auto &t : p) {
+                polynomials::detail::poly_unpack_traits<K>::unpack(t.first, nv, out);
+                out += nv;
+                m_cfs.push_back(t.second);
+            }
+        }
+
+        // Determine the distinct nonzero exponents of each variable.
+        m_exp_offsets.push_back(0);
+        using diff_t = decltype(m_exps.end() - m_exps.begin());
+        for (auto v = 0u; v < nv; ++v) {
+            const auto cur_begin = m_exps.size();
+            for (size_type t = 0; t < nt; ++t) {
+                const auto &e = all_exps[t * nv + v];
+                if (e != exp_t(0)) {
+                    m_exps.push_back(e);
+                }
+            }
+            ::std::sort(m_exps.begin() + static_cast<diff_t>(cur_begin), m_exps.end());
+            m_exps.erase(::std::unique(m_exps.begin() + static_cast<diff_t>(cur_begin), m_exps.end()), m_exps.end());
+            m_exp_offsets.push_back(m_exps.size());
+        }
+
+        // Build the row indices of the terms.
+        m_term_offsets.reserve(nt + 1u);
+        m_term_offsets.push_back(0);
+        for (size_type t = 0; t < nt; ++t) {
+            for (auto v = 0u; v < nv; ++v) {
+                const auto &e = all_exps[t * nv + v];
+                if (e == exp_t(0)) {
+                    continue;
+                }
+
+                const auto b = m_exps.begin() + static_cast<diff_t>(m_exp_offsets[v]);
+                const auto end = m_exps.begin() + static_cast<diff_t>(m_exp_offsets[v + 1u]);
+                const auto it = ::std::lower_bound(b, end, e);
+                assert(it != end && *it == e);
+
+                m_rows.push_back(static_cast<size_type>(it - m_exps.begin()));
+            }
+            m_term_offsets.push_back(m_rows.size());
+        }
+    }
+
+    const symbol_set &get_symbol_set() const noexcept
+    {
+        return m_ss;
+    }
+    size_type get_n_terms() const noexcept
+    {
+        return m_cfs.size();
+    }
+
+    // Evaluate at a single point, with the values
+    // of the variables provided in the map sm.
+    template <typename U>
+    requires(polynomials::detail::evaluator_algo<K, C, U> != 0) polynomials::detail::evaluator_ret_t<K, C, U>
+    operator()(const symbol_map<U> &sm) const
+    {
+        ::std::vector<U> pt;
+        pt.reserve(m_ss.size());
+        for (const auto &s : m_ss) {
+            const auto it = sm.find(s);
+            if (obake_unlikely(it == sm.end())) {
+                obake_throw(::std::invalid_argument,
+                            "Cannot evaluate a polynomial: the evaluation map does not contain the symbol '" + s
+                                + "', which is in the polynomial's symbol set, " + ::obake::detail::to_string(m_ss));
+            }
+            pt.push_back(it->second);
+        }
+
+        polynomials::detail::evaluator_ret_t<K, C, U> retval(0);
+        (*this)(pt.data(), 1, &retval);
+
+        return retval;
+    }
+
+    // Evaluate at n points. The values of the variables are read from pts:
+    // the values for the point i are stored starting at pts + i * m, where m
+    // is the number of variables, in the order of the symbol set. The
+    // results are written into out.
+    template <typename U>
+    requires(polynomials::detail::evaluator_algo<K, C, U> != 0) void operator()(
+        const U *pts, size_type n, polynomials::detail::evaluator_ret_t<K, C, U> *out) const
+    {
+        using key_eval_t = ::obake::detail::pow_t<const U &, const exp_t &>;
+        using ret_t = polynomials::detail::evaluator_ret_t<K, C, U>;
+
+        const auto nv = m_ss.size();
+        const auto nt = m_cfs.size();
+        const auto n_batches = n / batch_size + static_cast<size_type>(n % batch_size != 0u);
+
+        ::tbb::parallel_for(::tbb::blocked_range<size_type>(0, n_batches), [&](const auto &range) {
+            // The table of powers, the products of the powers
+            // for a single term and the accumulators.
+            ::std::vector<key_eval_t> pw;
+            pw.resize(::obake::safe_cast<decltype(pw.size())>(m_exps.size() * batch_size));
+            ::std::vector<key_eval_t> tmp;
+            tmp.resize(batch_size);
+            ::std::vector<ret_t> acc;
+            acc.resize(batch_size);
+
+            for (auto bidx = range.begin(); bidx != range.end(); ++bidx) {
+                const auto b0 = bidx * batch_size;
+                const auto nb = ::std::min(batch_size, n - b0);
+
+                // Compute the table of powers.
+                for (size_type v = 0; v < nv; ++v) {
+                    for (auto r = m_exp_offsets[v]; r < m_exp_offsets[v + 1u]; ++r) {
+                        const auto &e = m_exps[r];
+                        const auto row = pw.data() + r * batch_size;
+                        for (size_type b = 0; b < nb; ++b) {
+                            row[b] = ::obake::pow(pts[(b0 + b) * nv + v], e);
+                        }
+                    }
+                }
+
+                for (size_type b = 0; b < nb; ++b) {
+                    acc[b] = ret_t(0);
+                }
+
+                // Accumulate the terms.
+                for (size_type t = 0; t < nt; ++t) {
+                    for (size_type b = 0; b < nb; ++b) {
+                        tmp[b] = key_eval_t(1);
+                    }
+
+                    for (auto i = m_term_offsets[t]; i < m_term_offsets[t + 1u]; ++i) {
+                        const auto row = pw.data() + m_rows[i] * batch_size;
+                        for (size_type b = 0; b < nb; ++b) {
+                            tmp[b] *= ::std::as_const(row[b]);
+                        }
+                    }
+
+                    const auto &c = m_cfs[t];
+                    for (size_type b = 0; b < nb; ++b) {
+                        acc[b] += ::std::as_const(tmp[b]) * c;
+                    }
+                }
+
+                for (size_type b = 0; b < nb; ++b) {
+                    out[b0 + b] = ::std::move(acc[b]);
+                }
+            }
+        });
+    }
+
+private:
+    symbol_set m_ss;
+    // The coefficients.
+    ::std::vector<C> m_cfs;
+    // The distinct nonzero exponents of each variable:
+    // the exponents of the variable v are in the
+    // [m_exp_offsets[v], m_exp_offsets[v + 1]) range
+    // of m_exps. The position of an exponent in m_exps
+    // is the row of the power in the table of powers.
+    ::std::vector<exp_t> m_exps;
+    ::std::vector<size_type> m_exp_offsets;
+    // The rows of the table of powers for each term:
+    // the rows of the term t are in the
+    // [m_term_offsets[t], m_term_offsets[t + 1]) range
+    // of m_rows.
+    ::std::vector<size_type> m_rows;
+    ::std::vector<size_type> m_term_offsets;
+};
+
+// Create an evaluator for the polynomial p.
+template <typename K, typename C>
+requires(!is_cvr_series_v<C>) && is_detected_v<polynomials::detail::poly_unpack_exp_t, K> inline polynomial_evaluator<
+    K, C> make_evaluator(const polynomial<K, C> &p)
+{
+    return polynomial_evaluator<K, C>(p);
+}
+
+} // namespace obake
+
+#endif
@@ -12,11 +12,16 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <initializer_list>
+#include <limits>
+#include <map>
+#include <memory>
 #include <numeric>
+#include <optional>
 #include <random>
 #include <stdexcept>
 #include <string>
@@ -32,26 +37,33 @@
 #include <boost/serialization/tracking.hpp>
 
 #include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_invoke.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
 
 #include <mp++/integer.hpp>
 
 #include <obake/byte_size.hpp>
 #include <obake/config.hpp>
 #include <obake/detail/abseil.hpp>
+#include <obake/detail/acc_table.hpp>
 #include <obake/detail/hc.hpp>
+#include <obake/detail/hll_sketch.hpp>
 #include <obake/detail/ignore.hpp>
 #include <obake/detail/it_diff_check.hpp>
+#include <obake/detail/limits.hpp>
 #include <obake/detail/make_array.hpp>
 #include <obake/detail/ss_func_forward.hpp>
 #include <obake/detail/to_string.hpp>
 #include <obake/detail/type_c.hpp>
+#include <obake/detail/visibility.hpp>
 #include <obake/detail/xoroshiro128_plus.hpp>
 #include <obake/exceptions.hpp>
 #include <obake/hash.hpp>
+#include <obake/kpack.hpp>
 #include <obake/key/key_merge_symbols.hpp>
 #include <obake/math/diff.hpp>
 #include <obake/math/fma3.hpp>
@@ -59,6 +71,7 @@
 #include <obake/math/pow.hpp>
 #include <obake/math/safe_cast.hpp>
 #include <obake/math/subs.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
 #include <obake/polynomials/monomial_diff.hpp>
 #include <obake/polynomials/monomial_homomorphic_hash.hpp>
 #include <obake/polynomials/monomial_integrate.hpp>
@@ -66,6 +79,7 @@
 #include <obake/polynomials/monomial_pow.hpp>
 #include <obake/polynomials/monomial_range_overflow_check.hpp>
 #include <obake/polynomials/monomial_subs.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
 #include <obake/ranges.hpp>
 #include <obake/s11n.hpp>
 #include <obake/series.hpp>
@@ -83,6 +97,181 @@ struct tag {
     }
 };
 
+// The engines available for polynomial multiplication.
+enum class mul_engine {
+    // Automatic selection based on the
+    // operands' sizes and on the key type.
+    automatic,
+    // Simple single-threaded implementation.
+    simple,
+    // Multi-threaded implementation based on
+    // segmented hash tables.
+    hash,
+    // Multi-threaded implementation based on
+    // dense arrays (packed monomials only, it falls
+    // back to hash if the product is not dense enough).
+    dense,
+    // Single-threaded heap-based implementation
+    // producing the terms in order with bounded
+    // memory usage (packed monomials only, it falls
+    // back to automatic selection for other keys).
+    heap
+};
+
+// The estimators of the number of terms in a product
+// used by the multi-threaded engines.
+enum class mul_estimator {
+    // Random sampling of term-by-term products.
+    sampling,
+    // Streaming of the term-by-term products (or of a
+    // subset of them) through a HyperLogLog sketch.
+    sketch
+};
+
+// Tunable parameters for polynomial multiplication.
+// The default values are derived from the sizes
+// of the data caches detected at runtime.
+struct mul_policy {
+    // The engine used in polynomial multiplication.
+    mul_engine engine = mul_engine::automatic;
+    // The operand byte size below which the automatic
+    // engine selection runs the simple implementation.
+    ::std::size_t simple_threshold = 0;
+    // The target segment sizes (in bytes) of the
+    // multi-threaded hash-based engine for sparse
+    // and dense products.
+    ::std::size_t sparse_seg_size = 0;
+    ::std::size_t dense_seg_size = 0;
+    // The estimated sparsity (i.e., the ratio between the
+    // number of terms in the product and the number of
+    // term-by-term multiplications) at or above which
+    // a product is considered sparse.
+    double sparsity_threshold = 0;
+    // The estimator of the number of terms in a product.
+    mul_estimator estimator = mul_estimator::sampling;
+    // The max number of term-by-term products streamed
+    // through the sketch by the sketch-based estimator.
+    ::std::size_t sketch_max_mults = 0;
+};
+
+// Statistics about the last polynomial
+// multiplication performed by the calling thread.
+struct mul_stats {
+    // The engine which was used.
+    mul_engine engine = mul_engine::automatic;
+    // The multiplication policy which was used.
+    mul_policy policy;
+    // The target segment size (in bytes) which was used
+    // (multi-threaded hash-based and dense engines only).
+    ::std::size_t seg_size = 0;
+    // The estimated number of terms in the product, and
+    // the time (in seconds) spent computing the estimate
+    // (multi-threaded hash-based and dense engines only).
+    ::std::size_t est_n_terms = 0;
+    double est_time = 0;
+    // The number of terms in the product.
+    ::std::size_t n_terms = 0;
+    // The number of segments in the product
+    // (multi-threaded hash-based engine only).
+    ::std::size_t n_segments = 0;
+    // The load imbalance (multi-threaded hash-based engine only):
+    // the ratio between the maximum and the average time spent
+    // processing segments by the worker tasks, computed only over
+    // the tasks which processed at least one segment. A value of 1
+    // signals a perfectly balanced workload, a value of n signals
+    // that one task was busy n times longer than the average.
+    // The tasks which found no work left (e.g., because fewer
+    // threads than tasks were available) do not contribute.
+    double load_imbalance = 0;
+};
+
+namespace detail
+{
+
+OBAKE_DLL_PUBLIC mul_stats &mul_stats_tls();
+
+OBAKE_DLL_PUBLIC mul_policy default_mul_policy();
+OBAKE_DLL_PUBLIC void check_mul_policy(const mul_policy &);
+OBAKE_DLL_PUBLIC mul_policy get_global_mul_policy();
+OBAKE_DLL_PUBLIC void set_global_mul_policy(const mul_policy &);
+OBAKE_DLL_PUBLIC ::std::optional<mul_policy> &mul_policy_tls();
+
+} // namespace detail
+
+// Fetch the statistics about the last polynomial
+// multiplication performed by the calling thread.
+inline constexpr auto get_last_mul_stats = []() { return detail::mul_stats_tls(); };
+
+// Get the default multiplication policy
+// (i.e., the one derived from the cache sizes).
+inline constexpr auto get_default_mul_policy = []() { return detail::default_mul_policy(); };
+
+// Get the multiplication policy in use in the calling thread,
+// i.e., the policy installed by the innermost mul_policy_guard
+// in the calling thread, if any, or the global policy otherwise.
+inline constexpr auto get_mul_policy = []() {
+    const auto &p = detail::mul_policy_tls();
+
+    return p ? *p : detail::get_global_mul_policy();
+};
+
+// Set/reset the global multiplication policy.
+inline constexpr auto set_mul_policy = [](const mul_policy &p) { detail::set_global_mul_policy(p); };
+inline constexpr auto reset_mul_policy = []() { detail::set_global_mul_policy(detail::default_mul_policy()); };
+
+// Install a multiplication policy in the calling thread
+// for the lifetime of the guard, overriding the global
+// policy. Guards can be nested.
+class mul_policy_guard
+{
+public:
+    explicit mul_policy_guard(const mul_policy &p) : m_old(detail::mul_policy_tls())
+    {
+        detail::check_mul_policy(p);
+        detail::mul_policy_tls() = p;
+    }
+    mul_policy_guard(const mul_policy_guard &) = delete;
+    mul_policy_guard(mul_policy_guard &&) = delete;
+    mul_policy_guard &operator=(const mul_policy_guard &) = delete;
+    mul_policy_guard &operator=(mul_policy_guard &&) = delete;
+    ~mul_policy_guard()
+    {
+        detail::mul_policy_tls() = m_old;
+    }
+
+private:
+    ::std::optional<mul_policy> m_old;
+};
+
+namespace detail
+{
+
+// Run f() over the range r via tbb::parallel_for(). An optional
+// partitioner can be passed as last argument, and it will be
+// forwarded to tbb::parallel_for().
+// NOTE: f() may perform multiplications, which would use
+// the global policy in the worker threads. Capture the policy
+// of the calling thread and install it in the worker threads,
+// so that the whole operation is run with the same policy.
+template <typename Range, typename F, typename... P>
+inline void poly_par_for(const Range &r, const F &f, P &&...part)
+{
+    static_assert(sizeof...(P) <= 1u);
+
+    const auto pol = ::obake::polynomials::get_mul_policy();
+
+    ::tbb::parallel_for(
+        r,
+        [&pol, &f](const Range &sr) {
+            const ::obake::polynomials::mul_policy_guard pg(pol);
+
+            f(sr);
+        },
+        part...);
+}
+
+} // namespace detail
+
 } // namespace obake::polynomials
 
 // Disable tracking for the polynomial tag.
@@ -232,6 +421,45 @@ namespace polynomials
 namespace detail
 {
 
+// Traits for the unpacking of the exponents of monomials:
+// the exponent type and a function to unpack the exponents
+// of a monomial with n variables into out.
+template <typename>
+struct poly_unpack_traits {
+};
+
+template <typename T>
+struct poly_unpack_traits<packed_monomial<T>> {
+    using exp_t = T;
+
+    static void unpack(const packed_monomial<T> &p, unsigned n, T *out)
+    {
+        kunpacker<T> ku(p.get_value(), n);
+        for (auto i = 0u; i < n; ++i) {
+            ku >> out[i];
+        }
+    }
+};
+
+template <typename T, unsigned PSize>
+struct poly_unpack_traits<d_packed_monomial<T, PSize>> {
+    using exp_t = T;
+
+    static void unpack(const d_packed_monomial<T, PSize> &d, unsigned n, T *out)
+    {
+        auto i = 0u;
+        for (const auto &v : d._container()) {
+            kunpacker<T> ku(v, PSize);
+            for (auto j = 0u; j < PSize && i < n; ++j, ++i) {
+                ku >> out[i];
+            }
+        }
+    }
+};
+
+template <typename K>
+using poly_unpack_exp_t = typename poly_unpack_traits<K>::exp_t;
+
 // Small helper to create a vector of indices
 // into the input vector v, in parallel using TBB.
 template <typename V>
@@ -252,6 +480,43 @@ inline auto poly_mul_impl_par_make_idx_vector(const V &v)
     return ret;
 }
 
+// Small helper to create a vector of pointers to
+// the terms of the series x. The vector is filled in
+// parallel, one table of x at a time.
+template <typename T>
+inline auto poly_mul_impl_par_make_ptr_vector(const T &x)
+{
+    const auto &s_table = x._get_s_table();
+
+    ::std::vector<const series_term_t<T> *> ret;
+    ret.resize(::obake::safe_cast<decltype(ret.size())>(x.size()));
+
+    // Compute the offset of each table in ret.
+    // NOTE: no overflow is possible here, since
+    // the total size of x is representable by
+    // the size type of ret.
+    ::std::vector<decltype(ret.size())> offsets;
+    offsets.reserve(::obake::safe_cast<decltype(offsets.size())>(s_table.size()));
+    decltype(ret.size()) cur_offset = 0;
+    for (const auto &tab : s_table) {
+        offsets.push_back(cur_offset);
+        cur_offset += static_cast<decltype(ret.size())>(tab.size());
+    }
+    assert(cur_offset == ret.size());
+
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(s_table.size())>(0, s_table.size()),
+                        [&ret, &s_table, &offsets](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                auto out = ret.data() + offsets[static_cast<decltype(offsets.size())>(i)];
+                                for (const auto &t : s_table[i]) {
+                                    *out++ = &t;
+                                }
+                            }
+                        });
+
+    return ret;
+}
+
 // Helper to prepare the variables that will hold the degree
 // data used during polynomial multiplication. In untruncated
 // multiplication, an empty tuple will be returned, otherwise
@@ -289,6 +554,165 @@ inline auto poly_mul_impl_prepare_degree_data([[maybe_unused]] const V1 &v1, [[m
     }
 }
 
+// Helper to compute the (partial) degrees of the terms of the
+// series of type T whose pointers are stored in the input vector v.
+// In untruncated multiplication, an empty tuple will be returned.
+template <typename T, typename V, typename... Args>
+inline auto poly_mul_impl_make_degree_vector([[maybe_unused]] const V &v, [[maybe_unused]] const symbol_set &ss,
+                                             [[maybe_unused]] const Args &...args)
+{
+    if constexpr (sizeof...(Args) == 0u) {
+        // Untruncated case, return an empty tuple.
+        return ::std::make_tuple();
+    } else {
+        // NOTE: in the make_(p_)degree_vector() helpers we need
+        // to compute the size of v via iterator differences.
+        ::obake::detail::container_it_diff_check(v);
+
+        if constexpr (sizeof...(Args) == 1u) {
+            // Total degree.
+            return customisation::internal::make_degree_vector<T>(v.cbegin(), v.cend(), ss, true);
+        } else {
+            // Partial degree.
+            static_assert(sizeof...(Args) == 2u);
+
+            return customisation::internal::make_p_degree_vector<T>(
+                v.cbegin(), v.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), true);
+        }
+    }
+}
+
+// Helper to select, from the vector v of pointers to terms,
+// a subset of terms which is sufficient to run the monomial
+// overflow check in place of the whole vector. The subset contains,
+// for each variable, the terms with the minimum and maximum
+// exponent, and the terms with the minimum and maximum degree.
+// Because the overflow check depends only on these limits, its
+// outcome is not altered. If the key type does not support
+// the unpacking of the exponents, v is returned unchanged.
+template <typename P>
+inline ::std::vector<const P *> poly_mul_impl_overflow_subset(const ::std::vector<const P *> &v,
+                                                              const symbol_set &ss)
+{
+    using key_t = remove_cvref_t<typename P::first_type>;
+
+    if constexpr (is_detected_v<poly_unpack_exp_t, key_t>) {
+        using exp_t = poly_unpack_exp_t<key_t>;
+        using idx_t = decltype(v.size());
+        using int_t = ::mppp::integer<1>;
+
+        // NOTE: because the keys are compatible with the symbol set,
+        // the static cast is safe.
+        const auto nv = static_cast<unsigned>(ss.size());
+
+        // NOTE: the subset would not be smaller
+        // than v, just return a copy of v.
+        if (v.size() <= 2u * (static_cast<idx_t>(nv) + 1u)) {
+            return v;
+        }
+
+        // The current exponents, the min/max exponents
+        // and the indices of the terms in which they appear.
+        ::std::vector<exp_t> cur, mins, maxs;
+        cur.resize(static_cast<decltype(cur.size())>(nv));
+        poly_unpack_traits<key_t>::unpack(v[0]->first, nv, cur.data());
+        mins = cur;
+        maxs = cur;
+        ::std::vector<idx_t> min_idx(static_cast<decltype(min_idx.size())>(nv), 0),
+            max_idx(static_cast<decltype(max_idx.size())>(nv), 0);
+
+        // The current degree, the min/max degrees and
+        // the indices of the terms in which they appear.
+        int_t d, min_d, max_d;
+        for (const auto &e : cur) {
+            d += e;
+        }
+        min_d = d;
+        max_d = d;
+        idx_t min_d_idx = 0, max_d_idx = 0;
+
+        for (idx_t i = 1; i < v.size(); ++i) {
+            poly_unpack_traits<key_t>::unpack(v[i]->first, nv, cur.data());
+
+            d = 0;
+            for (auto j = 0u; j < nv; ++j) {
+                const auto &e = cur[j];
+
+                if (e < mins[j]) {
+                    mins[j] = e;
+                    min_idx[j] = i;
+                }
+                if (e > maxs[j]) {
+                    maxs[j] = e;
+                    max_idx[j] = i;
+                }
+
+                d += e;
+            }
+
+            if (d < min_d) {
+                min_d = d;
+                min_d_idx = i;
+            }
+            if (d > max_d) {
+                max_d = d;
+                max_d_idx = i;
+            }
+        }
+
+        // Assemble the subset, removing duplicates.
+        ::std::vector<idx_t> sub_idx(min_idx);
+        sub_idx.insert(sub_idx.end(), max_idx.begin(), max_idx.end());
+        sub_idx.push_back(min_d_idx);
+        sub_idx.push_back(max_d_idx);
+        ::std::sort(sub_idx.begin(), sub_idx.end());
+        sub_idx.erase(::std::unique(sub_idx.begin(), sub_idx.end()), sub_idx.end());
+
+        ::std::vector<const P *> ret;
+        ret.reserve(sub_idx.size());
+        for (const auto &i : sub_idx) {
+            ret.push_back(v[i]);
+        }
+
+        return ret;
+    } else {
+        ::obake::detail::ignore(ss);
+
+        return v;
+    }
+}
+
+// The data about an operand of type T of a (possibly truncated)
+// polynomial multiplication which does not depend on the other operand.
+// It can be computed once via poly_mul_impl_make_operand_data() and
+// then reused in several multiplications by the same operand
+// (see poly_mul_many_impl()).
+template <typename T, typename... Args>
+struct poly_mul_operand_data {
+    // Pointers to the terms of the operand.
+    ::std::vector<const series_term_t<T> *> v;
+    // The degrees of the terms in v (an empty
+    // tuple in untruncated multiplication).
+    decltype(detail::poly_mul_impl_make_degree_vector<T>(v, ::std::declval<const symbol_set &>(),
+                                                         ::std::declval<const Args &>()...)) degrees;
+    // The subset of v for the monomial overflow check.
+    ::std::vector<const series_term_t<T> *> ov;
+};
+
+template <typename T, typename... Args>
+inline poly_mul_operand_data<T, Args...> poly_mul_impl_make_operand_data(const T &x, const Args &...args)
+{
+    const auto &ss = x.get_symbol_set();
+
+    poly_mul_operand_data<T, Args...> ret;
+    ret.v = detail::poly_mul_impl_par_make_ptr_vector(x);
+    ::tbb::parallel_invoke(
+        [&ret, &ss, &args...]() { ret.degrees = detail::poly_mul_impl_make_degree_vector<T>(ret.v, ss, args...); },
+        [&ret, &ss]() { ret.ov = detail::poly_mul_impl_overflow_subset(ret.v, ss); });
+
+    return ret;
+}
+
 // Small helper to extract a const reference to
 // a term's key (that is, the first element of the
 // input pair p).
@@ -307,6 +731,36 @@ struct poly_term_key_ref_extractor {
     }
 };
 
+// Small helper to fetch a const reference to a term
+// from either a term or a pointer to a term. This allows
+// the multiplication helpers below to operate both
+// on vectors of terms and on vectors of pointers to terms.
+template <typename P>
+constexpr const P &poly_mul_impl_term_ref(const P &p) noexcept
+{
+    return p;
+}
+
+template <typename P>
+constexpr const P &poly_mul_impl_term_ref(const P *p) noexcept
+{
+    return *p;
+}
+
+// The term type corresponding to the element
+// type E of a vector of terms or of pointers to terms.
+template <typename E>
+using poly_mul_impl_term_t
+    = remove_cvref_t<decltype(detail::poly_mul_impl_term_ref(::std::declval<const E &>()))>;
+
+// The key and coefficient types of the term type
+// corresponding to the element type E.
+template <typename E>
+using poly_mul_impl_key_t = ::std::remove_const_t<typename poly_mul_impl_term_t<E>::first_type>;
+
+template <typename E>
+using poly_mul_impl_cf_t = typename poly_mul_impl_term_t<E>::second_type;
+
 // Meta-programming for selecting the algorithm and the return
 // type of polynomial-like multiplication.
 template <typename T, typename U>
@@ -387,8 +841,8 @@ template <typename RetCf, typename T1, typename T2>
 inline ::std::size_t poly_mul_impl_estimate_average_term_size(const ::std::vector<T1> &v1, const ::std::vector<T2> &v2,
                                                               const symbol_set &ss)
 {
-    using ret_key_t = typename T1::first_type;
-    static_assert(::std::is_same_v<ret_key_t, typename T2::first_type>);
+    using ret_key_t = poly_mul_impl_key_t<T1>;
+    static_assert(::std::is_same_v<ret_key_t, poly_mul_impl_key_t<T2>>);
 
     // Compute the padding in the term class.
     constexpr auto pad_size = sizeof(series_term_t<polynomial<ret_key_t, RetCf>>) - (sizeof(RetCf) + sizeof(ret_key_t));
@@ -424,8 +878,10 @@ inline ::std::size_t poly_mul_impl_estimate_average_term_size(const ::std::vecto
         const auto idx2 = dist2(rng);
 
         // Multiply monomial and coefficient.
-        ::obake::monomial_mul(tmp_key, v1[idx1].first, v2[idx2].first, ss);
-        const auto tmp_cf = v1[idx1].second * v2[idx2].second;
+        const auto &t1 = detail::poly_mul_impl_term_ref(v1[idx1]);
+        const auto &t2 = detail::poly_mul_impl_term_ref(v2[idx2]);
+        ::obake::monomial_mul(tmp_key, t1.first, t2.first, ss);
+        const auto tmp_cf = t1.second * t2.second;
 
         // Accumulate the size of the produced term: size of monomial,
         // coefficient, and, if present, padding.
@@ -448,16 +904,135 @@ inline ::std::size_t poly_mul_impl_estimate_average_term_size(const ::std::vecto
 
 #endif
 
-// Functor to return a copy of the input
-// term p, but with the const removed
-// from the key type.
-struct poly_mul_impl_pair_transform {
-    template <typename T>
-    auto operator()(const T &p) const
-    {
-        return ::std::make_pair(p.first, p.second);
+// Sketch-based estimation of the number of terms in the product
+// of x and y (represented as vectors of terms). The monomials of the
+// term-by-term products are streamed in parallel through per-thread
+// HyperLogLog sketches, which are then merged.
+// If the total number of term-by-term multiplications tot_n_mults
+// exceeds max_mults, only the terms of x whose index is a multiple
+// of a stride s are streamed. In order to extrapolate to the full
+// product, the terms of x whose index is a multiple of 2*s are
+// streamed also through a second sketch. From the growth of the number
+// of distinct monomials between the two samples, we infer the exponent
+// alpha of a power law D(f) ~ f**alpha, where f is the fraction of
+// sampled terms of x and D(f) the number of distinct monomials.
+// alpha will be close to 1 for very sparse products, and close
+// to 0 for very dense products.
+// vidx2 and degree_data are the vector of indices into y and the
+// degree data computed in poly_mul_estimate_product_size().
+// The returned value is guaranteed to be nonzero.
+template <typename T1, typename T2, typename VIdx2, typename DegreeData, typename... Args>
+inline ::mppp::integer<1> poly_mul_estimate_product_size_sketch(const ::std::vector<T1> &x, const ::std::vector<T2> &y,
+                                                                const VIdx2 &vidx2, const DegreeData &degree_data,
+                                                                const ::mppp::integer<1> &tot_n_mults,
+                                                                ::std::size_t max_mults, const symbol_set &ss,
+                                                                const Args &...args)
+{
+    using key_type = poly_mul_impl_key_t<T1>;
+    using sketch_t = ::obake::detail::hll_sketch<>;
+    using x_size_t = decltype(x.size());
+    using vidx2_size_t = decltype(vidx2.size());
+
+    // Preconditions.
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(max_mults > 0u);
+
+    // Determine the stride.
+    x_size_t stride = 1;
+    if (tot_n_mults > max_mults) {
+        // NOTE: the stride is at most the size of x,
+        // so that at least one term of x is streamed.
+        const auto s = (tot_n_mults + (max_mults - 1u)) / max_mults;
+        stride = s >= x.size() ? x.size() : static_cast<x_size_t>(s);
+    }
+
+    // The number of streamed terms of x.
+    const auto n_rows = x.size() / stride + static_cast<x_size_t>(x.size() % stride != 0u);
+
+    auto [sk1, sk2] = ::tbb::parallel_reduce(
+        ::tbb::blocked_range<x_size_t>(0, n_rows), ::std::make_pair(sketch_t{}, sketch_t{}),
+        [&x, &y, &vidx2, &degree_data, stride, &ss, &args...](const auto &range, ::std::pair<sketch_t, sketch_t> cur) {
+            // Temporary object for monomial multiplications.
+            key_type tmp_key(ss);
+
+            for (auto k = range.begin(); k != range.end(); ++k) {
+                const auto idx1 = k * stride;
+
+                // Get the upper limit for indexing in vidx2
+                // (see the random trials in poly_mul_estimate_product_size()).
+                const auto limit = [&degree_data, idx1, &vidx2, &args...]() {
+                    if constexpr (sizeof...(args) == 0u) {
+                        ::obake::detail::ignore(degree_data, idx1);
+
+                        return vidx2.size();
+                    } else {
+                        const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+                        const auto &[v1_deg, v2_deg] = degree_data;
+                        const auto &d1 = v1_deg[idx1];
+
+                        const auto it = ::std::upper_bound(
+                            v2_deg.cbegin(), v2_deg.cend(), max_deg,
+                            [&d1](const auto &mdeg, const auto &d2) { return mdeg < d1 + d2; });
+
+                        return static_cast<vidx2_size_t>(it - v2_deg.cbegin());
+                    }
+                }();
+
+                const auto &k1 = detail::poly_mul_impl_term_ref(x[idx1]).first;
+                const auto add_to_sk2 = stride > 1u && k % 2u == 0u;
+
+                for (vidx2_size_t j = 0; j < limit; ++j) {
+                    ::obake::monomial_mul(tmp_key, k1, detail::poly_mul_impl_term_ref(y[vidx2[j]]).first, ss);
+
+                    const auto h = static_cast<::std::uint64_t>(::obake::hash(::std::as_const(tmp_key)));
+                    cur.first.add(h);
+                    if (add_to_sk2) {
+                        cur.second.add(h);
+                    }
+                }
+            }
+
+            return cur;
+        },
+        [](auto a, const auto &b) {
+            a.first.merge(b.first);
+            a.second.merge(b.second);
+
+            return a;
+        });
+
+    auto est = sk1.estimate();
+
+    if (stride > 1u) {
+        // Extrapolate to the full product.
+        const auto est2 = sk2.estimate();
+
+        auto alpha = ::std::log2(est / est2);
+        if (!::std::isfinite(alpha)) {
+            // NOTE: this can happen if the sketches are
+            // empty due to truncation. Assume maximum sparsity.
+            alpha = 1;
+        }
+        alpha = ::std::clamp(alpha, 0., 1.);
+
+        est *= ::std::pow(static_cast<double>(stride), alpha);
+    }
+
+    // Clamp the estimate to [1, tot_n_mults].
+    if (!::std::isfinite(est) || est < 1) {
+        return ::mppp::integer<1>{1};
+    }
+    ::mppp::integer<1> ret{est};
+    if (ret > tot_n_mults) {
+        ret = tot_n_mults;
+    }
+    if (ret.is_zero()) {
+        ret = 1;
     }
-};
+
+    return ret;
+}
 
 // This function will:
 // - estimate the size of the product of two input polynomials,
@@ -466,18 +1041,19 @@ struct poly_mul_impl_pair_transform {
 //   (which could be different from the product of the sizes of the
 //   factors due to truncation).
 // S1 and S2 are the types of the polynomials, x and y the polynomials
-// represented as vectors of terms. The extra arguments represent
+// represented as vectors of terms, pol the multiplication policy (which
+// selects the estimator). The extra arguments represent
 // the truncation limits.
 // Requires x and y not empty, y not shorter than x. The returned
 // value is guaranteed to be nonzero.
 // NOTE: by imposing that x is the shorter series, we are able to
 // greatly reduce the estimation overhead for highly rectangular
-// multiplications. The downside is that we overestimate the final
-// series size quite a bit. Not sure how we could proceed to
-// improve the situation.
+// multiplications. The downside is that the sampling-based estimator
+// overestimates the final series size quite a bit. The sketch-based
+// estimator is much more accurate, at the price of a higher overhead.
 template <typename S1, typename S2, typename T1, typename T2, typename... Args>
 inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::std::vector<T2> &y, const symbol_set &ss,
-                                           const Args &...args)
+                                           const mul_policy &pol, const Args &...args)
 {
     // Preconditions.
     assert(!x.empty());
@@ -486,12 +1062,12 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
     static_assert(sizeof...(args) <= 2u);
 
     // Make sure that the input types are consistent.
-    using key_type = typename T1::first_type;
-    static_assert(::std::is_same_v<key_type, typename T2::first_type>);
+    using key_type = poly_mul_impl_key_t<T1>;
+    static_assert(::std::is_same_v<key_type, poly_mul_impl_key_t<T2>>);
     static_assert(::std::is_same_v<series_key_t<S1>, key_type>);
     static_assert(::std::is_same_v<series_key_t<S2>, key_type>);
-    static_assert(::std::is_same_v<series_cf_t<S1>, typename T1::second_type>);
-    static_assert(::std::is_same_v<series_cf_t<S2>, typename T2::second_type>);
+    static_assert(::std::is_same_v<series_cf_t<S1>, poly_mul_impl_cf_t<T1>>);
+    static_assert(::std::is_same_v<series_cf_t<S2>, poly_mul_impl_cf_t<T2>>);
 
     // Prepare the variable to hold the degree data.
     auto degree_data = detail::poly_mul_impl_prepare_degree_data<S1, S2>(x, y, ss, args...);
@@ -622,6 +1198,16 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
         }
     }();
 
+    if (pol.estimator == mul_estimator::sketch) {
+        // Sketch-based estimation.
+        auto ret = detail::poly_mul_estimate_product_size_sketch(x, y, vidx2, degree_data, tot_n_mults,
+                                                                 pol.sketch_max_mults, ss, args...);
+
+        return ::std::make_tuple(::std::move(ret), ::std::move(tot_n_mults));
+    }
+
+    // Sampling-based estimation.
+
     // Parameters for the random trials.
     // NOTE: the idea here is that the larger the
     // multiplication, the larger the number of trials we can
@@ -745,7 +1331,8 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
                     const auto idx2 = vidx2[idist(rng, dist_param_type(0u, limit - 1u))];
 
                     // Try to do the multiplication.
-                    ::obake::monomial_mul(tmp_key, x[idx1].first, y[idx2].first, ss);
+                    ::obake::monomial_mul(tmp_key, detail::poly_mul_impl_term_ref(x[idx1]).first,
+                                          detail::poly_mul_impl_term_ref(y[idx2]).first, ss);
 
                     // Try the insertion into the local set.
                     const auto ret = ls.insert(tmp_key);
@@ -793,127 +1380,746 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
     }
 }
 
-// The multi-threaded homomorphic implementation.
-template <typename Ret, typename T, typename U, typename... Args>
-inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args &...args)
+// Helper to detect packed monomials. Used to enable
+// the dense multiplication engine.
+template <typename>
+inline constexpr bool poly_mul_is_packed_monomial = false;
+
+template <typename T>
+inline constexpr bool poly_mul_is_packed_monomial<packed_monomial<T>> = true;
+
+// Helper to detect if x and y are the same object,
+// that is, if a multiplication is a squaring.
+template <typename T, typename U>
+inline bool poly_mul_is_sqr([[maybe_unused]] const T &x, [[maybe_unused]] const U &y)
+{
+    if constexpr (::std::is_same_v<T, U>) {
+        return &x == &y;
+    } else {
+        return false;
+    }
+}
+
+// Dense multiplication engine for packed monomials.
+//
+// The idea is to map the monomials of the product into a compact
+// Kronecker-like index space. Given the per-variable exponent
+// bounds [lo_i, hi_i] of the product (deduced from the bounds of
+// the operands), a monomial with exponents e_i is mapped to the index
+// sum_i (e_i - lo_i) * s_i, where the s_i are the strides of the box defined
+// by the bounds. The map is additive, so that the index of the product of two
+// terms is the sum of the indices of the factors (computed wrt the lower bounds
+// of the respective operands). This allows us to accumulate the product in
+// a flat array of coefficients, without any hashing or probing.
+// NOTE: we cannot use the packed values directly because the packing deltas
+// are fixed for a given number of variables, and thus the range of packed
+// values in a product is normally extremely sparse.
+//
+// The index space is split into chunks which are processed in parallel,
+// each chunk allocating only its own slice of the flat array. At the end,
+// the nonzero terms are decoded into packed monomials and moved into
+// the segmented table of retval.
+//
+// The function returns false, without touching retval, if the index space
+// is too large wrt the estimated size of the product or wrt the number
+// of term-by-term multiplications. In such case, the multiplication
+// will have to be performed via the hash-based engine.
+//
+// v1 and v2 can be vectors of terms or vectors of pointers to terms.
+//
+// If sqr is true, v1 and v2 must contain the same terms in the same
+// order, and only the products v1[i] * v2[j] with i <= j will be computed
+// (the off-diagonal products being accumulated twice).
+//
+// Requires v1/v2 not empty, the monomial overflow check already
+// performed and retval empty and already segmented.
+template <typename T, typename U, typename Ret, typename V1, typename V2, typename... Args>
+inline bool poly_mul_impl_dense(Ret &retval, const V1 &v1, const V2 &v2, const ::mppp::integer<1> &est_nterms,
+                                const ::mppp::integer<1> &tot_n_mults, bool sqr, const Args &...args)
 {
-    using cf1_t = series_cf_t<T>;
-    using cf2_t = series_cf_t<U>;
     using ret_key_t = series_key_t<Ret>;
     using ret_cf_t = series_cf_t<Ret>;
+    using cf1_t = series_cf_t<T>;
+    using cf2_t = series_cf_t<U>;
+    using value_type = typename ret_key_t::value_type;
+    using unsigned_t = make_unsigned_t<value_type>;
     using s_size_t = typename Ret::s_size_type;
+    using int_t = ::mppp::integer<1>;
 
-    // Preconditions.
+    static_assert(poly_mul_is_packed_monomial<ret_key_t>);
     static_assert(sizeof...(args) <= 2u);
-    assert(!x.empty());
-    assert(!y.empty());
-    assert(x.size() <= y.size());
-    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
-    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    // Preconditions.
+    assert(!v1.empty());
+    assert(!v2.empty());
     assert(retval.empty());
-    assert(retval._get_s_table().size() == 1u);
 
-    // Cache the symbol set.
     const auto &ss = retval.get_symbol_set();
 
-    // Create vectors containing copies of
-    // the input terms.
-    // NOTE: in theory, it would be possible here
-    // to move the coefficients (in conjunction with
-    // rref_cleaner, as usual).
-    // NOTE: drop the const from the key type in order
-    // to allow mutability.
-    // NOTE: need to better assess the benefits of
-    // copying the input series.
-    ::std::vector<::std::pair<series_key_t<T>, cf1_t>> v1(
-        ::boost::make_transform_iterator(x.begin(), poly_mul_impl_pair_transform{}),
-        ::boost::make_transform_iterator(x.end(), poly_mul_impl_pair_transform{}));
-    ::std::vector<::std::pair<series_key_t<U>, cf2_t>> v2(
-        ::boost::make_transform_iterator(y.begin(), poly_mul_impl_pair_transform{}),
-        ::boost::make_transform_iterator(y.end(), poly_mul_impl_pair_transform{}));
+    // NOTE: the monomials are compatible with ss,
+    // thus the static cast is safe.
+    const auto s_size = static_cast<unsigned>(ss.size());
 
-    // Do the monomial overflow checking, if supported.
-    // NOTE: we have to sequence the overflow checking before the product
-    // size estimation and the average term size estimation, as those two
-    // operations might generate overflows during monomial multiplication.
-    const auto r1
-        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
-                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
-    const auto r2
-        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
-                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
-    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
-        // The monomial overflow checking is supported, run it.
-        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
-            obake_throw(::std::overflow_error, "An overflow in the monomial exponents was detected while "
-                                               "attempting to multiply two polynomials");
-        }
+    if (s_size == 0u) {
+        // Nothing to gain in this case.
+        return false;
     }
 
-    // Estimate the total number of terms, and compute the total number
-    // of term-by-term multiplications.
-    // NOTE: poly_mul_estimate_product_size() requires the shorter series first,
-    // which is ensured by the preconditions of this function.
-    const auto [est_nterms, tot_n_mults] = detail::poly_mul_estimate_product_size<T, U>(v1, v2, ss, args...);
-    // Exit early if the truncation limits
-    // result in an empty output series.
-    if (sizeof...(Args) > 0u && tot_n_mults.is_zero()) {
-        return;
-    }
+    // Helper to compute the per-variable exponent bounds
+    // for the monomials in the vector of terms v.
+    using bounds_t = ::std::vector<::std::pair<value_type, value_type>>;
+    auto compute_bounds = [s_size](const auto &v) {
+        return ::tbb::parallel_reduce(
+            ::tbb::blocked_range<decltype(v.size())>(0, v.size()),
+            bounds_t(s_size, ::std::make_pair(::obake::detail::limits_max<value_type>,
+                                              ::obake::detail::limits_min<value_type>)),
+            [&v, s_size](const auto &range, bounds_t cur) {
+                value_type tmp;
+                for (auto i = range.begin(); i != range.end(); ++i) {
+                    kunpacker<value_type> ku(detail::poly_mul_impl_term_ref(v[i]).first.get_value(), s_size);
+                    for (auto j = 0u; j < s_size; ++j) {
+                        ku >> tmp;
+                        cur[j].first = ::std::min(cur[j].first, tmp);
+                        cur[j].second = ::std::max(cur[j].second, tmp);
+                    }
+                }
 
-    // Estimate the average term size.
-    // NOTE: once poly_mul_impl_estimate_average_term_size() becomes more computationally intensive,
-    // we can do it in parallel with poly_mul_estimate_product_size().
-    const auto avg_term_size = detail::poly_mul_impl_estimate_average_term_size<ret_cf_t>(v1, v2, ss);
+                return cur;
+            },
+            [s_size](bounds_t a, const bounds_t &b) {
+                for (auto j = 0u; j < s_size; ++j) {
+                    a[j].first = ::std::min(a[j].first, b[j].first);
+                    a[j].second = ::std::max(a[j].second, b[j].second);
+                }
 
-    // Compute the estimated sparsity.
-    const auto est_sp = static_cast<double>(est_nterms) / static_cast<double>(tot_n_mults);
+                return a;
+            });
+    };
 
-    // Establish the desired segment size in kilobytes.
-    // NOTE: the idea here is the following. For highly
-    // sparse polynomials (est_sp >= threshold), we want to pick
-    // a relatively large size so that it fits somewhere in L2
-    // cache, say. The reason is that we won't do much computation
-    // per segment due to the sparsity, thus we aim at reducing
-    // the parallelisation overhead by operating on larger chunks
-    // of the product series. When the sparsity is smaller, then
-    // we have a higher computational density, thus we will spend
-    // more time computing a single segment, and thus we can aim
-    // at staying in L1 cache instead, as the parallelisation overhead
-    // will be smaller. Note that these values will be just rule-of-thumb,
-    // because the sparsity is not estimated accurately and because
-    // of further manipulations below. Additionally, it is not clear
-    // to me how smooth the transition between high and low sparsity
-    // will be. Eventually, we may perhaps want to leave this parameter as
-    // a tunable parameter for the user or perhaps even determine
-    // the cache sizes at runtime and use those.
-    // NOTE: if est_sp is not finite, due to tot_n_mults being zero or other
-    // FP issues, go with a default value.
-    // NOTE: is it worth it to exit early if tot_n_mults is zero? This would
-    // mean that the truncation limits will produce an empty series.
-    const auto seg_size = (!::std::isfinite(est_sp) || est_sp >= 1E-3) ? 200ul : 20ul;
+    bounds_t b1, b2;
+    ::tbb::parallel_invoke([&b1, &v1, &compute_bounds]() { b1 = compute_bounds(v1); },
+                           [&b2, &v2, &compute_bounds]() { b2 = compute_bounds(v2); });
 
-    // Estimate the number of segments via the deduced segment size.
-    const auto est_nsegs = (est_nterms * avg_term_size) / (seg_size * 1024ul);
+    // Compute the size of the index space,
+    // in arbitrary-precision arithmetic.
+    int_t isize{1};
+    for (auto j = 0u; j < s_size; ++j) {
+        isize *= (int_t{b1[j].second} + b2[j].second) - (int_t{b1[j].first} + b2[j].first) + 1;
+    }
 
-    // Fetch the base-2 logarithm + 1 of est_nsegs, making sure it does not
-    // overflow the max allowed value for the return polynomial type.
-    const auto log2_nsegs = ::std::min(::obake::safe_cast<unsigned>(est_nsegs.nbits()),
-                                       polynomial<ret_key_t, ret_cf_t>::get_max_s_size());
+    // Check if it is worth it to run the dense engine. We want:
+    // - the size of the index space to be not much larger than the
+    //   estimated number of terms in the product (so that the memory
+    //   utilisation is comparable to the hash-based engine, keeping in mind
+    //   that only a few slices of the flat array are alive at the same time),
+    // - the size of the index space not to exceed the number of
+    //   term-by-term multiplications (so that the cost of initialising
+    //   and scanning the flat array is dominated by the multiplications).
+    // NOTE: the estimation of the number of terms tends to err on the
+    // high side, which here makes the dense engine a bit more likely
+    // to be selected. This is not a problem in practice.
+    constexpr unsigned max_ratio = 32;
+    ::std::size_t n_idx = 0;
+    if (isize > est_nterms * max_ratio || isize > tot_n_mults || !::mppp::get(n_idx, isize)) {
+        return false;
+    }
 
-    // Setup the number of segments in retval.
-    retval.set_n_segments(log2_nsegs);
+    // Compute the strides of the index space and the lower bounds
+    // of the product exponents.
+    // NOTE: all the strides are not greater than n_idx, thus
+    // they are representable by std::size_t. The lower bounds
+    // of the product exponents are representable thanks to
+    // the overflow check.
+    ::std::vector<::std::size_t> strides, ranges;
+    ::std::vector<value_type> lo;
+    strides.reserve(s_size);
+    ranges.reserve(s_size);
+    lo.reserve(s_size);
+    {
+        ::std::size_t cur_stride = 1;
+        for (auto j = 0u; j < s_size; ++j) {
+            const auto r = static_cast<::std::size_t>(
+                (int_t{b1[j].second} + b2[j].second) - (int_t{b1[j].first} + b2[j].first) + 1);
 
-    // Cache the actual number of segments.
-    const auto nsegs = s_size_t(1) << log2_nsegs;
+            strides.push_back(cur_stride);
+            ranges.push_back(r);
+            lo.push_back(static_cast<value_type>(b1[j].first + b2[j].first));
 
-    // Helper to sort the input terms according to the hash value modulo
+            cur_stride *= r;
+        }
+        assert(cur_stride == n_idx);
+    }
+
+    // Helper to compute the indices of the terms in v (using
+    // the lower bounds b), paired to the positions
+    // of the terms in v, and sorted according to the indices.
+    auto compute_indices = [s_size, &strides](const auto &v, const bounds_t &b) {
+        using idx_t = decltype(v.size());
+
+        ::std::vector<::std::pair<::std::size_t, idx_t>> ret;
+        ret.resize(::obake::safe_cast<decltype(ret.size())>(v.size()));
+
+        ::tbb::parallel_for(::tbb::blocked_range<idx_t>(0, v.size()), [&ret, &v, &b, &strides, s_size](const auto &r) {
+            value_type tmp;
+            for (auto i = r.begin(); i != r.end(); ++i) {
+                kunpacker<value_type> ku(detail::poly_mul_impl_term_ref(v[i]).first.get_value(), s_size);
+                ::std::size_t idx = 0;
+                for (auto j = 0u; j < s_size; ++j) {
+                    ku >> tmp;
+                    // NOTE: compute the difference in unsigned arithmetic
+                    // to avoid overflows with signed exponents. The result
+                    // is representable because it is less than the range
+                    // of the variable.
+                    idx += static_cast<::std::size_t>(static_cast<unsigned_t>(static_cast<unsigned_t>(tmp)
+                                                                              - static_cast<unsigned_t>(b[j].first)))
+                           * strides[j];
+                }
+                ret[i] = ::std::make_pair(idx, i);
+            }
+        });
+
+        ::tbb::parallel_sort(ret.begin(), ret.end());
+
+        return ret;
+    };
+
+    // Prepare the degree data, if needed.
+    auto degree_data = detail::poly_mul_impl_prepare_degree_data<T, U>(v1, v2, ss, args...);
+
+    decltype(compute_indices(v1, b1)) vidx1;
+    decltype(compute_indices(v2, b2)) vidx2;
+    ::tbb::parallel_invoke(
+        [&vidx1, &v1, &b1, &compute_indices, &degree_data, &ss, &args...]() {
+            vidx1 = compute_indices(v1, b1);
+
+            if constexpr (sizeof...(args) == 1u) {
+                ::obake::detail::ignore(args...);
+                ::obake::detail::container_it_diff_check(v1);
+                ::std::get<0>(degree_data)
+                    = customisation::internal::make_degree_vector<T>(v1.cbegin(), v1.cend(), ss, true);
+            } else if constexpr (sizeof...(args) == 2u) {
+                ::obake::detail::container_it_diff_check(v1);
+                ::std::get<0>(degree_data) = customisation::internal::make_p_degree_vector<T>(
+                    v1.cbegin(), v1.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), true);
+            } else {
+                ::obake::detail::ignore(degree_data, ss, args...);
+            }
+        },
+        [&vidx2, &v2, &b2, &compute_indices, &degree_data, &ss, &args...]() {
+            vidx2 = compute_indices(v2, b2);
+
+            if constexpr (sizeof...(args) == 1u) {
+                ::obake::detail::ignore(args...);
+                ::obake::detail::container_it_diff_check(v2);
+                ::std::get<1>(degree_data)
+                    = customisation::internal::make_degree_vector<U>(v2.cbegin(), v2.cend(), ss, true);
+            } else if constexpr (sizeof...(args) == 2u) {
+                ::obake::detail::container_it_diff_check(v2);
+                ::std::get<1>(degree_data) = customisation::internal::make_p_degree_vector<U>(
+                    v2.cbegin(), v2.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), true);
+            } else {
+                ::obake::detail::ignore(degree_data, ss, args...);
+            }
+        });
+
+    // The largest index in vidx2.
+    const auto max_i2 = vidx2.back().first;
+
+    // Split the index space into chunks. We want a number of chunks
+    // which is a few times the number of threads, for load balancing
+    // and in order to limit the size of the slices of the flat array.
+    const auto nchunks = static_cast<::std::size_t>(
+        ::std::min(n_idx, static_cast<::std::size_t>(::obake::detail::hc()) * 4u + 1u));
+    const auto chunk_size = n_idx / nchunks + static_cast<::std::size_t>(n_idx % nchunks != 0u);
+
+    // Setup the segmentation bits.
+    const auto nsegs = static_cast<s_size_t>(retval._get_s_table().size());
+    const auto seg_mask = static_cast<::std::size_t>(nsegs - 1u);
+
+    // The output of each chunk: the list of nonzero terms of the
+    // chunk, sorted according to the destination segment in retval,
+    // and the offsets of each segment in the list.
+    ::std::vector<::std::vector<::std::pair<ret_key_t, ret_cf_t>>> c_terms(nchunks);
+    ::std::vector<::std::vector<::std::size_t>> c_offsets(nchunks);
+
+    try {
+        detail::poly_par_for(::tbb::blocked_range<::std::size_t>(0, nchunks), [&](const auto &range) {
+            // The flat array of coefficients and the flags
+            // signalling which coefficients have been written to.
+            // NOTE: we cannot assume that a default-constructed
+            // coefficient is zero, hence we use the flags.
+            ::std::vector<ret_cf_t> arr;
+            ::std::vector<unsigned char> flags;
+            // The decoded nonzero terms of a chunk and
+            // their destination segments in retval.
+            ::std::vector<::std::pair<ret_key_t, ret_cf_t>> dec;
+            ::std::vector<s_size_t> dec_segs;
+
+            for (auto c_idx = range.begin(); c_idx != range.end(); ++c_idx) {
+                // The index range of the current chunk.
+                const auto c_begin = c_idx * chunk_size;
+                const auto c_end = ::std::min(c_begin + chunk_size, n_idx);
+                if (c_begin >= c_end) {
+                    continue;
+                }
+
+                arr.clear();
+                arr.resize(static_cast<decltype(arr.size())>(c_end - c_begin));
+                flags.clear();
+                flags.resize(static_cast<decltype(flags.size())>(c_end - c_begin));
+
+                // NOTE: skip the terms of vidx1 whose products with the
+                // largest index in vidx2 still fall before the current chunk.
+                const auto it1_b = ::std::lower_bound(
+                    vidx1.cbegin(), vidx1.cend(), c_begin > max_i2 ? c_begin - max_i2 : ::std::size_t(0),
+                    [](const auto &p, const ::std::size_t &n) { return p.first < n; });
+                for (auto it1 = it1_b; it1 != vidx1.cend(); ++it1) {
+                    const auto &[i1, pos1] = *it1;
+
+                    if (i1 >= c_end) {
+                        // vidx1 is sorted, and the indices in vidx2 are non-negative:
+                        // no product of the current or following terms
+                        // will end up in the current chunk.
+                        break;
+                    }
+
+                    const auto &c1 = detail::poly_mul_impl_term_ref(v1[pos1]).second;
+
+                    // Locate the terms in vidx2 whose products with the current
+                    // term end up in the current chunk.
+                    const auto lb = c_begin > i1 ? c_begin - i1 : ::std::size_t(0);
+                    const auto ub = c_end - i1;
+                    const auto it_b = ::std::lower_bound(
+                        vidx2.cbegin(), vidx2.cend(), lb,
+                        [](const auto &p, const ::std::size_t &n) { return p.first < n; });
+                    const auto it_e
+                        = ::std::lower_bound(it_b, vidx2.cend(), ub,
+                                             [](const auto &p, const ::std::size_t &n) { return p.first < n; });
+
+                    for (auto it = it_b; it != it_e; ++it) {
+                        const auto &[i2, pos2] = *it;
+
+                        // In squaring mode, skip the products
+                        // below the diagonal.
+                        if (sqr && pos2 < pos1) {
+                            continue;
+                        }
+
+                        // In truncated multiplication, skip the
+                        // products exceeding the truncation limit.
+                        if constexpr (sizeof...(args) > 0u) {
+                            const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+                            const auto &[vd1, vd2] = degree_data;
+
+                            // NOTE: we require below comparability between const lvalue
+                            // limit and rvalue of the sum of the degrees.
+                            if (max_deg < vd1[pos1] + vd2[pos2]) {
+                                continue;
+                            }
+                        }
+
+                        const auto &c2 = detail::poly_mul_impl_term_ref(v2[pos2]).second;
+                        const auto a_idx = i1 + i2 - c_begin;
+
+                        if (sqr && pos2 != pos1) {
+                            // Off-diagonal product in squaring mode: compute
+                            // c1*c2 once and accumulate it twice.
+                            ret_cf_t tmp(c1 * c2);
+
+                            if (flags[a_idx]) {
+                                arr[a_idx] += ::std::as_const(tmp);
+                            } else {
+                                arr[a_idx] = tmp;
+                                flags[a_idx] = 1;
+                            }
+                            arr[a_idx] += ::std::move(tmp);
+
+                            continue;
+                        }
+
+                        if (flags[a_idx]) {
+                            if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
+                                ::obake::fma3(arr[a_idx], c1, c2);
+                            } else {
+                                arr[a_idx] += c1 * c2;
+                            }
+                        } else {
+                            arr[a_idx] = c1 * c2;
+                            flags[a_idx] = 1;
+                        }
+                    }
+                }
+
+                // Decode the nonzero terms of the chunk, computing
+                // the destination segment of each term once.
+                dec.clear();
+                dec_segs.clear();
+                for (::std::size_t a_idx = 0; a_idx < c_end - c_begin; ++a_idx) {
+                    if (!flags[a_idx] || ::obake::is_zero(::std::as_const(arr[a_idx]))) {
+                        continue;
+                    }
+
+                    auto idx = c_begin + a_idx;
+                    kpacker<value_type> kp(s_size);
+                    for (auto j = 0u; j < s_size; ++j) {
+                        // NOTE: do the computation in unsigned arithmetic,
+                        // the result is within the product bounds.
+                        kp << static_cast<value_type>(static_cast<unsigned_t>(
+                            static_cast<unsigned_t>(lo[j]) + static_cast<unsigned_t>(idx % ranges[j])));
+                        idx /= ranges[j];
+                    }
+
+                    const ret_key_t k(kp.get());
+                    dec_segs.push_back(static_cast<s_size_t>(static_cast<::std::size_t>(::obake::hash(k)) & seg_mask));
+                    dec.emplace_back(k, ::std::move(arr[a_idx]));
+                }
+
+                // Group the terms according to the destination segment
+                // (via a counting sort), and compute the segment offsets.
+                auto &offsets = c_offsets[c_idx];
+                offsets.assign(static_cast<decltype(offsets.size())>(nsegs + 1u), 0);
+                for (const auto s_idx : dec_segs) {
+                    ++offsets[s_idx + 1u];
+                }
+                for (s_size_t s_idx = 0; s_idx < nsegs; ++s_idx) {
+                    offsets[s_idx + 1u] += offsets[s_idx];
+                }
+                assert(offsets[nsegs] == dec.size());
+
+                auto &terms = c_terms[c_idx];
+                terms.resize(dec.size());
+                {
+                    auto cur = offsets;
+                    for (decltype(dec.size()) i = 0; i < dec.size(); ++i) {
+                        terms[cur[dec_segs[i]]++] = ::std::move(dec[i]);
+                    }
+                }
+            }
+        });
+
+        // Move the terms into retval, in parallel over the segments.
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&retval, &c_terms, &c_offsets, nchunks,
+                                                                       mts = retval._get_max_table_size()](
+                                                                          const auto &range) {
+            for (auto s_idx = range.begin(); s_idx != range.end(); ++s_idx) {
+                auto &table = retval._get_s_table()[s_idx];
+
+                // Reserve space in the table.
+                ::std::size_t tot = 0;
+                for (::std::size_t c_idx = 0; c_idx < nchunks; ++c_idx) {
+                    if (!c_offsets[c_idx].empty()) {
+                        tot += c_offsets[c_idx][s_idx + 1u] - c_offsets[c_idx][s_idx];
+                    }
+                }
+
+                // LCOV_EXCL_START
+                if (obake_unlikely(tot > mts)) {
+                    obake_throw(::std::overflow_error, "The dense multiplication of two "
+                                                       "polynomials resulted in a table whose size ("
+                                                           + ::obake::detail::to_string(tot)
+                                                           + ") is larger than the maximum allowed value ("
+                                                           + ::obake::detail::to_string(mts) + ")");
+                }
+                // LCOV_EXCL_STOP
+
+                table.reserve(tot);
+
+                for (::std::size_t c_idx = 0; c_idx < nchunks; ++c_idx) {
+                    if (c_offsets[c_idx].empty()) {
+                        continue;
+                    }
+
+                    auto &terms = c_terms[c_idx];
+                    for (auto i = c_offsets[c_idx][s_idx]; i < c_offsets[c_idx][s_idx + 1u]; ++i) {
+                        // NOTE: the keys are unique by construction.
+                        [[maybe_unused]] const auto res
+                            = table.try_emplace(::std::move(terms[i].first), ::std::move(terms[i].second));
+                        assert(res.second);
+                    }
+                }
+            }
+        });
+        // LCOV_EXCL_START
+    } catch (...) {
+        // In case of exceptions, clear retval before
+        // rethrowing to ensure a known sane state.
+        retval.clear();
+        throw;
+        // LCOV_EXCL_STOP
+    }
+
+    return true;
+}
+
+// Helper to change the number of segments of the series s
+// to 2**log2_nsegs, redistributing its terms. The terms
+// are moved in parallel, one destination table at a time.
+// If an exception is thrown, s will be left empty.
+template <typename S>
+inline void poly_mul_impl_reseg(S &s, unsigned log2_nsegs)
+{
+    using s_size_t = typename S::s_size_type;
+    using term_t = typename S::table_type::value_type;
+
+    const auto old_log2_nsegs = s.get_s_size();
+    if (old_log2_nsegs == log2_nsegs) {
+        return;
+    }
+
+    // Move out the original tables.
+    auto old_table = ::std::move(s._get_s_table());
+    auto &new_table = s._get_s_table();
+    const auto old_nsegs = s_size_t(1) << old_log2_nsegs;
+    const auto new_nsegs = s_size_t(1) << log2_nsegs;
+
+    // Flag signalling that the segmentation
+    // of s has been reset.
+    bool reset = false;
+
+    try {
+        s.set_n_segments(log2_nsegs);
+        reset = true;
+
+        if (old_nsegs > new_nsegs) {
+            // Fewer segments: the destination table is the
+            // union of the original tables whose index is
+            // congruent to seg_idx modulo new_nsegs.
+            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, new_nsegs),
+                                [&old_table, &new_table, old_nsegs, new_nsegs](const auto &range) {
+                                    for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                                        auto &table = new_table[seg_idx];
+
+                                        for (auto i = seg_idx; i < old_nsegs; i += new_nsegs) {
+                                            for (auto &t : old_table[i]) {
+                                                table.try_emplace(t.first, ::std::move(t.second));
+                                            }
+                                        }
+                                    }
+                                });
+        } else {
+            // More segments: the terms of the destination table are
+            // a subset of the original table seg_idx % old_nsegs. Each
+            // term is hashed once in order to sort it into the bucket
+            // of its destination table. The buckets written by distinct
+            // original tables are disjoint, thus they can be filled
+            // in parallel.
+            ::std::vector<::std::vector<term_t *>> buckets;
+            buckets.resize(::obake::safe_cast<decltype(buckets.size())>(new_nsegs));
+
+            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, old_nsegs),
+                                [&old_table, &buckets, new_nsegs](const auto &range) {
+                                    for (auto i = range.begin(); i != range.end(); ++i) {
+                                        for (auto &t : old_table[i]) {
+                                            buckets[static_cast<decltype(buckets.size())>(
+                                                        ::obake::hash(t.first) & (new_nsegs - 1u))]
+                                                .push_back(&t);
+                                        }
+                                    }
+                                });
+
+            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, new_nsegs),
+                                [&new_table, &buckets](const auto &range) {
+                                    for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                                        auto &table = new_table[seg_idx];
+                                        const auto &bucket = buckets[static_cast<decltype(buckets.size())>(seg_idx)];
+
+                                        table.reserve(bucket.size());
+                                        for (auto *t : bucket) {
+                                            table.try_emplace(t->first, ::std::move(t->second));
+                                        }
+                                    }
+                                });
+        }
+        // LCOV_EXCL_START
+    } catch (...) {
+        if (!reset) {
+            // Restore the original tables, so that
+            // the segmentation of s is consistent.
+            new_table = ::std::move(old_table);
+        }
+        s.clear_terms();
+        throw;
+    }
+    // LCOV_EXCL_STOP
+}
+
+// The multi-threaded homomorphic implementation.
+// The return value contains the engine which was actually used
+// (either hash or dense) and, for the hash-based engine,
+// the number of segments and the measured load imbalance.
+// The number of terms in the return value is not set.
+// If retval is not empty, the product will be accumulated
+// into the existing terms of retval (in this case, the
+// dense engine is never used).
+// d1 and d2 are optional pointers to the precomputed
+// operand data of x and y (see poly_mul_operand_data).
+template <typename Ret, typename T, typename U, typename D1, typename D2, typename... Args>
+inline mul_stats poly_mul_impl_mt_hm_data(Ret &retval, const T &x, const U &y, const D1 *d1, const D2 *d2,
+                                          const Args &...args)
+{
+    using cf1_t = series_cf_t<T>;
+    using cf2_t = series_cf_t<U>;
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using s_size_t = typename Ret::s_size_type;
+
+    // Preconditions.
+    static_assert(sizeof...(args) <= 2u);
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(x.size() <= y.size());
+    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
+    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
+    if constexpr (::std::is_same_v<Ret, T>) {
+        assert(&retval != &x);
+    }
+    if constexpr (::std::is_same_v<Ret, U>) {
+        assert(&retval != &y);
+    }
+
+    // Cache the symbol set.
+    const auto &ss = retval.get_symbol_set();
+
+    // Fetch the multiplication policy.
+    const auto pol = ::obake::polynomials::get_mul_policy();
+
+    // Accumulation flag.
+    const auto acc_mode = !retval.empty();
+
+    // Squaring flag. If x and y are the same object,
+    // for each pair of terms x_i * x_j only the product
+    // with i <= j will be computed, and the off-diagonal
+    // products will be accumulated twice.
+    const auto sqr = detail::poly_mul_is_sqr(x, y);
+
+    // Create vectors of pointers to the input terms.
+    // All the sorting and segmentation below will be
+    // done on these vectors, without copying the terms
+    // of the operands.
+    // NOTE: in squaring mode, v2 will be created
+    // later as a copy of v1.
+    // NOTE: if the operand data is available, the
+    // vectors are copied from it.
+    ::std::vector<const series_term_t<T> *> v1;
+    ::std::vector<const series_term_t<U> *> v2;
+    ::tbb::parallel_invoke([&v1, &x, d1]() { v1 = d1 ? d1->v : detail::poly_mul_impl_par_make_ptr_vector(x); },
+                           [&v2, &y, d2, sqr]() {
+                               if (!sqr) {
+                                   v2 = d2 ? d2->v : detail::poly_mul_impl_par_make_ptr_vector(y);
+                               }
+                           });
+    if constexpr (::std::is_same_v<T, U>) {
+        if (sqr) {
+            v2 = v1;
+        }
+    }
+
+    // Do the monomial overflow checking, if supported.
+    // NOTE: we have to sequence the overflow checking before the product
+    // size estimation and the average term size estimation, as those two
+    // operations might generate overflows during monomial multiplication.
+    // NOTE: if the operand data is available, the check
+    // is run on the (smaller) overflow subsets.
+    const auto &ov1 = d1 ? d1->ov : ::std::as_const(v1);
+    const auto &ov2 = d2 ? d2->ov : ::std::as_const(v2);
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(ov1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(ov1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(ov2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(ov2.cend(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        // The monomial overflow checking is supported, run it.
+        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+            obake_throw(::std::overflow_error, "An overflow in the monomial exponents was detected while "
+                                               "attempting to multiply two polynomials");
+        }
+    }
+
+    // Estimate the total number of terms, and compute the total number
+    // of term-by-term multiplications.
+    // NOTE: poly_mul_estimate_product_size() requires the shorter series first,
+    // which is ensured by the preconditions of this function.
+    const auto est_start = ::std::chrono::steady_clock::now();
+    const auto [est_nterms, tot_n_mults] = detail::poly_mul_estimate_product_size<T, U>(v1, v2, ss, pol, args...);
+
+    // Init the statistics.
+    mul_stats ret;
+    ret.engine = mul_engine::hash;
+    ret.policy = pol;
+    ret.est_n_terms = est_nterms.nbits() <= static_cast<unsigned>(::obake::detail::limits_digits<::std::size_t>)
+                          ? static_cast<::std::size_t>(est_nterms)
+                          : ::obake::detail::limits_max<::std::size_t>;
+    ret.est_time = ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - est_start).count();
+
+    // Exit early if the truncation limits
+    // result in an empty output series.
+    if (sizeof...(Args) > 0u && tot_n_mults.is_zero()) {
+        return ret;
+    }
+
+    // Estimate the average term size.
+    // NOTE: once poly_mul_impl_estimate_average_term_size() becomes more computationally intensive,
+    // we can do it in parallel with poly_mul_estimate_product_size().
+    const auto avg_term_size = detail::poly_mul_impl_estimate_average_term_size<ret_cf_t>(v1, v2, ss);
+
+    // Compute the estimated sparsity.
+    const auto est_sp = static_cast<double>(est_nterms) / static_cast<double>(tot_n_mults);
+
+    // Establish the desired segment size in bytes.
+    // NOTE: for highly sparse products we pick the (larger)
+    // sparse segment size from the policy, otherwise the dense
+    // one. See the construction of the default policy for
+    // the rationale. Note that the sparsity is not estimated
+    // accurately, thus this is just a rule of thumb.
+    // NOTE: if est_sp is not finite, due to tot_n_mults being zero or other
+    // FP issues, go with the sparse segment size.
+    const auto seg_size = (!::std::isfinite(est_sp) || est_sp >= pol.sparsity_threshold) ? pol.sparse_seg_size
+                                                                                          : pol.dense_seg_size;
+
+    // Estimate the number of segments via the deduced segment size.
+    // NOTE: in accumulation mode, take into account also
+    // the terms already present in retval.
+    // NOTE: the policy guarantees that seg_size is nonzero.
+    assert(seg_size > 0u);
+    const auto est_nsegs = ((est_nterms + retval.size()) * avg_term_size) / seg_size;
+
+    // Fetch the base-2 logarithm + 1 of est_nsegs, making sure it does not
+    // overflow the max allowed value for the return polynomial type.
+    const auto log2_nsegs = ::std::min(::obake::safe_cast<unsigned>(est_nsegs.nbits()),
+                                       polynomial<ret_key_t, ret_cf_t>::get_max_s_size());
+
+    // Setup the number of segments in retval. In accumulation
+    // mode, the existing terms are redistributed.
+    if (acc_mode) {
+        detail::poly_mul_impl_reseg(retval, log2_nsegs);
+    } else {
+        retval.set_n_segments(log2_nsegs);
+    }
+
+    // For packed monomials, try first the dense engine (unless
+    // the hash-based engine was explicitly requested). If the
+    // product is not dense enough, proceed with the hash-based engine.
+    if constexpr (detail::poly_mul_is_packed_monomial<ret_key_t>) {
+        if (!acc_mode && pol.engine != mul_engine::hash
+            && detail::poly_mul_impl_dense<T, U>(retval, v1, v2, est_nterms, tot_n_mults, sqr, args...)) {
+            ret.engine = mul_engine::dense;
+            ret.seg_size = static_cast<::std::size_t>(seg_size);
+
+            return ret;
+        }
+    }
+
+    // Cache the actual number of segments.
+    const auto nsegs = s_size_t(1) << log2_nsegs;
+
+    // Helper to sort the input terms according to the hash value modulo
     // 2**log2_nsegs. That is, sort them according to the bucket
     // they would occupy in a segmented table with 2**log2_nsegs
     // segments.
     auto t_sorter = [log2_nsegs](const auto &p1, const auto &p2) {
-        const auto h1 = ::obake::hash(p1.first);
-        const auto h2 = ::obake::hash(p2.first);
+        const auto h1 = ::obake::hash(p1->first);
+        const auto h2 = ::obake::hash(p2->first);
 
         return h1 % (s_size_t(1) << log2_nsegs) < h2 % (s_size_t(1) << log2_nsegs);
     };
@@ -954,11 +2160,12 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
         if (v.size() < nsegs / 2u) {
             for (auto it = v_begin; it != v_end;) {
                 // Get the bucket index of the current term.
-                const auto cur_b_idx = static_cast<s_size_t>(::obake::hash(it->first) % (s_size_t(1) << log2_nsegs));
+                const auto cur_b_idx
+                    = static_cast<s_size_t>(::obake::hash((*it)->first) % (s_size_t(1) << log2_nsegs));
                 // Look for the first term whose bucket index is greater than cur_b_idx.
                 const auto range_end
                     = ::std::upper_bound(it, v_end, cur_b_idx, [log2_nsegs](const auto &b_idx, const auto &p) {
-                          return b_idx < ::obake::hash(p.first) % (s_size_t(1) << log2_nsegs);
+                          return b_idx < ::obake::hash(p->first) % (s_size_t(1) << log2_nsegs);
                       });
                 // NOTE: because we are in the sparse representation case,
                 // range_end cannot be equal to it.
@@ -979,7 +2186,7 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                 // NOTE: this might result in 'it' not changing, in which case
                 // the segmentation range will be empty.
                 it = ::std::upper_bound(it, v_end, i, [log2_nsegs](const auto &b_idx, const auto &p) {
-                    return b_idx < ::obake::hash(p.first) % (s_size_t(1) << log2_nsegs);
+                    return b_idx < ::obake::hash(p->first) % (s_size_t(1) << log2_nsegs);
                 });
                 const auto old_idx = idx;
                 // NOTE: the overflow check was done earlier.
@@ -992,20 +2199,19 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
     };
 
     // Helper that, given a segmentation vseg into a vector of terms
-    // v, will:
+    // v and the vector vd containing the total/partial degrees of all
+    // the terms in v, will:
     //
-    // - create and return a vector vd
-    //   containing the total/partial degrees of all the
-    //   terms in v, with the degrees within each vseg range sorted
-    //   in ascending order,
+    // - sort the degrees within each vseg range
+    //   in ascending order, and return vd,
     // - sort v according to vd.
     //
     // v will be one of v1/v2, t is a type_c instance
     // containing either T or U.
-    auto seg_sorter = [&ss, &args...](auto &v, auto t, const auto &vseg) {
+    auto seg_sorter = [&ss, &args...](auto &v, auto t, const auto &vseg, auto vd) {
         if constexpr (sizeof...(args) == 0u) {
             // Non-truncated case: seg_sorter will be a no-op.
-            ::obake::detail::ignore(v, t, vseg, ss, args...);
+            ::obake::detail::ignore(v, t, vseg, vd, ss, args...);
         } else {
             // Truncated case.
 
@@ -1014,26 +2220,6 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
             // as well.
             using s_t = typename decltype(t)::type;
 
-            // Compute the vector of degrees.
-            auto vd = [&v, &ss, &args...]() {
-                // NOTE: in the make_(p_)degree_vector() helpers we need
-                // to compute the size of v via iterator differences.
-                ::obake::detail::container_it_diff_check(v);
-
-                if constexpr (sizeof...(args) == 1u) {
-                    // Total degree.
-                    ::obake::detail::ignore(args...);
-
-                    return customisation::internal::make_degree_vector<s_t>(v.cbegin(), v.cend(), ss, true);
-                } else {
-                    // Partial degree.
-                    static_assert(sizeof...(args) == 2u);
-
-                    return customisation::internal::make_p_degree_vector<s_t>(
-                        v.cbegin(), v.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), true);
-                }
-            }();
-
             // Ensure that the size of vd is representable by the
             // diff type of its iterators. We'll need to do some
             // iterator arithmetics below.
@@ -1104,6 +2290,53 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
         }
     };
 
+    // Helper that, for one of v1/v2, will:
+    // - sort v according to the segmentation order,
+    // - compute the segmentation ranges vseg,
+    // - compute the degrees of the terms and sort according
+    //   to the degree within each segment (only for truncated
+    //   multiplication), returning them.
+    // If the operand data d is available, v is rebuilt from
+    // the vector of pointers in d via an indirect sort, so that
+    // the precomputed degrees can be permuted accordingly
+    // (instead of being computed again).
+    // t is a type_c instance containing either T or U.
+    auto seg_prepare = [t_sorter, compute_vseg, seg_sorter, &ss, &args...](auto &v, auto &vseg, const auto *d,
+                                                                           auto t) {
+        using s_t = typename decltype(t)::type;
+
+        if (d == nullptr) {
+            ::tbb::parallel_sort(v.begin(), v.end(), t_sorter);
+            vseg = compute_vseg(v);
+            if constexpr (sizeof...(Args) > 0u) {
+                return seg_sorter(v, t, vseg, detail::poly_mul_impl_make_degree_vector<s_t>(v, ss, args...));
+            } else {
+                ::obake::detail::ignore(seg_sorter, ss, args...);
+            }
+        } else {
+            const auto &dv = d->v;
+
+            auto vidx = detail::poly_mul_impl_par_make_idx_vector(dv);
+            ::tbb::parallel_sort(vidx.begin(), vidx.end(), [&dv, t_sorter](const auto &idx1, const auto &idx2) {
+                return t_sorter(dv[idx1], dv[idx2]);
+            });
+
+            ::obake::detail::container_it_diff_check(dv);
+            v = ::std::remove_reference_t<decltype(v)>(::boost::make_permutation_iterator(dv.cbegin(), vidx.cbegin()),
+                                                       ::boost::make_permutation_iterator(dv.cend(), vidx.cend()));
+            vseg = compute_vseg(v);
+            if constexpr (sizeof...(Args) > 0u) {
+                const auto &dd = d->degrees;
+
+                ::obake::detail::container_it_diff_check(dd);
+                auto vd = remove_cvref_t<decltype(dd)>(::boost::make_permutation_iterator(dd.cbegin(), vidx.cbegin()),
+                                                       ::boost::make_permutation_iterator(dd.cend(), vidx.cend()));
+
+                return seg_sorter(v, t, vseg, ::std::move(vd));
+            }
+        }
+    };
+
     // Prepare the variables to hold the segmentations
     // and the degrees of the terms, if we are in a
     // truncated multiplication.
@@ -1111,32 +2344,45 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
     decltype(compute_vseg(v2)) vseg2;
     auto degree_data = detail::poly_mul_impl_prepare_degree_data<T, U>(v1, v2, ss, args...);
 
-    // For both x and y, concurrently:
-    // - sort v1/v2 according to the segmentation order,
-    // - compute the segmentation ranges,
-    // - compute the degrees of the terms and sort according
-    //   to the degree within each segment (only for truncated
-    //   multiplication).
+    // Run seg_prepare() for both x and y, concurrently.
     ::tbb::parallel_invoke(
-        [&v1, t_sorter, &vseg1, compute_vseg, &degree_data, seg_sorter]() {
-            ::tbb::parallel_sort(v1.begin(), v1.end(), t_sorter);
-            vseg1 = compute_vseg(v1);
+        [&v1, &vseg1, &degree_data, seg_prepare, d1]() {
             if constexpr (sizeof...(Args) > 0u) {
-                ::std::get<0>(degree_data) = seg_sorter(v1, ::obake::detail::type_c<T>{}, vseg1);
+                ::std::get<0>(degree_data) = seg_prepare(v1, vseg1, d1, ::obake::detail::type_c<T>{});
             } else {
-                ::obake::detail::ignore(degree_data, seg_sorter);
+                ::obake::detail::ignore(degree_data);
+                seg_prepare(v1, vseg1, d1, ::obake::detail::type_c<T>{});
             }
         },
-        [&v2, t_sorter, &vseg2, compute_vseg, &degree_data, seg_sorter]() {
-            ::tbb::parallel_sort(v2.begin(), v2.end(), t_sorter);
-            vseg2 = compute_vseg(v2);
+        [&v2, &vseg2, &degree_data, seg_prepare, d2, sqr]() {
+            if (sqr) {
+                // In squaring mode, the data for y will be
+                // copied from the data for x (see below).
+                return;
+            }
+
             if constexpr (sizeof...(Args) > 0u) {
-                ::std::get<1>(degree_data) = seg_sorter(v2, ::obake::detail::type_c<U>{}, vseg2);
+                ::std::get<1>(degree_data) = seg_prepare(v2, vseg2, d2, ::obake::detail::type_c<U>{});
             } else {
-                ::obake::detail::ignore(degree_data, seg_sorter);
+                ::obake::detail::ignore(degree_data);
+                seg_prepare(v2, vseg2, d2, ::obake::detail::type_c<U>{});
             }
         });
 
+    // In squaring mode, copy the data for x into the data for y.
+    // NOTE: v1 and v2 must contain the same terms in the same order,
+    // but the sorting of v1/v2 above is not deterministic, thus
+    // we cannot sort them independently.
+    if constexpr (::std::is_same_v<T, U>) {
+        if (sqr) {
+            v2 = v1;
+            vseg2 = vseg1;
+            if constexpr (sizeof...(Args) > 0u) {
+                ::std::get<1>(degree_data) = ::std::get<0>(degree_data);
+            }
+        }
+    }
+
 #if !defined(NDEBUG)
     {
         // Check the segmentations in debug mode.
@@ -1164,7 +2410,7 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                 // Check that all elements in the range
                 // hash to the correct bucket index.
                 for (auto idx = start; idx < end; ++idx) {
-                    assert(::obake::hash(v[idx].first) % (s_size_t(1) << log2_nsegs) == b_idx);
+                    assert(::obake::hash(v[idx]->first) % (s_size_t(1) << log2_nsegs) == b_idx);
                 }
             }
 
@@ -1244,14 +2490,170 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
     ::std::atomic<unsigned long long> n_mults(0);
 #endif
 
+    // The type of the accumulation table used in the
+    // multiplication functors below.
+    using acc_table_t = ::obake::detail::acc_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                                   ::obake::detail::series_key_comparer>;
+
+    // Helper to move the terms accumulated in acc
+    // into the table of retval at index seg_idx.
+    // Terms with zero coefficients will be discarded.
+    auto acc_to_table = [&retval, mts = retval._get_max_table_size(), acc_mode](acc_table_t &acc, s_size_t seg_idx) {
+        // Get a reference to the destination table in retval.
+        auto &table = retval._get_s_table()[seg_idx];
+        assert(acc_mode || table.empty());
+
+        if (acc_mode) {
+            // In accumulation mode, the destination table
+            // may already contain terms with the same keys.
+            table.reserve(table.size() + acc.size());
+
+            acc.consume([&table](ret_key_t &k, ret_cf_t &c) {
+                const auto it = table.find(k);
+
+                if (it == table.end()) {
+                    if (!::obake::is_zero(::std::as_const(c))) {
+                        table.try_emplace(::std::move(k), ::std::move(c));
+                    }
+                } else {
+                    it->second += ::std::move(c);
+
+                    if (::obake::is_zero(::std::as_const(it->second))) {
+                        table.erase(it);
+                    }
+                }
+            });
+        } else {
+            table.reserve(acc.size());
+
+            acc.consume([&table](ret_key_t &k, ret_cf_t &c) {
+                if (obake_likely(!::obake::is_zero(::std::as_const(c)))) {
+                    // NOTE: the keys in acc are unique, no need
+                    // to check for existing terms.
+                    [[maybe_unused]] const auto res = table.try_emplace(::std::move(k), ::std::move(c));
+                    assert(res.second);
+                }
+            });
+        }
+
+        // LCOV_EXCL_START
+        // Check the table size against the max allowed size.
+        if (obake_unlikely(table.size() > mts)) {
+            obake_throw(::std::overflow_error, "The homomorphic multithreaded multiplication of two "
+                                               "polynomials resulted in a table whose size ("
+                                                   + ::obake::detail::to_string(table.size())
+                                                   + ") is larger than the maximum allowed value ("
+                                                   + ::obake::detail::to_string(mts) + ")");
+        }
+        // LCOV_EXCL_STOP
+    };
+
+    // Helper to accumulate twice the product c1 * c2 into
+    // the term with key k in acc. This is used in squaring
+    // mode for the off-diagonal products.
+    auto acc_dbl = [](acc_table_t &acc, const ret_key_t &k, const auto &c1, const auto &c2) {
+        ret_cf_t tmp(c1 * c2);
+
+        const auto res = acc.lazy_emplace(k, [&tmp]() { return tmp; });
+        if (!res.second) {
+            *res.first += ::std::as_const(tmp);
+        }
+        *res.first += ::std::move(tmp);
+    };
+
+    // Estimate the computational cost of each segment of retval. The cost
+    // is estimated as the number of term-by-term multiplications
+    // whose results end up in the segment (without taking into account the
+    // truncation limits, if any). The cost of the segment seg_idx is
+    // computed from the sizes of the ranges in vseg1/vseg2 with bucket
+    // indices i and j such that (i + j) % nsegs == seg_idx.
+    // NOTE: the cost of this computation is O(nsegs * vseg1.size()),
+    // which is not larger than the overhead of the multiplication
+    // functors below.
+    ::std::vector<double> seg_cost;
+    seg_cost.resize(::obake::safe_cast<decltype(seg_cost.size())>(nsegs));
+    {
+        // Store the range sizes in dense form, and
+        // record the non-empty ranges in vseg1.
+        ::std::vector<double> sizes1(seg_cost.size()), sizes2(seg_cost.size());
+        ::std::vector<s_size_t> nz1;
+        nz1.reserve(vseg1.size());
+        for (const auto &[r_start, r_end, b_idx] : vseg1) {
+            if (r_end != r_start) {
+                sizes1[b_idx] = static_cast<double>(r_end - r_start);
+                nz1.push_back(b_idx);
+            }
+        }
+        for (const auto &[r_start, r_end, b_idx] : vseg2) {
+            sizes2[b_idx] = static_cast<double>(r_end - r_start);
+        }
+
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&](const auto &range) {
+            for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                double cost = 0;
+                for (const auto i : nz1) {
+                    const auto j = seg_idx >= i ? (seg_idx - i) : (nsegs - i + seg_idx);
+
+                    if (sqr) {
+                        // In squaring mode, only the pairs with i <= j are
+                        // computed, and on the diagonal only half
+                        // of the products are computed.
+                        if (j > i) {
+                            cost += sizes1[i] * sizes2[j];
+                        } else if (j == i) {
+                            cost += sizes1[i] * (sizes1[i] + 1) / 2;
+                        }
+                    } else {
+                        cost += sizes1[i] * sizes2[j];
+                    }
+                }
+                seg_cost[seg_idx] = cost;
+            }
+        });
+    }
+
+    // Establish the order in which the segments will be processed: the
+    // most expensive segments first. The segments are then assigned
+    // dynamically to the worker tasks in this order, so that the
+    // expensive segments do not end up being processed at the end
+    // of the multiplication while the other threads sit idle.
+    ::std::vector<s_size_t> seg_order;
+    seg_order.resize(::obake::safe_cast<decltype(seg_order.size())>(nsegs));
+    ::std::iota(seg_order.begin(), seg_order.end(), s_size_t(0));
+    ::std::stable_sort(seg_order.begin(), seg_order.end(),
+                       [&seg_cost](const auto &a, const auto &b) { return seg_cost[a] > seg_cost[b]; });
+
+    // The counter used to assign the segments to the worker tasks.
+    // NOTE: the final value of the counter will be nsegs + n_tasks,
+    // which cannot overflow because nsegs is at most 2**(digits - 1)
+    // (see get_max_s_size()) and n_tasks is at most the concurrency
+    // of the task arena.
+    ::std::atomic<s_size_t> seg_counter(0);
+
+    // The number of worker tasks, and the vector in which
+    // we will store the time spent processing segments by each task.
+    // NOTE: the tasks which found no segment left to process
+    // (e.g., because they started late in a busy thread pool)
+    // will keep an empty time.
+    // NOTE: use the concurrency of the current task arena rather
+    // than the number of cores, so that we do not create more tasks
+    // than threads if the multiplication runs in a restricted arena.
+    const auto n_tasks = ::std::min(::obake::safe_cast<s_size_t>(::tbb::this_task_arena::max_concurrency()), nsegs);
+    ::std::vector<::std::optional<double>> task_times(static_cast<decltype(seg_cost.size())>(n_tasks));
+
     // The parallel multiplication functor for the sparse case.
     auto sparse_par_functor
-        = [&v1, &v2, &vseg1, &vseg2, nsegs, &retval, &ss, mts = retval._get_max_table_size(), &compute_end_idx2
+        = [&v1, &v2, &vseg1, &vseg2, nsegs, &ss, &compute_end_idx2, &acc_to_table, sqr, &acc_dbl, &seg_order,
+           &seg_counter, &task_times
 #if !defined(NDEBUG)
            ,
            log2_nsegs, &n_mults
 #endif
-    ](const auto &range) {
+    ](const auto &task_range) {
+              // The time spent processing segments in this task.
+              double busy_time = 0;
+              s_size_t n_proc = 0;
+
               // Cache the pointers to the terms data.
               // NOTE: doing it here rather than in the lambda
               // capture seems to help performance on GCC.
@@ -1261,12 +2663,17 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
               // Temporary variable used in monomial multiplication.
               ret_key_t tmp_key(ss);
 
+              // The accumulation table. It will be re-used
+              // for all the segments processed by this task.
+              acc_table_t acc;
+
               // Cache begin/end interators into vseg2.
               const auto vseg2_begin = vseg2.begin(), vseg2_end = vseg2.end();
 
-              for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
-                  // Get a reference to the current table in retval.
-                  auto &table = retval._get_s_table()[seg_idx];
+              // Fetch segments until there are none left.
+              for (s_size_t k; (k = seg_counter.fetch_add(1u, ::std::memory_order_relaxed)) < nsegs;) {
+                  const auto seg_idx = seg_order[k];
+                  const auto seg_start = ::std::chrono::steady_clock::now();
 
                   // The iterator in vseg2 that we will use
                   // as the end point in the binary search below.
@@ -1326,29 +2733,46 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                       // Unpack in local variables.
                       const auto &r2 = *it;
                       const auto [r2_start, r2_end, bi2] = r2;
-                      ::obake::detail::ignore(r2_end, bi2);
+                      ::obake::detail::ignore(r2_end);
+
+                      // In squaring mode, skip the pairs of ranges with
+                      // bi2 < bi1: their products are accounted for
+                      // by the symmetric pairs.
+                      if (sqr && bi2 < bi1) {
+                          continue;
+                      }
+
+                      // Diagonal flag: in squaring mode, r1 and r2
+                      // may be the same range.
+                      const auto diag = sqr && bi1 == bi2;
 
                       // The O(N**2) multiplication loop over the ranges.
                       for (auto idx1 = r1_start; idx1 != r1_end; ++idx1) {
-                          const auto &[k1, c1] = *(vptr1 + idx1);
+                          const auto &[k1, c1] = **(vptr1 + idx1);
 
                           // Compute the end index in the second range
                           // for the current value of idx1.
                           const auto idx_end2 = compute_end_idx2(idx1, r2);
 
+                          // Compute the begin index in the second range. This is
+                          // the beginning of r2, unless we are on the diagonal
+                          // in squaring mode (in which case we start from idx1).
+                          const auto idx_begin2
+                              = diag ? static_cast<remove_cvref_t<decltype(r2_start)>>(idx1) : r2_start;
+
                           // In the truncated case, check if the end index
-                          // coincides with the begin index. In such a case,
+                          // is not greater than the begin index. In such a case,
                           // we can skip all the remaining indices in r1 because
                           // none of them will ever generate a term which respects
                           // the truncation limits (both r1 and r2 are sorted
                           // according to the degree).
-                          if (sizeof...(Args) > 0u && idx_end2 == r2_start) {
+                          if (sizeof...(Args) > 0u && idx_end2 <= idx_begin2) {
                               break;
                           }
 
-                          const auto end2 = vptr2 + idx_end2;
-                          for (auto ptr2 = vptr2 + r2_start; ptr2 != end2; ++ptr2) {
-                              const auto &[k2, c2] = *ptr2;
+                          const auto begin2 = vptr2 + idx_begin2, end2 = vptr2 + idx_end2;
+                          for (auto ptr2 = begin2; ptr2 != end2; ++ptr2) {
+                              const auto &[k2, c2] = **ptr2;
 
                               // Do the monomial multiplication.
                               ::obake::monomial_mul(tmp_key, k1, k2, ss);
@@ -1356,37 +2780,34 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                               // Check that the result ends up in the correct bucket.
                               assert(::obake::hash(tmp_key) % (s_size_t(1) << log2_nsegs) == seg_idx);
 
-                              // Attempt the insertion.
-                              // NOTE: this will attempt to insert a term with a default-constructed
-                              // coefficient. This is wasteful, it would be better to directly
-                              // construct the coefficient product only if the insertion actually
-                              // takes place (using a lazy multiplication approach).
-                              // Unfortunately, abseil's hash map is not exception safe,
-                              // and if the lazy multiplication throws, the table will be left
-                              // in an inconsistent state. See:
-                              // https://github.com/abseil/abseil-cpp/issues/388
-                              // See the commit
-                              // 3e334f560d5844f5f2d8face05aa58be21649ff8
-                              // for an implementation of the lazy multiplication approach.
-                              // If they fix the exception safety issue, we can re-enable the
-                              // lazy approach.
-                              // NOTE: the coefficient concept demands default constructibility,
-                              // thus we can always emplace without arguments for the coefficient.
-                              const auto res = table.try_emplace(tmp_key);
+                              if (sqr && (!diag || ptr2 != begin2)) {
+                                  // Off-diagonal product in squaring mode.
+                                  acc_dbl(acc, tmp_key, c1, c2);
+
+#if !defined(NDEBUG)
+                                  n_mults += 2u;
+#endif
+
+                                  continue;
+                              }
+
+                              // Attempt the insertion into the accumulation table.
+                              // NOTE: the product c1 * c2 is computed and constructed
+                              // in place only if the insertion actually takes place.
+                              // The accumulation table is exception safe, thus this is
+                              // fine even if the coefficient multiplication throws.
+                              const auto res = acc.lazy_emplace(tmp_key, [&c1, &c2]() { return c1 * c2; });
 
                               // NOTE: optimise with likely/unlikely here?
-                              if (res.second) {
-                                  // NOTE: coefficients are guaranteed to be move-assignable.
-                                  res.first->second = c1 * c2;
-                              } else {
+                              if (!res.second) {
                                   // The insertion failed, a term with the same monomial
                                   // exists already. Accumulate c1*c2 into the
                                   // existing coefficient.
                                   // NOTE: do it with fma3(), if possible.
                                   if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
-                                      ::obake::fma3(res.first->second, c1, c2);
+                                      ::obake::fma3(*res.first, c1, c2);
                                   } else {
-                                      res.first->second += c1 * c2;
+                                      *res.first += c1 * c2;
                                   }
                               }
 
@@ -1397,42 +2818,34 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                       }
                   }
 
-                  // Locate and erase terms with zero coefficients
-                  // in the current table.
-                  const auto it_f = table.end();
-                  for (auto it = table.begin(); it != it_f;) {
-                      // NOTE: abseil's flat_hash_map returns void on erase(),
-                      // thus we need to increase 'it' before possibly erasing.
-                      // erase() does not cause rehash and thus will not invalidate
-                      // any other iterator apart from the one being erased.
-                      if (obake_unlikely(::obake::is_zero(::std::as_const(it->second)))) {
-                          table.erase(it++);
-                      } else {
-                          ++it;
-                      }
-                  }
+                  // Move the accumulated terms into the current table.
+                  acc_to_table(acc, seg_idx);
 
-                  // LCOV_EXCL_START
-                  // Check the table size against the max allowed size.
-                  if (obake_unlikely(table.size() > mts)) {
-                      obake_throw(::std::overflow_error, "The homomorphic multithreaded multiplication of two "
-                                                         "polynomials resulted in a table whose size ("
-                                                             + ::obake::detail::to_string(table.size())
-                                                             + ") is larger than the maximum allowed value ("
-                                                             + ::obake::detail::to_string(mts) + ")");
-                  }
-                  // LCOV_EXCL_STOP
+                  busy_time
+                      += ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - seg_start).count();
+                  ++n_proc;
+              }
+
+              // Record the busy time of this task, if it
+              // processed at least one segment.
+              if (n_proc > 0u) {
+                  task_times[task_range.begin()] = busy_time;
               }
           };
 
     // The parallel multiplication functor for the dense case.
     auto dense_par_functor
-        = [&v1, &v2, &vseg1, &vseg2, nsegs, &retval, &ss, mts = retval._get_max_table_size(), &compute_end_idx2
+        = [&v1, &v2, &vseg1, &vseg2, nsegs, &ss, &compute_end_idx2, &acc_to_table, sqr, &acc_dbl, &seg_order,
+           &seg_counter, &task_times
 #if !defined(NDEBUG)
            ,
            log2_nsegs, &n_mults
 #endif
-    ](const auto &range) {
+    ](const auto &task_range) {
+              // The time spent processing segments in this task.
+              double busy_time = 0;
+              s_size_t n_proc = 0;
+
               // Cache the pointers to the terms data.
               // NOTE: doing it here rather than in the lambda
               // capture seems to help performance on GCC.
@@ -1442,9 +2855,14 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
               // Temporary variable used in monomial multiplication.
               ret_key_t tmp_key(ss);
 
-              for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
-                  // Get a reference to the current table in retval.
-                  auto &table = retval._get_s_table()[seg_idx];
+              // The accumulation table. It will be re-used
+              // for all the segments processed by this task.
+              acc_table_t acc;
+
+              // Fetch segments until there are none left.
+              for (s_size_t k; (k = seg_counter.fetch_add(1u, ::std::memory_order_relaxed)) < nsegs;) {
+                  const auto seg_idx = seg_order[k];
+                  const auto seg_start = ::std::chrono::steady_clock::now();
 
                   // The objective here is to perform all term-by-term multiplications
                   // whose results end up in the current table (i.e., the table in retval
@@ -1458,6 +2876,17 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                       const auto j = seg_idx >= i ? (seg_idx - i) : (nsegs - i + seg_idx);
                       assert(j < vseg2.size());
 
+                      // In squaring mode, skip the pairs of ranges with
+                      // j < i: their products are accounted for
+                      // by the symmetric pairs.
+                      if (sqr && j < i) {
+                          continue;
+                      }
+
+                      // Diagonal flag: in squaring mode, the ranges
+                      // may be the same range.
+                      const auto diag = sqr && i == j;
+
                       // Fetch the corresponding ranges.
                       const auto [r1_start, r1_end, bi1] = vseg1[i];
                       const auto &r2 = vseg2[j];
@@ -1473,25 +2902,31 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
 
                       // The O(N**2) multiplication loop over the ranges.
                       for (auto idx1 = r1_start; idx1 != r1_end; ++idx1) {
-                          const auto &[k1, c1] = *(vptr1 + idx1);
+                          const auto &[k1, c1] = **(vptr1 + idx1);
 
                           // Compute the end index in the second range
                           // for the current value of idx1.
                           const auto idx_end2 = compute_end_idx2(idx1, r2);
 
+                          // Compute the begin index in the second range. This is
+                          // the beginning of r2, unless we are on the diagonal
+                          // in squaring mode (in which case we start from idx1).
+                          const auto idx_begin2
+                              = diag ? static_cast<remove_cvref_t<decltype(r2_start)>>(idx1) : r2_start;
+
                           // In the truncated case, check if the end index
-                          // coincides with the begin index. In such a case,
+                          // is not greater than the begin index. In such a case,
                           // we can skip all the remaining indices in r1 because
                           // none of them will ever generate a term which respects
                           // the truncation limits (both r1 and r2 are sorted
                           // according to the degree).
-                          if (sizeof...(Args) > 0u && idx_end2 == r2_start) {
+                          if (sizeof...(Args) > 0u && idx_end2 <= idx_begin2) {
                               break;
                           }
 
-                          const auto end2 = vptr2 + idx_end2;
-                          for (auto ptr2 = vptr2 + r2_start; ptr2 != end2; ++ptr2) {
-                              const auto &[k2, c2] = *ptr2;
+                          const auto begin2 = vptr2 + idx_begin2, end2 = vptr2 + idx_end2;
+                          for (auto ptr2 = begin2; ptr2 != end2; ++ptr2) {
+                              const auto &[k2, c2] = **ptr2;
 
                               // Do the monomial multiplication.
                               ::obake::monomial_mul(tmp_key, k1, k2, ss);
@@ -1499,37 +2934,34 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                               // Check that the result ends up in the correct bucket.
                               assert(::obake::hash(tmp_key) % (s_size_t(1) << log2_nsegs) == seg_idx);
 
-                              // Attempt the insertion.
-                              // NOTE: this will attempt to insert a term with a default-constructed
-                              // coefficient. This is wasteful, it would be better to directly
-                              // construct the coefficient product only if the insertion actually
-                              // takes place (using a lazy multiplication approach).
-                              // Unfortunately, abseil's hash map is not exception safe,
-                              // and if the lazy multiplication throws, the table will be left
-                              // in an inconsistent state. See:
-                              // https://github.com/abseil/abseil-cpp/issues/388
-                              // See the commit
-                              // 3e334f560d5844f5f2d8face05aa58be21649ff8
-                              // for an implementation of the lazy multiplication approach.
-                              // If they fix the exception safety issue, we can re-enable the
-                              // lazy approach.
-                              // NOTE: the coefficient concept demands default constructibility,
-                              // thus we can always emplace without arguments for the coefficient.
-                              const auto res = table.try_emplace(tmp_key);
+                              if (sqr && (!diag || ptr2 != begin2)) {
+                                  // Off-diagonal product in squaring mode.
+                                  acc_dbl(acc, tmp_key, c1, c2);
+
+#if !defined(NDEBUG)
+                                  n_mults += 2u;
+#endif
+
+                                  continue;
+                              }
+
+                              // Attempt the insertion into the accumulation table.
+                              // NOTE: the product c1 * c2 is computed and constructed
+                              // in place only if the insertion actually takes place.
+                              // The accumulation table is exception safe, thus this is
+                              // fine even if the coefficient multiplication throws.
+                              const auto res = acc.lazy_emplace(tmp_key, [&c1, &c2]() { return c1 * c2; });
 
                               // NOTE: optimise with likely/unlikely here?
-                              if (res.second) {
-                                  // NOTE: coefficients are guaranteed to be move-assignable.
-                                  res.first->second = c1 * c2;
-                              } else {
+                              if (!res.second) {
                                   // The insertion failed, a term with the same monomial
                                   // exists already. Accumulate c1*c2 into the
                                   // existing coefficient.
                                   // NOTE: do it with fma3(), if possible.
                                   if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
-                                      ::obake::fma3(res.first->second, c1, c2);
+                                      ::obake::fma3(*res.first, c1, c2);
                                   } else {
-                                      res.first->second += c1 * c2;
+                                      *res.first += c1 * c2;
                                   }
                               }
 
@@ -1540,43 +2972,35 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
                       }
                   }
 
-                  // Locate and erase terms with zero coefficients
-                  // in the current table.
-                  const auto it_f = table.end();
-                  for (auto it = table.begin(); it != it_f;) {
-                      // NOTE: abseil's flat_hash_map returns void on erase(),
-                      // thus we need to increase 'it' before possibly erasing.
-                      // erase() does not cause rehash and thus will not invalidate
-                      // any other iterator apart from the one being erased.
-                      if (obake_unlikely(::obake::is_zero(::std::as_const(it->second)))) {
-                          table.erase(it++);
-                      } else {
-                          ++it;
-                      }
-                  }
+                  // Move the accumulated terms into the current table.
+                  acc_to_table(acc, seg_idx);
 
-                  // LCOV_EXCL_START
-                  // Check the table size against the max allowed size.
-                  if (obake_unlikely(table.size() > mts)) {
-                      obake_throw(::std::overflow_error, "The homomorphic multithreaded multiplication of two "
-                                                         "polynomials resulted in a table whose size ("
-                                                             + ::obake::detail::to_string(table.size())
-                                                             + ") is larger than the maximum allowed value ("
-                                                             + ::obake::detail::to_string(mts) + ")");
-                  }
-                  // LCOV_EXCL_STOP
+                  busy_time
+                      += ::std::chrono::duration<double>(::std::chrono::steady_clock::now() - seg_start).count();
+                  ++n_proc;
+              }
+
+              // Record the busy time of this task, if it
+              // processed at least one segment.
+              if (n_proc > 0u) {
+                  task_times[task_range.begin()] = busy_time;
               }
           };
 
     try {
+        // NOTE: each worker task is a range of size 1 (i.e., the
+        // task index), and it will fetch segments to process
+        // from seg_counter.
         if (vseg1.size() == nsegs && vseg2.size() == nsegs) {
             // Both vseg1 and vseg2 are represented in dense
             // form, run the dense functor.
-            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), dense_par_functor);
+            detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, n_tasks, 1), dense_par_functor,
+                                 ::tbb::simple_partitioner());
         } else {
             // At least one of vseg1/vseg2 are represented
             // in sparse form, run the sparse functor.
-            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), sparse_par_functor);
+            detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, n_tasks, 1), sparse_par_functor,
+                                 ::tbb::simple_partitioner());
         }
 
 #if !defined(NDEBUG)
@@ -1595,6 +3019,36 @@ inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args
         throw;
         // LCOV_EXCL_STOP
     }
+
+    // Compute the load imbalance as the ratio between the
+    // maximum and the average busy time of the worker tasks
+    // which processed at least one segment.
+    ret.seg_size = static_cast<::std::size_t>(seg_size);
+    ret.n_segments = static_cast<::std::size_t>(nsegs);
+    double tot_time = 0, max_time = 0;
+    ::std::size_t n_active = 0;
+    for (const auto &t : task_times) {
+        if (t) {
+            tot_time += *t;
+            max_time = ::std::max(max_time, *t);
+            ++n_active;
+        }
+    }
+    if (tot_time > 0) {
+        ret.load_imbalance = max_time / (tot_time / static_cast<double>(n_active));
+    }
+
+    return ret;
+}
+
+// The multi-threaded homomorphic implementation,
+// without precomputed operand data.
+template <typename Ret, typename T, typename U, typename... Args>
+inline mul_stats poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args &...args)
+{
+    return detail::poly_mul_impl_mt_hm_data(retval, x, y,
+                                            static_cast<const poly_mul_operand_data<T, Args...> *>(nullptr),
+                                            static_cast<const poly_mul_operand_data<U, Args...> *>(nullptr), args...);
 }
 
 #if defined(_MSC_VER) && !defined(__clang__)
@@ -1615,6 +3069,11 @@ struct poly_mul_impl_ptr_extractor {
 // Simple poly mult implementation: just multiply
 // term by term, no parallelisation, no segmentation,
 // no copying of the operands, etc.
+// If x and y are the same object, only the products
+// of the terms x_i * x_j with i <= j will be computed,
+// and the off-diagonal products will be accumulated twice.
+// If retval is not empty, the product will be accumulated
+// into the existing terms of retval.
 template <typename Ret, typename T, typename U, typename... Args>
 inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args &...args)
 {
@@ -1623,6 +3082,9 @@ inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args
     using cf1_t = series_cf_t<T>;
     using cf2_t = series_cf_t<U>;
 
+    // Squaring flag.
+    const auto sqr = detail::poly_mul_is_sqr(x, y);
+
     // Preconditions.
     static_assert(sizeof...(args) <= 2u);
     assert(!x.empty());
@@ -1630,7 +3092,12 @@ inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args
     assert(x.size() <= y.size());
     assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
     assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
-    assert(retval.empty());
+    if constexpr (::std::is_same_v<Ret, T>) {
+        assert(&retval != &x);
+    }
+    if constexpr (::std::is_same_v<Ret, U>) {
+        assert(&retval != &y);
+    }
     assert(retval._get_s_table().size() == 1u);
 
     // Cache the symbol set.
@@ -1811,6 +3278,14 @@ inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args
         }
     }();
 
+    // In squaring mode, v1 and v2 contain the same
+    // terms in the same order (the sorting in the truncated case
+    // is deterministic).
+    assert(!sqr
+           || ::std::equal(v1.begin(), v1.end(), v2.begin(), v2.end(), [](const auto *p1, const auto *p2) {
+                  return static_cast<const void *>(p1) == static_cast<const void *>(p2);
+              }));
+
     // Proceed with the multiplication.
     auto &tab = retval._get_s_table()[0];
 
@@ -1827,14 +3302,19 @@ inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args
             // Get the upper limit of the multiplication
             // range in v2.
             const auto j_end = compute_j_end(i);
-            if (sizeof...(Args) != 0u && j_end == 0u) {
-                // In truncated mode, if j_end is zero, we don't need to perform
-                // any more term multiplications as the remaining
-                // ones will all end up above the truncation limit.
+
+            // Get the lower limit of the multiplication range
+            // in v2 (in squaring mode, start from the diagonal).
+            const auto j_begin = sqr ? static_cast<decltype(v2.size())>(i) : decltype(v2.size())(0);
+
+            if (sizeof...(Args) != 0u && j_end <= j_begin) {
+                // In truncated mode, if j_end is not greater than j_begin,
+                // we don't need to perform any more term multiplications as the
+                // remaining ones will all end up above the truncation limit.
                 break;
             }
 
-            for (decltype(v2.size()) j = 0; j < j_end; ++j) {
+            for (auto j = j_begin; j < j_end; ++j) {
                 const auto &t2 = v2[j];
                 const auto &c2 = t2->second;
 
@@ -1847,6 +3327,21 @@ inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args
                 // this scheme (i.e., default-emplace the coefficient).
                 const auto res = tab.try_emplace(tmp_key);
 
+                if (sqr && j != i) {
+                    // Off-diagonal product in squaring mode: compute
+                    // c1*c2 once and accumulate it twice.
+                    ret_cf_t tmp(c1 * c2);
+
+                    if (res.second) {
+                        res.first->second = tmp;
+                    } else {
+                        res.first->second += ::std::as_const(tmp);
+                    }
+                    res.first->second += ::std::move(tmp);
+
+                    continue;
+                }
+
                 // NOTE: optimise with likely/unlikely here?
                 if (res.second) {
                     res.first->second = c1 * c2;
@@ -1890,10 +3385,250 @@ inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args
     }
 }
 
+// Heap-based poly mult implementation for packed monomials, in the
+// style of Monagan and Pearce. The terms of both operands are sorted
+// according to the packed values of the monomials, and the term-by-term
+// products are merged via a binary heap containing one entry per term
+// of x. Because the packing is additive and monotonic, the terms of
+// the product are produced in ascending order of packed value, and
+// each term is complete when it is produced.
+//
+// Each term of the product is passed to the functor f as a pair of
+// rvalue references to the key and coefficient. Terms with zero
+// coefficients are not passed to f.
+//
+// The memory usage is bounded by the size of the heap (i.e., the
+// size of x), plus the vectors of pointers to the terms of the operands.
+// Requires that x is not longer than y, that x and y are not empty
+// and that they have the same symbol set.
+template <typename Ret, typename T, typename U, typename F, typename... Args>
+inline void poly_mul_impl_heap_stream(const T &x, const U &y, F &&f, const Args &...args)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using cf1_t = series_cf_t<T>;
+    using cf2_t = series_cf_t<U>;
+    using value_type = typename ret_key_t::value_type;
+
+    // Preconditions.
+    static_assert(sizeof...(args) <= 2u);
+    static_assert(poly_mul_is_packed_monomial<ret_key_t>);
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(x.size() <= y.size());
+    assert(x.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    // Cache the symbol set.
+    const auto &ss = x.get_symbol_set();
+
+    // Construct the vectors of pointer to the terms.
+    ::std::vector<const series_term_t<T> *> v1(
+        ::boost::make_transform_iterator(x.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(x.end(), poly_mul_impl_ptr_extractor{}));
+    ::std::vector<const series_term_t<U> *> v2(
+        ::boost::make_transform_iterator(y.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(y.end(), poly_mul_impl_ptr_extractor{}));
+
+    // Do the monomial overflow checking.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
+    if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+        obake_throw(::std::overflow_error,
+                    "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+    }
+
+    // Sort the operands according to the packed values.
+    auto pv_sorter = [](const auto *p1, const auto *p2) { return p1->first.get_value() < p2->first.get_value(); };
+    ::std::sort(v1.begin(), v1.end(), pv_sorter);
+    ::std::sort(v2.begin(), v2.end(), pv_sorter);
+
+    // In truncated multiplication, compute the degree data.
+    // NOTE: the degrees are not monotonic with respect to the
+    // packed values, thus here we cannot cut the
+    // ranges of multiplication like in the other implementations.
+    auto degree_data = detail::poly_mul_impl_prepare_degree_data<T, U>(v1, v2, ss, args...);
+    if constexpr (sizeof...(args) == 1u) {
+        ::obake::detail::container_it_diff_check(v1);
+        ::obake::detail::container_it_diff_check(v2);
+
+        ::std::get<0>(degree_data) = customisation::internal::make_degree_vector<T>(v1.cbegin(), v1.cend(), ss, false);
+        ::std::get<1>(degree_data) = customisation::internal::make_degree_vector<U>(v2.cbegin(), v2.cend(), ss, false);
+    } else if constexpr (sizeof...(args) == 2u) {
+        ::obake::detail::container_it_diff_check(v1);
+        ::obake::detail::container_it_diff_check(v2);
+
+        const auto &s = ::std::get<1>(::std::forward_as_tuple(args...));
+
+        ::std::get<0>(degree_data)
+            = customisation::internal::make_p_degree_vector<T>(v1.cbegin(), v1.cend(), ss, s, false);
+        ::std::get<1>(degree_data)
+            = customisation::internal::make_p_degree_vector<U>(v2.cbegin(), v2.cend(), ss, s, false);
+    }
+
+    // The heap. Each item contains the packed value
+    // of the product of the terms v1[i] and v2[j], and
+    // the indices i and j.
+    using idx1_t = decltype(v1.size());
+    using idx2_t = decltype(v2.size());
+    struct heap_item {
+        value_type value;
+        idx1_t i;
+        idx2_t j;
+    };
+    // NOTE: std::push/pop_heap() build max heaps,
+    // hence use the reverse comparison.
+    auto heap_cmp = [](const heap_item &a, const heap_item &b) { return a.value > b.value; };
+
+    // NOTE: the products of the packed values are all
+    // representable thanks to the overflow check.
+    const auto v2_size = v2.size();
+    ::std::vector<heap_item> heap;
+    heap.reserve(::obake::safe_cast<decltype(heap.size())>(v1.size()));
+    for (idx1_t i = 0; i < v1.size(); ++i) {
+        heap.push_back(heap_item{static_cast<value_type>(v1[i]->first.get_value() + v2[0]->first.get_value()), i,
+                                 idx2_t(0)});
+    }
+    ::std::make_heap(heap.begin(), heap.end(), heap_cmp);
+
+    // The term currently being accumulated.
+    value_type cur_value(0);
+    ret_cf_t cur_cf;
+    bool cur_set = false;
+
+    // Helper to pass the current term to f (if its
+    // coefficient is not zero) and to reset it.
+    auto flush = [&cur_value, &cur_cf, &cur_set, &f]() {
+        if (cur_set && !::obake::is_zero(::std::as_const(cur_cf))) {
+            f(ret_key_t(cur_value), ::std::move(cur_cf));
+        }
+        cur_set = false;
+    };
+
+    while (!heap.empty()) {
+        // Extract the smallest product.
+        ::std::pop_heap(heap.begin(), heap.end(), heap_cmp);
+        auto &top = heap.back();
+        const auto value = top.value;
+        const auto i = top.i;
+        const auto j = top.j;
+
+        if (value != cur_value) {
+            // A new monomial, flush the current term.
+            flush();
+            cur_value = value;
+        }
+
+        // In truncated multiplication, skip the
+        // products exceeding the truncation limit.
+        bool skip = false;
+        if constexpr (sizeof...(args) > 0u) {
+            const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+            const auto &[vd1, vd2] = degree_data;
+
+            // NOTE: we require below comparability between const lvalue
+            // limit and rvalue of the sum of the degrees.
+            skip = max_deg < vd1[i] + vd2[j];
+        }
+
+        if (!skip) {
+            const auto &c1 = v1[i]->second;
+            const auto &c2 = v2[j]->second;
+
+            if (cur_set) {
+                if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
+                    ::obake::fma3(cur_cf, c1, c2);
+                } else {
+                    cur_cf += c1 * c2;
+                }
+            } else {
+                cur_cf = c1 * c2;
+                cur_set = true;
+            }
+        }
+
+        // Replace the extracted item with the next
+        // product from the same term of v1, if any.
+        if (j + 1u < v2_size) {
+            top.j = j + 1u;
+            top.value = static_cast<value_type>(v1[i]->first.get_value() + v2[j + 1u]->first.get_value());
+            ::std::push_heap(heap.begin(), heap.end(), heap_cmp);
+        } else {
+            heap.pop_back();
+        }
+    }
+
+    // Flush the last term.
+    flush();
+}
+
+// Heap-based poly mult implementation writing the
+// result into retval. See poly_mul_impl_heap_stream()
+// for the details.
+template <typename Ret, typename T, typename U, typename... Args>
+inline void poly_mul_impl_heap(Ret &retval, const T &x, const U &y, const Args &...args)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+
+    // Preconditions.
+    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
+    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
+    assert(retval.empty());
+    assert(retval._get_s_table().size() == 1u);
+
+    auto &tab = retval._get_s_table()[0];
+
+    try {
+        detail::poly_mul_impl_heap_stream<Ret>(
+            x, y,
+            [&tab](ret_key_t &&k, ret_cf_t &&c) {
+                // NOTE: the keys are produced in ascending
+                // order, thus they are unique.
+                [[maybe_unused]] const auto res = tab.try_emplace(::std::move(k), ::std::move(c));
+                assert(res.second);
+            },
+            args...);
+
+        // NOTE: no need to check the table size, as retval
+        // is not segmented.
+        // LCOV_EXCL_START
+    } catch (...) {
+        tab.clear();
+        throw;
+        // LCOV_EXCL_STOP
+    }
+}
+
+// Helper to establish if the automatic engine selection
+// should run the simple implementation for the product of x and y.
+// This will be the case if either:
+// - both polys have only 1 term, or
+// - the maximum operand size is less than the threshold
+//   value from the policy pol, or
+// - we have just 1 core.
+template <typename T, typename U>
+inline bool poly_mul_impl_auto_simple(const T &x, const U &y, const mul_policy &pol)
+{
+    if (x.size() == 1u && y.size() == 1u) {
+        return true;
+    }
+
+    // Establish the max byte size of the input series.
+    const auto max_bs = ::std::max(::obake::byte_size(x), ::obake::byte_size(y));
+
+    return max_bs < pol.simple_threshold || ::obake::detail::hc() == 1u;
+}
+
 // Implementation of poly multiplication with identical symbol sets.
-// Requires that x is not longer than y.
-template <typename T, typename U, typename... Args>
-inline auto poly_mul_impl_identical_ss(const T &x, const U &y, const Args &...args)
+// Requires that x is not longer than y. d1 and d2 are optional
+// pointers to the precomputed operand data of x and y, which
+// will be used by the multi-threaded implementation.
+template <typename T, typename U, typename D1, typename D2, typename... Args>
+inline auto poly_mul_impl_identical_ss_data(const T &x, const U &y, const D1 *d1, const D2 *d2, const Args &...args)
 {
     using ret_t = poly_mul_ret_t<T, U>;
     using ret_key_t = series_key_t<ret_t>;
@@ -1911,6 +3646,12 @@ inline auto poly_mul_impl_identical_ss(const T &x, const U &y, const Args &...ar
         return retval;
     }
 
+    // The statistics of the multiplication.
+    mul_stats stats;
+
+    // Fetch the multiplication policy.
+    const auto pol = ::obake::polynomials::get_mul_policy();
+
     if constexpr (::std::conjunction_v<is_homomorphically_hashable_monomial<ret_key_t>,
                                        // Need also to be able to measure the byte size
                                        // of x, y, and the key/cf of ret_t, via const lvalue references.
@@ -1923,28 +3664,67 @@ inline auto poly_mul_impl_identical_ss(const T &x, const U &y, const Args &...ar
         // Homomorphic hashing is available, we can run
         // the multi-threaded implementation.
 
-        // Establish the max byte size of the input series.
-        const auto max_bs = ::std::max(::obake::byte_size(x), ::obake::byte_size(y));
+        // Fetch the engine requested by the policy. The heap-based
+        // engine is available only for packed monomials.
+        auto req_engine = pol.engine;
+        if (req_engine == mul_engine::heap && !poly_mul_is_packed_monomial<ret_key_t>) {
+            req_engine = mul_engine::automatic;
+        }
 
-        if ((x.size() == 1u && y.size() == 1u) || max_bs < 30000ul || ::obake::detail::hc() == 1u) {
-            // Run the simple implementation if either:
-            // - both polys have only 1 term, or
-            // - the maximum operand size is less than a threshold value, or
-            // - we have just 1 core.
-            detail::poly_mul_impl_simple(retval, x, y, args...);
-        } else {
-            // Otherwise, run the MT implementation.
-            detail::poly_mul_impl_mt_hm(retval, x, y, args...);
+        switch (req_engine) {
+            case mul_engine::simple:
+                detail::poly_mul_impl_simple(retval, x, y, args...);
+                stats.engine = mul_engine::simple;
+                break;
+            case mul_engine::hash:
+            case mul_engine::dense:
+                stats = detail::poly_mul_impl_mt_hm_data(retval, x, y, d1, d2, args...);
+                break;
+            case mul_engine::heap:
+                if constexpr (poly_mul_is_packed_monomial<ret_key_t>) {
+                    detail::poly_mul_impl_heap(retval, x, y, args...);
+                    stats.engine = mul_engine::heap;
+                }
+                break;
+            default: {
+                // Automatic selection.
+                if (detail::poly_mul_impl_auto_simple(x, y, pol)) {
+                    detail::poly_mul_impl_simple(retval, x, y, args...);
+                    stats.engine = mul_engine::simple;
+                } else {
+                    // Otherwise, run the MT implementation.
+                    stats = detail::poly_mul_impl_mt_hm_data(retval, x, y, d1, d2, args...);
+                }
+            }
         }
     } else {
         // The monomial does not have homomorphic hashing,
         // just use the simple implementation.
+        ::obake::detail::ignore(d1, d2);
         detail::poly_mul_impl_simple(retval, x, y, args...);
+        stats.engine = mul_engine::simple;
     }
 
+    // Record the statistics.
+    // NOTE: this is done at the very end, so that the statistics
+    // of the multiplications possibly performed on the
+    // coefficients are overwritten.
+    stats.policy = pol;
+    stats.n_terms = static_cast<::std::size_t>(retval.size());
+    detail::mul_stats_tls() = stats;
+
     return retval;
 }
 
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_impl_identical_ss(const T &x, const U &y, const Args &...args)
+{
+    return detail::poly_mul_impl_identical_ss_data(x, y,
+                                                   static_cast<const poly_mul_operand_data<T, Args...> *>(nullptr),
+                                                   static_cast<const poly_mul_operand_data<U, Args...> *>(nullptr),
+                                                   args...);
+}
+
 // Top level function for poly multiplication. Requires that
 // x is not longer than y.
 // NOTE: future improvements:
@@ -1958,9 +3738,11 @@ inline auto poly_mul_impl_identical_ss(const T &x, const U &y, const Args &...ar
 //   would be computing the degree vectors at the beginning and then
 //   we would need to sort them for segmentation purposes). It's not
 //   clear to me if this is worth it at this time, need to profile;
-// - in highly rectangular multiplications, quite a bit of time
-//   is spent copying the larger operand into a vector of terms.
-//   Perhaps this could be parallelised for segmented series?
+// - the multithreaded implementation operates on vectors of
+//   pointers to the terms of the operands (built in parallel over
+//   the tables of the operands), thus the terms are never copied.
+//   The price to pay is an extra indirection in the inner
+//   multiplication loops;
 // - in highly rectangular multiplications, the series size
 //   estimation is quite poor (see comments on top of the
 //   function). Not sure what we could do about it;
@@ -1979,8 +3761,8 @@ inline auto poly_mul_impl(const T &x, const U &y, const Args &...args)
         return detail::poly_mul_impl_identical_ss(x, y, args...);
     } else {
         // Merge the symbol sets.
-        const auto &[merged_ss, ins_map_x, ins_map_y]
-            = ::obake::detail::merge_symbol_sets(x.get_symbol_set(), y.get_symbol_set());
+        const auto ms_res = ::obake::detail::merge_symbol_sets_fw(x.get_symbol_set_fw(), y.get_symbol_set_fw());
+        const auto &[merged_ss, ins_map_x, ins_map_y] = *ms_res;
 
         // The insertion maps cannot be both empty, as we already handled
         // the identical symbol sets case above.
@@ -1998,7 +3780,7 @@ inline auto poly_mul_impl(const T &x, const U &y, const Args &...args)
                 // x already has the correct symbol
                 // set, extend only y.
                 U b;
-                b.set_symbol_set(merged_ss);
+                b.set_symbol_set_fw(merged_ss);
                 ::obake::detail::series_sym_extender(b, y, ins_map_y);
 
                 return detail::poly_mul_impl_identical_ss(x, ::std::move(b), args...);
@@ -2007,7 +3789,7 @@ inline auto poly_mul_impl(const T &x, const U &y, const Args &...args)
                 // y already has the correct symbol
                 // set, extend only x.
                 T a;
-                a.set_symbol_set(merged_ss);
+                a.set_symbol_set_fw(merged_ss);
                 ::obake::detail::series_sym_extender(a, x, ins_map_x);
 
                 return detail::poly_mul_impl_identical_ss(::std::move(a), y, args...);
@@ -2017,8 +3799,8 @@ inline auto poly_mul_impl(const T &x, const U &y, const Args &...args)
         // Both x and y need to be extended.
         T a;
         U b;
-        a.set_symbol_set(merged_ss);
-        b.set_symbol_set(merged_ss);
+        a.set_symbol_set_fw(merged_ss);
+        b.set_symbol_set_fw(merged_ss);
         ::obake::detail::series_sym_extender(a, x, ins_map_x);
         ::obake::detail::series_sym_extender(b, y, ins_map_y);
 
@@ -2038,6 +3820,143 @@ inline auto poly_mul_impl_switch(const T &x, const U &y, const Args &...args)
     }
 }
 
+// Implementation of fma3() for polynomials and power series:
+// accumulate the (possibly truncated) product of x and y into acc,
+// without constructing a temporary series for the product.
+// If the symbol sets of acc, x and y differ, or if acc is
+// the same object as x or y, the product is computed
+// separately and then added to acc.
+// If a multiplication kernel throws while accumulating
+// into acc, acc will be cleared. Errors detected before
+// the accumulation starts leave acc unchanged.
+template <typename Ret, typename T, typename U, typename... Args>
+inline void poly_fma3_impl(Ret &acc, const T &x, const U &y, const Args &...args)
+{
+    using ret_key_t = series_key_t<Ret>;
+
+    static_assert(::std::is_same_v<Ret, poly_mul_ret_t<T, U>>);
+
+    // Check for aliasing between acc and the operands.
+    const auto aliased = [&acc, &x, &y]() {
+        ::obake::detail::ignore(acc, x, y);
+
+        auto ret = false;
+        if constexpr (::std::is_same_v<Ret, T>) {
+            ret = ret || &acc == &x;
+        }
+        if constexpr (::std::is_same_v<Ret, U>) {
+            ret = ret || &acc == &y;
+        }
+        return ret;
+    }();
+
+    if (aliased || acc.get_symbol_set_fw() != x.get_symbol_set_fw()
+        || x.get_symbol_set_fw() != y.get_symbol_set_fw()) {
+        acc += detail::poly_mul_impl_switch(x, y, args...);
+
+        return;
+    }
+
+    if (x.empty() || y.empty()) {
+        // Nothing to accumulate.
+        return;
+    }
+
+    // Do the monomial overflow checking, if possible, before
+    // acc is modified.
+    // NOTE: the multiplication kernels will repeat the check,
+    // whose cost is negligible wrt the multiplication.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(x.begin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(x.end(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(y.begin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(y.end(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, acc.get_symbol_set()))) {
+            obake_throw(
+                ::std::overflow_error,
+                "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        }
+    }
+
+    // The statistics of the multiplication.
+    mul_stats stats;
+
+    // Helper to run a kernel accumulating the product
+    // into acc. If the kernel throws, acc may contain
+    // a partial product: clear it before rethrowing
+    // to ensure a known sane state.
+    auto run_kernel = [&acc](const auto &f) {
+        try {
+            f();
+            // LCOV_EXCL_START
+        } catch (...) {
+            acc.clear();
+            throw;
+            // LCOV_EXCL_STOP
+        }
+    };
+
+    // Fetch the multiplication policy.
+    const auto pol = ::obake::polynomials::get_mul_policy();
+
+    // NOTE: the multiplication kernels
+    // require the shorter series first.
+    auto run = [&acc, &stats, &pol, &run_kernel, &args...](const auto &a, const auto &b) {
+        if constexpr (::std::conjunction_v<is_homomorphically_hashable_monomial<ret_key_t>,
+                                           is_size_measurable<const T &>, is_size_measurable<const U &>,
+                                           is_size_measurable<const ret_key_t &>,
+                                           is_size_measurable<const series_cf_t<Ret> &>>) {
+            // Establish if we can use the simple implementation.
+            // NOTE: the dense and heap-based engines cannot accumulate
+            // into an existing series, the hash-based engine
+            // will be used instead.
+            const auto use_simple = [&a, &b, &pol]() {
+                switch (pol.engine) {
+                    case mul_engine::simple:
+                        return true;
+                    case mul_engine::automatic:
+                        return detail::poly_mul_impl_auto_simple(a, b, pol);
+                    default:
+                        return false;
+                }
+            }();
+
+            // NOTE: the simple implementation requires
+            // a non-segmented acc.
+            if (use_simple && acc.get_s_size() == 0u) {
+                run_kernel([&]() { detail::poly_mul_impl_simple(acc, a, b, args...); });
+                stats.engine = mul_engine::simple;
+            } else {
+                run_kernel([&]() { stats = detail::poly_mul_impl_mt_hm(acc, a, b, args...); });
+            }
+        } else {
+            if (acc.get_s_size() == 0u) {
+                run_kernel([&]() { detail::poly_mul_impl_simple(acc, a, b, args...); });
+                stats.engine = mul_engine::simple;
+            } else {
+                // The monomial does not have homomorphic hashing
+                // and acc is segmented: compute the product
+                // separately.
+                acc += detail::poly_mul_impl_identical_ss(a, b, args...);
+                stats = detail::mul_stats_tls();
+            }
+        }
+    };
+
+    if (x.size() <= y.size()) {
+        run(x, y);
+    } else {
+        run(y, x);
+    }
+
+    // Record the statistics.
+    stats.policy = pol;
+    stats.n_terms = static_cast<::std::size_t>(acc.size());
+    detail::mul_stats_tls() = stats;
+}
+
 } // namespace detail
 
 template <typename K, typename C0, typename C1>
@@ -2047,6 +3966,67 @@ requires(detail::poly_mul_algo<polynomial<K, C0>, polynomial<K, C1>> != 0) inlin
     return detail::poly_mul_impl_switch(x, y);
 }
 
+// Fused multiply-add: accumulate the product of x and y into acc,
+// without constructing a temporary polynomial for the product.
+// NOTE: if the product is accumulated in place and the multiplication
+// throws after it started writing into acc, acc will be cleared via its
+// clear() member function, so the terms acc contained before the call
+// are lost. Errors detected beforehand (e.g., an overflow in the monomial
+// exponents) leave acc unchanged, and when the symbol sets differ this
+// is equivalent to acc += x * y. Callers needing the strong guarantee
+// should accumulate into a copy.
+template <typename K, typename C, typename C0, typename C1>
+requires(detail::poly_mul_algo<polynomial<K, C0>, polynomial<K, C1>> != 0
+         && ::std::is_same_v<detail::poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>>,
+                             polynomial<K, C>>) inline void fma3(polynomial<K, C> &acc, const polynomial<K, C0> &x,
+                                                                 const polynomial<K, C1> &y)
+{
+    detail::poly_fma3_impl(acc, x, y);
+}
+
+// Multiply x by y via the heap-based engine, passing each term of the product
+// to the functor f, in ascending order of packed value, as a pair of rvalue
+// references to the key and coefficient. The product is never
+// stored in memory as a whole. x and y must have the same symbol set.
+template <typename K, typename C0, typename C1, typename F>
+requires(detail::poly_mul_algo<polynomial<K, C0>, polynomial<K, C1>> != 0 && detail::poly_mul_is_packed_monomial<K>)
+inline void mul_stream(const polynomial<K, C0> &x, const polynomial<K, C1> &y, F &&f)
+{
+    using ret_t = detail::poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>>;
+
+    if (obake_unlikely(x.get_symbol_set_fw() != y.get_symbol_set_fw())) {
+        obake_throw(::std::invalid_argument, "The symbol sets of the operands of mul_stream() must be identical, but "
+                                             "instead the symbol set of the first operand is "
+                                                 + ::obake::detail::to_string(x.get_symbol_set())
+                                                 + ", while the symbol set of the second operand is "
+                                                 + ::obake::detail::to_string(y.get_symbol_set()));
+    }
+
+    if (x.empty() || y.empty()) {
+        return;
+    }
+
+    // Count the terms passed to f, for the statistics.
+    ::std::size_t n_terms = 0;
+    auto wrapper = [&f, &n_terms](auto &&k, auto &&c) {
+        f(::std::move(k), ::std::move(c));
+        ++n_terms;
+    };
+
+    // NOTE: the heap-based engine requires the shorter operand first.
+    if (x.size() <= y.size()) {
+        detail::poly_mul_impl_heap_stream<ret_t>(x, y, wrapper);
+    } else {
+        detail::poly_mul_impl_heap_stream<ret_t>(y, x, wrapper);
+    }
+
+    mul_stats stats;
+    stats.engine = mul_engine::heap;
+    stats.policy = ::obake::polynomials::get_mul_policy();
+    stats.n_terms = n_terms;
+    detail::mul_stats_tls() = stats;
+}
+
 namespace detail
 {
 
@@ -2146,6 +4126,153 @@ requires(detail::poly_mul_truncated_p_degree_algo<polynomial<K, C0>, polynomial<
 namespace detail
 {
 
+// Implementation of the one-to-many poly multiplication.
+// The products x * ys[i] are computed in parallel. If x needs
+// to be extended to a larger symbol set in order to be multiplied
+// by some of the polynomials in ys, the extension is computed
+// only once for each distinct merged symbol set (rather than
+// once per product). Likewise, the data about x needed by the
+// multi-threaded multiplication (the vector of pointers to the terms,
+// the degrees of the terms and the subset of terms for the overflow
+// check) is computed only once for each (possibly extended) version
+// of x, and then reused in all the products.
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_many_impl(const T &x, const ::std::vector<U> &ys, const Args &...args)
+{
+    using ret_t = poly_mul_ret_t<T, U>;
+    using size_type = typename ::std::vector<U>::size_type;
+    using data_t = poly_mul_operand_data<T, Args...>;
+
+    // The (possibly extended) versions of x, each paired
+    // to its operand data.
+    // NOTE: use a node-based container, so that
+    // the pointers in xptrs are never invalidated.
+    ::std::map<symbol_set, ::std::pair<T, data_t>> x_ext;
+
+    // Prepare the vectors of pointers to the versions of x
+    // (and to their operand data) to be used in each product,
+    // and the results of the symbol set merges.
+    ::std::vector<const T *> xptrs(ys.size(), &x);
+    ::std::vector<const data_t *> dptrs(ys.size(), nullptr);
+    ::std::vector<::std::shared_ptr<const ::obake::detail::ss_merge_result>> ms_res(ys.size());
+
+    // The operand data for x itself, computed
+    // only if actually needed.
+    ::std::optional<data_t> x_data;
+
+    for (size_type i = 0; i < ys.size(); ++i) {
+        const auto &y = ys[i];
+
+        if (y.get_symbol_set_fw() != x.get_symbol_set_fw()) {
+            ms_res[i] = ::obake::detail::merge_symbol_sets_fw(x.get_symbol_set_fw(), y.get_symbol_set_fw());
+            const auto &[merged_ss, ins_map_x, ins_map_y] = *ms_res[i];
+            ::obake::detail::ignore(ins_map_y);
+
+            if (!ins_map_x.empty()) {
+                auto it = x_ext.find(merged_ss.get());
+                if (it == x_ext.end()) {
+                    T a;
+                    a.set_symbol_set_fw(merged_ss);
+                    ::obake::detail::series_sym_extender(a, x, ins_map_x);
+
+                    auto d = detail::poly_mul_impl_make_operand_data(a, args...);
+
+                    it = x_ext.emplace(merged_ss.get(), ::std::make_pair(::std::move(a), ::std::move(d))).first;
+                }
+                xptrs[i] = &it->second.first;
+                dptrs[i] = &it->second.second;
+
+                continue;
+            }
+        }
+
+        // x does not need to be extended (y might
+        // be, in the product loop below).
+        if (!x_data) {
+            x_data.emplace(detail::poly_mul_impl_make_operand_data(x, args...));
+        }
+        dptrs[i] = &*x_data;
+    }
+
+    // Run the products.
+    // NOTE: each product is parallelised internally as well,
+    // the nested parallelism is handled by TBB.
+    ::std::vector<ret_t> retval;
+    retval.resize(ys.size());
+    detail::poly_par_for(::tbb::blocked_range<size_type>(0, ys.size(), 1),
+                         [&retval, &xptrs, &dptrs, &ms_res, &ys, &args...](const auto &range) {
+                             for (auto i = range.begin(); i != range.end(); ++i) {
+                                 const auto &a = *xptrs[i];
+                                 const auto *d = dptrs[i];
+
+                                 // Helper to run the product of a by b, which
+                                 // must have the same symbol set.
+                                 // NOTE: the multiplication kernels
+                                 // require the shorter series first.
+                                 auto run = [&a, d, &args...](const U &b) {
+                                     if (a.size() <= b.size()) {
+                                         return detail::poly_mul_impl_identical_ss_data(
+                                             a, b, d, static_cast<const poly_mul_operand_data<U, Args...> *>(nullptr),
+                                             args...);
+                                     } else {
+                                         return detail::poly_mul_impl_identical_ss_data(
+                                             b, a, static_cast<const poly_mul_operand_data<U, Args...> *>(nullptr), d,
+                                             args...);
+                                     }
+                                 };
+
+                                 if (a.get_symbol_set_fw() == ys[i].get_symbol_set_fw()) {
+                                     retval[i] = run(ys[i]);
+                                 } else {
+                                     // Extend ys[i] to the symbol set of a.
+                                     const auto &ins_map_y = ::std::get<2>(*ms_res[i]);
+                                     assert(!ins_map_y.empty());
+
+                                     U b;
+                                     b.set_symbol_set_fw(a.get_symbol_set_fw());
+                                     ::obake::detail::series_sym_extender(b, ys[i], ins_map_y);
+
+                                     retval[i] = run(b);
+                                 }
+                             }
+                         });
+
+    return retval;
+}
+
+} // namespace detail
+
+// One-to-many multiplication: compute the products of x by each polynomial
+// in ys (optionally truncated), returning them in a vector.
+template <typename K, typename C0, typename C1>
+requires(detail::poly_mul_algo<polynomial<K, C0>, polynomial<K, C1>> != 0) inline ::std::vector<
+    detail::poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>>> mul_many(const polynomial<K, C0> &x,
+                                                                           const ::std::vector<polynomial<K, C1>> &ys)
+{
+    return detail::poly_mul_many_impl(x, ys);
+}
+
+template <typename K, typename C0, typename C1, typename V>
+requires(detail::poly_mul_truncated_degree_algo<polynomial<K, C0>, polynomial<K, C1>, V> != 0) inline ::std::vector<
+    detail::poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>>> mul_many(const polynomial<K, C0> &x,
+                                                                           const ::std::vector<polynomial<K, C1>> &ys,
+                                                                           const V &max_degree)
+{
+    return detail::poly_mul_many_impl(x, ys, max_degree);
+}
+
+template <typename K, typename C0, typename C1, typename V>
+requires(detail::poly_mul_truncated_p_degree_algo<polynomial<K, C0>, polynomial<K, C1>, V> != 0) inline ::std::vector<
+    detail::poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>>> mul_many(const polynomial<K, C0> &x,
+                                                                           const ::std::vector<polynomial<K, C1>> &ys,
+                                                                           const V &max_degree, const symbol_set &s)
+{
+    return detail::poly_mul_many_impl(x, ys, max_degree, s);
+}
+
+namespace detail
+{
+
 // Implementation of the specialised pow() implementation
 // for polynomials.
 template <typename T, typename U>
@@ -2157,49 +4284,186 @@ inline auto pow_poly_impl(T &&x, U &&y)
     using rU = remove_cvref_t<U>;
     using key_t = series_key_t<rT>;
 
-    if constexpr (is_exponentiable_monomial_v<const key_t &, const rU &>) {
-        if (x.size() == 1u) {
-            // The polynomial has a single term, we can proceed
-            // with the monomial exponentiation.
+    if constexpr (is_exponentiable_monomial_v<const key_t &, const rU &>) {
+        if (x.size() == 1u) {
+            // The polynomial has a single term, we can proceed
+            // with the monomial exponentiation.
+
+            // Build the return value.
+            ret_t retval;
+            retval.set_symbol_set_fw(x.get_symbol_set_fw());
+            // NOTE: we do coefficient and monomial exponentiation using
+            // const refs everywhere (thus, we ensure that y is not mutated
+            // after one exponentiation). Regarding coefficient exponentiation,
+            // we checked in the default implementation that it is supported
+            // via const lvalue refs.
+            const auto it = x.cbegin();
+            retval.add_term(::obake::monomial_pow(it->first, ::std::as_const(y), x.get_symbol_set()),
+                            ::obake::pow(it->second, ::std::as_const(y)));
+
+            return retval;
+        } else {
+            // The polynomial is empty or it has more than 1 term, perfect forward to
+            // the series implementation.
+            return customisation::internal::pow(customisation::internal::pow_t{}, ::std::forward<T>(x),
+                                                ::std::forward<U>(y));
+        }
+    } else {
+        // Cannot do monomial exponentiation, perfect forward to
+        // the series implementation.
+        return customisation::internal::pow(customisation::internal::pow_t{}, ::std::forward<T>(x),
+                                            ::std::forward<U>(y));
+    }
+}
+
+} // namespace detail
+
+// Exponentiation.
+template <typename T, typename U>
+requires Polynomial<remove_cvref_t<T>> &&(
+    customisation::internal::series_default_pow_algo<
+        T &&, U &&> != 0) inline customisation::internal::series_default_pow_ret_t<T &&, U &&> pow(T &&x, U &&y)
+{
+    return detail::pow_poly_impl(::std::forward<T>(x), ::std::forward<U>(y));
+}
+
+namespace detail
+{
+
+// Helper to compute a value of type Ret by accumulation over
+// the tables of the polynomial x: f(tab, acc) must accumulate
+// into acc the contribution of the terms in the table tab.
+// For segmented polynomials, the tables are processed in parallel,
+// each into its own partial result, and the partial results
+// are then summed via a pairwise reduction.
+template <typename Ret, typename T, typename F>
+inline Ret poly_par_accumulate(const T &x, const F &f)
+{
+    const auto &s_table = x._get_s_table();
+
+    // The return value (this will default-construct
+    // an empty polynomial).
+    Ret retval;
+
+    if (s_table.size() == 1u) {
+        f(s_table[0], retval);
+
+        return retval;
+    }
+
+    using s_size_t = remove_cvref_t<decltype(s_table.size())>;
+    const auto nsegs = s_table.size();
+
+    ::std::vector<Ret> partials;
+    partials.resize(::obake::safe_cast<decltype(partials.size())>(nsegs));
+
+    detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, nsegs, 1), [&](const auto &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            f(s_table[i], partials[static_cast<decltype(partials.size())>(i)]);
+        }
+    });
+
+    for (decltype(partials.size()) stride = 1; stride < partials.size(); stride *= 2u) {
+        const auto n_pairs = (partials.size() - stride + 2u * stride - 1u) / (2u * stride);
+
+        detail::poly_par_for(::tbb::blocked_range<decltype(partials.size())>(0, n_pairs, 1), [&](const auto &range) {
+            for (auto j = range.begin(); j != range.end(); ++j) {
+                const auto i = j * 2u * stride;
+                assert(i + stride < partials.size());
+                partials[i] += ::std::move(partials[i + stride]);
+            }
+        });
+    }
+
+    retval = ::std::move(partials[0]);
+
+    return retval;
+}
+
+// Helper to build, via term insertions, a polynomial of type Ret
+// with the same symbol set, tag and segmentation as the polynomial x:
+// f(tab, out) must insert into out the terms produced from the terms
+// in the table tab of x. For segmented polynomials, the tables of x are
+// processed in parallel, each thread inserting into its own thread-local
+// polynomial, and the thread-local polynomials are then merged
+// table by table.
+template <typename Ret, typename T, typename F>
+inline Ret poly_par_insert(const T &x, const F &f)
+{
+    const auto &s_table = x._get_s_table();
+
+    auto make_ret = [&x]() {
+        Ret r;
+        r.set_symbol_set_fw(x.get_symbol_set_fw());
+        r.tag() = x.tag();
+        r.set_n_segments(x.get_s_size());
+        return r;
+    };
+
+    if (s_table.size() == 1u) {
+        auto retval = make_ret();
+        retval.reserve(x.size());
+        f(s_table[0], retval);
+
+        return retval;
+    }
+
+    using s_size_t = remove_cvref_t<decltype(s_table.size())>;
+    const auto nsegs = s_table.size();
+
+    ::tbb::enumerable_thread_specific<Ret> ets(make_ret);
+
+    detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&](const auto &range) {
+        // NOTE: run in an isolated task arena. Otherwise, if f() spawns
+        // tasks, this thread could pick up another range of this loop
+        // while still inserting into its thread-local polynomial.
+        ::tbb::this_task_arena::isolate([&]() {
+            auto &out = ets.local();
+
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                f(s_table[i], out);
+            }
+        });
+    });
+
+    if (ets.size() == 1u) {
+        // Only one thread was involved,
+        // no need to merge.
+        return ::std::move(*ets.begin());
+    }
+
+    // Merge the thread-local polynomials. Each table
+    // of the return value is built independently.
+    auto retval = make_ret();
+
+    detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&](const auto &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            auto &tab = retval._get_s_table()[i];
+
+            for (auto &out : ets) {
+                auto &out_tab = out._get_s_table()[i];
 
-            // Build the return value.
-            ret_t retval;
-            retval.set_symbol_set_fw(x.get_symbol_set_fw());
-            // NOTE: we do coefficient and monomial exponentiation using
-            // const refs everywhere (thus, we ensure that y is not mutated
-            // after one exponentiation). Regarding coefficient exponentiation,
-            // we checked in the default implementation that it is supported
-            // via const lvalue refs.
-            const auto it = x.cbegin();
-            retval.add_term(::obake::monomial_pow(it->first, ::std::as_const(y), x.get_symbol_set()),
-                            ::obake::pow(it->second, ::std::as_const(y)));
+                if (tab.empty()) {
+                    // Steal the table if possible.
+                    tab.swap(out_tab);
+                    continue;
+                }
 
-            return retval;
-        } else {
-            // The polynomial is empty or it has more than 1 term, perfect forward to
-            // the series implementation.
-            return customisation::internal::pow(customisation::internal::pow_t{}, ::std::forward<T>(x),
-                                                ::std::forward<U>(y));
+                for (auto &t : out_tab) {
+                    ::obake::detail::series_add_term_table<
+                        true, ::obake::detail::sat_check_zero::on, ::obake::detail::sat_check_compat_key::off,
+                        ::obake::detail::sat_check_table_size::on, ::obake::detail::sat_assume_unique::off>(
+                        retval, tab, t.first, ::std::move(t.second));
+                }
+            }
         }
-    } else {
-        // Cannot do monomial exponentiation, perfect forward to
-        // the series implementation.
-        return customisation::internal::pow(customisation::internal::pow_t{}, ::std::forward<T>(x),
-                                            ::std::forward<U>(y));
-    }
+    });
+
+    return retval;
 }
 
 } // namespace detail
 
-// Exponentiation.
-template <typename T, typename U>
-requires Polynomial<remove_cvref_t<T>> &&(
-    customisation::internal::series_default_pow_algo<
-        T &&, U &&> != 0) inline customisation::internal::series_default_pow_ret_t<T &&, U &&> pow(T &&x, U &&y)
-{
-    return detail::pow_poly_impl(::std::forward<T>(x), ::std::forward<U>(y));
-}
-
 namespace detail
 {
 
@@ -2262,6 +4526,238 @@ inline constexpr int poly_subs_algo = poly_subs_algorithm<T, U>.first;
 template <typename T, typename U>
 using poly_subs_ret_t = typename decltype(poly_subs_algorithm<T, U>.second)::type;
 
+// A table of the natural powers of a value which
+// is being substituted into a polynomial. Before the
+// substitution, the powers are computed for the distinct
+// exponents with which the corresponding variable appears
+// in the polynomial, so that each power is computed
+// only once and then read concurrently (without locking)
+// from multiple threads.
+template <typename R, typename U>
+struct poly_subs_pow_table {
+    explicit poly_subs_pow_table(const U &v) : m_value(&v) {}
+
+    // Compute the powers for the exponents in exps,
+    // which must be sorted, distinct and non-negative.
+    // NOTE: a power whose exponent follows the previous one
+    // is computed via a single multiplication, otherwise via
+    // exponentiation, so that a sparse set of large
+    // exponents does not require the computation of
+    // all the intermediate powers.
+    template <typename E>
+    void fill(const ::std::vector<E> &exps)
+    {
+        m_exps.reserve(exps.size());
+        m_powers.reserve(exps.size());
+
+        for (const auto &e : exps) {
+            const auto n = ::obake::safe_cast<::std::size_t>(e);
+
+            if (n == 0u) {
+                m_powers.emplace_back(1);
+            } else if (!m_exps.empty() && n - m_exps.back() == 1u) {
+                m_powers.push_back(::std::as_const(m_powers.back()) * *m_value);
+            } else {
+                m_powers.emplace_back(::obake::pow(*m_value, e));
+            }
+
+            m_exps.push_back(n);
+        }
+    }
+
+    const U *m_value;
+    // The exponents and the corresponding powers.
+    ::std::vector<::std::size_t> m_exps;
+    ::std::vector<R> m_powers;
+};
+
+// A lightweight reference to a poly_subs_pow_table, to be used in
+// place of the original value in the monomial substitution: the
+// monomial substitution primitive will end up calling the pow()
+// overload below, which fetches the powers from the table.
+template <typename R, typename U>
+struct poly_subs_pow_ref {
+    const poly_subs_pow_table<R, U> *m_table;
+};
+
+// NOTE: this will be found via ADL by obake::pow().
+template <typename R, typename U, typename E>
+requires ::std::is_integral_v<E> &&::std::is_constructible_v<R, ::obake::detail::pow_t<const U &, const E &>> inline R
+pow(const poly_subs_pow_ref<R, U> &r, const E &n)
+{
+    const auto &tab = *r.m_table;
+
+    // Negative exponents are not in the table.
+    bool n_negative = false;
+    if constexpr (::std::is_signed_v<E>) {
+        n_negative = n < E(0);
+    }
+    if (obake_unlikely(n_negative)) {
+        return R(::obake::pow(*tab.m_value, n));
+    }
+
+    // Look up the exponent in the table.
+    // NOTE: the table is never modified during the
+    // substitution, thus no locking is needed here.
+    const auto un = static_cast<::std::make_unsigned_t<E>>(n);
+    const auto it = ::std::lower_bound(tab.m_exps.begin(), tab.m_exps.end(), un,
+                                       [](const ::std::size_t &a, const auto &b) { return a < b; });
+    if (obake_unlikely(it == tab.m_exps.end() || *it != un)) {
+        return R(::obake::pow(*tab.m_value, n));
+    }
+
+    return tab.m_powers[static_cast<decltype(tab.m_powers.size())>(it - tab.m_exps.begin())];
+}
+
+// Check if the power tables can be used in the substitution
+// of values of type U into a polynomial of type T.
+template <typename T, typename U>
+constexpr bool poly_subs_use_pow_table_impl()
+{
+    using key_t = series_key_t<remove_cvref_t<T>>;
+    using key_subs_t = typename ::obake::detail::monomial_subs_t<const key_t &, U>::first_type;
+    using ref_t = poly_subs_pow_ref<key_subs_t, U>;
+
+    // NOTE: for C++ arithmetic types the exponentiation
+    // is cheap, no need to go through the tables. The exponents
+    // of the keys must be unpackable in order to size the tables.
+    if constexpr (::std::disjunction_v<::std::is_arithmetic<U>,
+                                       ::std::negation<is_substitutable_monomial<const key_t &, ref_t>>,
+                                       ::std::negation<is_detected<poly_unpack_exp_t, key_t>>>) {
+        return false;
+    } else {
+        return ::std::conjunction_v<
+            // The monomial substitution via the tables must
+            // produce the same type as the substitution via U.
+            ::std::is_same<key_subs_t, typename ::obake::detail::monomial_subs_t<const key_t &, ref_t>::first_type>,
+            // The powers are computed via multiplication and exponentiation.
+            ::std::is_same<key_subs_t, detected_t<::obake::detail::mul_t, const key_subs_t &, const U &>>,
+            ::std::is_constructible<key_subs_t,
+                                    detected_t<::obake::detail::pow_t, const U &, const poly_unpack_exp_t<key_t> &>>,
+            ::std::is_constructible<key_subs_t, int>, ::std::is_copy_constructible<key_subs_t>>;
+    }
+}
+
+template <typename T, typename U>
+inline constexpr bool poly_subs_use_pow_table = detail::poly_subs_use_pow_table_impl<T, U>();
+
+// Determine, for each variable at the indices in si, the
+// sorted list of the distinct non-negative exponents
+// of the variable in the terms of x (always including zero).
+template <typename T, typename U>
+inline auto poly_subs_exps(const T &x, const symbol_idx_map<U> &si)
+{
+    using key_t = series_key_t<T>;
+    using exp_t = poly_unpack_exp_t<key_t>;
+
+    const auto &s_table = x._get_s_table();
+    const auto nv = ::obake::safe_cast<unsigned>(x.get_symbol_set().size());
+
+    // Helper to sort a list of exponents and remove the duplicates.
+    auto sort_unique = [](auto &v) {
+        ::std::sort(v.begin(), v.end());
+        v.erase(::std::unique(v.begin(), v.end()), v.end());
+    };
+
+    // The exponents in each table of x.
+    using v_t = ::std::vector<exp_t>;
+    using vv_t = ::std::vector<v_t>;
+    ::std::vector<vv_t> partials(::obake::safe_cast<typename ::std::vector<vv_t>::size_type>(s_table.size()),
+                                 vv_t(::obake::safe_cast<typename vv_t::size_type>(si.size())));
+
+    using s_size_t = remove_cvref_t<decltype(s_table.size())>;
+    detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, s_table.size(), 1), [&](const auto &range) {
+        ::std::vector<exp_t> tmp(nv);
+
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            auto &pe = partials[static_cast<decltype(partials.size())>(i)];
+
+            for (const auto &t : s_table[i]) {
+                poly_unpack_traits<key_t>::unpack(t.first, nv, tmp.data());
+
+                decltype(pe.size()) j = 0;
+                for (const auto &p : si) {
+                    // NOTE: the zero exponent is added below.
+                    const auto &e = tmp[static_cast<decltype(tmp.size())>(p.first)];
+                    if (e > exp_t(0)) {
+                        pe[j].push_back(e);
+                    }
+                    ++j;
+                }
+            }
+
+            for (auto &v : pe) {
+                sort_unique(v);
+            }
+        }
+    });
+
+    auto retval(::std::move(partials[0]));
+    for (decltype(partials.size()) i = 1; i < partials.size(); ++i) {
+        for (decltype(retval.size()) j = 0; j < retval.size(); ++j) {
+            retval[j].insert(retval[j].end(), partials[i][j].begin(), partials[i][j].end());
+        }
+    }
+    for (auto &v : retval) {
+        sort_unique(v);
+        // The zero exponent is always in the table, as
+        // most terms will not contain all the variables.
+        v.insert(v.begin(), exp_t(0));
+    }
+
+    return retval;
+}
+
+// Substitute into the terms of the polynomial x the values in sm. The monomials
+// will be substituted with the values in msm, which is either the intersection
+// of sm with the symbol set of x, or the power tables built from it.
+template <typename Ret, typename T, typename U, typename MSM>
+inline Ret poly_subs_impl_accumulate(const T &x, const symbol_map<U> &sm, const symbol_idx_map<MSM> &msm)
+{
+    const auto &ss = x.get_symbol_set();
+
+    // Accumulate the substitution of the terms of the table tab into acc.
+    auto tab_subs = [&x, &sm, &msm, &ss](const auto &tab, Ret &acc) {
+        // Init a temp poly that we will use in the loop below.
+        T tmp_poly;
+        tmp_poly.set_symbol_set_fw(x.get_symbol_set_fw());
+        tmp_poly.tag() = x.tag();
+
+        for (const auto &t : tab) {
+            const auto &k = t.first;
+            const auto &c = t.second;
+
+            // Do the monomial substitution.
+            auto k_sub(::obake::monomial_subs(k, msm, ss));
+
+            // Clear up tmp_poly, add a term with unitary
+            // coefficient containing the monomial result of the
+            // substitution above.
+            tmp_poly.clear_terms();
+            tmp_poly.add_term(::std::move(k_sub.second), 1);
+
+            // Compute the product of the substitutions and accumulate
+            // it into the return value.
+            // NOTE: if the type of retval coincides with the type
+            // of the original poly, we could probably optimise this
+            // to do term insertions rather than going through with
+            // the multiplications. E.g., substitution with integral
+            // values in a polynomial with integral coefficients.
+            // NOTE: another optimisation is possible if
+            // the type of subs(c, sm) is the coefficient type of
+            // tmp_poly. In that case we can avoid one multiplication
+            // and call tmp_poly.add_term() above directly with
+            // subs(c, sm) as a coefficient instead of 1.
+            // NOTE: if we implement the above suggestions, we will
+            // have to think about the implication wrt power series
+            // and truncation.
+            acc += ::std::move(k_sub.first) * ::obake::subs(c, sm) * ::std::as_const(tmp_poly);
+        }
+    };
+
+    return detail::poly_par_accumulate<Ret>(x, tab_subs);
+}
+
 // Implementation of the polynomial subs algorithm.
 template <typename T, typename U>
 inline auto poly_subs_impl(T &&x_, const symbol_map<U> &sm)
@@ -2269,58 +4765,48 @@ inline auto poly_subs_impl(T &&x_, const symbol_map<U> &sm)
     // Sanity check.
     static_assert(poly_subs_algo<T &&, U> == 1);
 
+    using ret_t = poly_subs_ret_t<T &&, U>;
+
     // Need only const access to x.
     const auto &x = ::std::as_const(x_);
 
-    // Cache a reference to the symbol set.
-    const auto &ss = x.get_symbol_set();
-
     // Compute the intersection between sm and ss.
-    const auto si = ::obake::detail::sm_intersect_idx(sm, ss);
+    const auto si = ::obake::detail::sm_intersect_idx(sm, x.get_symbol_set());
 
-    // Init a temp poly that we will use in the loop below.
-    remove_cvref_t<T> tmp_poly;
-    tmp_poly.set_symbol_set_fw(x.get_symbol_set_fw());
-    tmp_poly.tag() = x.tag();
+    if constexpr (poly_subs_use_pow_table<T &&, U>) {
+        // Build the power tables for the values
+        // being substituted into the monomials.
+        using key_subs_t = typename ::obake::detail::monomial_subs_t<const series_key_t<remove_cvref_t<T>> &,
+                                                                     U>::first_type;
+        using table_t = poly_subs_pow_table<key_subs_t, U>;
 
-    // The return value (this will default-construct
-    // an empty polynomial).
-    poly_subs_ret_t<T &&, U> retval;
-
-    // NOTE: parallelisation opportunities here
-    // for segmented tables.
-    for (const auto &t : x) {
-        const auto &k = t.first;
-        const auto &c = t.second;
-
-        // Do the monomial substitution.
-        auto k_sub(::obake::monomial_subs(k, si, ss));
-
-        // Clear up tmp_poly, add a term with unitary
-        // coefficient containing the monomial result of the
-        // substitution above.
-        tmp_poly.clear_terms();
-        tmp_poly.add_term(::std::move(k_sub.second), 1);
-
-        // Compute the product of the substitutions and accumulate
-        // it into the return value.
-        // NOTE: if the type of retval coincides with the type
-        // of the original poly, we could probably optimise this
-        // to do term insertions rather than going through with
-        // the multiplications. E.g., substitution with integral
-        // values in a polynomial with integral coefficients.
-        // NOTE: another optimisation is possible if
-        // the type of subs(c, sm) is the coefficient type of
-        // tmp_poly. In that case we can avoid one multiplication
-        // and call tmp_poly.add_term() above directly with
-        // subs(c, sm) as a coefficient instead of 1.
-        // NOTE: if we implement the above suggestions, we will
-        // have to think about the implication wrt power series
-        // and truncation.
-        retval += ::std::move(k_sub.first) * ::obake::subs(c, sm) * ::std::as_const(tmp_poly);
-    }
+        ::std::vector<::std::unique_ptr<table_t>> tables;
+        tables.reserve(::obake::safe_cast<decltype(tables.size())>(si.size()));
 
-    return retval;
+        symbol_idx_map<poly_subs_pow_ref<key_subs_t, U>> si_tab;
+        si_tab.reserve(si.size());
+
+        for (const auto &p : si) {
+            tables.push_back(::std::make_unique<table_t>(p.second));
+            si_tab.emplace_hint(si_tab.end(), p.first, poly_subs_pow_ref<key_subs_t, U>{tables.back().get()});
+        }
+
+        // Fill the tables with the powers for the
+        // exponents of the variables in x.
+        const auto exps = detail::poly_subs_exps(x, si);
+        assert(exps.size() == tables.size());
+
+        detail::poly_par_for(::tbb::blocked_range<decltype(tables.size())>(0, tables.size(), 1),
+                             [&tables, &exps](const auto &range) {
+                                 for (auto i = range.begin(); i != range.end(); ++i) {
+                                     tables[i]->fill(exps[i]);
+                                 }
+                             });
+
+        return detail::poly_subs_impl_accumulate<ret_t>(x, sm, si_tab);
+    } else {
+        return detail::poly_subs_impl_accumulate<ret_t>(x, sm, si);
+    }
 }
 
 } // namespace detail
@@ -2562,7 +5048,7 @@ inline auto poly_diff_impl(T &&x_, const ::std::string &s)
 
     // Cache the symbol set.
     const auto &ss = x.get_symbol_set();
-    const auto &ss_fw = x.get_symbol_set_fw();
+    [[maybe_unused]] const auto &ss_fw = x.get_symbol_set_fw();
 
     // Determine the index of s in the symbol set.
     const auto idx = ss.index_of(ss.find(s));
@@ -2572,102 +5058,332 @@ inline auto poly_diff_impl(T &&x_, const ::std::string &s)
 
     if constexpr (algo == 1) {
         // The general algorithm.
-        // Init temp polys that we will use in the loop below.
-        // These will represent the original monomial and its
-        // derivative as series of type T (after cvref removal).
-        remove_cvref_t<T> tmp_p1, tmp_p2;
+        // NOTE: the tables of x are processed in parallel
+        // for segmented polynomials.
+        auto tab_diff = [&x, &ss, &ss_fw, &s, idx, s_present](const auto &tab, ret_t &acc) {
+            // Init temp polys that we will use in the loop below.
+            // These will represent the original monomial and its
+            // derivative as series of type T (after cvref removal).
+            remove_cvref_t<T> tmp_p1, tmp_p2;
+
+            tmp_p1.set_symbol_set_fw(ss_fw);
+            tmp_p1.tag() = x.tag();
+
+            tmp_p2.set_symbol_set_fw(ss_fw);
+            tmp_p2.tag() = x.tag();
+
+            for (const auto &t : tab) {
+                const auto &k = t.first;
+                const auto &c = t.second;
 
-        tmp_p1.set_symbol_set_fw(ss_fw);
-        tmp_p1.tag() = x.tag();
+                // Prepare the first temp poly.
+                tmp_p1.clear_terms();
+                tmp_p1.add_term(k, 1);
 
-        tmp_p2.set_symbol_set_fw(ss_fw);
-        tmp_p2.tag() = x.tag();
+                if (s_present) {
+                    // The symbol is present in the symbol set,
+                    // need to diff the monomial.
+                    auto key_diff(::obake::monomial_diff(k, idx, ss));
 
-        ret_t retval(0);
+                    // Prepare the second temp poly.
+                    tmp_p2.clear_terms();
+                    tmp_p2.add_term(::std::move(key_diff.second), 1);
 
-        for (const auto &t : x) {
-            const auto &k = t.first;
-            const auto &c = t.second;
+                    // Put everything together.
+                    acc += ::obake::diff(c, s) * ::std::as_const(tmp_p1)
+                           + c * ::std::move(key_diff.first) * ::std::as_const(tmp_p2);
+                } else {
+                    // The symbol is not present in the symbol set,
+                    // need to diff only the coefficient.
+                    acc += ::obake::diff(c, s) * ::std::as_const(tmp_p1);
+                }
+            }
+        };
+
+        return detail::poly_par_accumulate<ret_t>(x, tab_diff);
+    } else {
+        // Faster implementation via term insertions.
+        // The return type must be the original poly type.
+        static_assert(::std::is_same_v<ret_t, remove_cvref_t<T>>);
+
+        // NOTE: retval will have the same symbol set, tag
+        // and segmentation as x. The tables of x are processed
+        // in parallel for segmented polynomials.
+        auto tab_diff = [&ss, &s, idx, s_present](const auto &tab, ret_t &out) {
+            for (const auto &t : tab) {
+                const auto &k = t.first;
+                const auto &c = t.second;
+
+                // Add the term corresponding to the differentiation
+                // of the coefficient.
+                // NOTE: generally speaking, here we probably need
+                // all insertion checks:
+                // - mixing diffed and non-diffed
+                //   monomials in retval will produce non-unique
+                //   monomials,
+                // - diff on coefficients/keys may result in zero,
+                // - table size could end up being anything.
+                // Probably the only check we can currently drop is about
+                // monomial compatibility. Keep it in mind for the future,
+                // if performance becomes a concern.
+                out.add_term(k, ::obake::diff(c, s));
+
+                if (s_present) {
+                    // The symbol is present in the symbol set,
+                    // need to diff the monomial too.
+                    auto key_diff(::obake::monomial_diff(k, idx, ss));
+                    out.add_term(::std::move(key_diff.second), c * ::std::move(key_diff.first));
+                }
+            }
+        };
+
+        return detail::poly_par_insert<ret_t>(x, tab_diff);
+    }
+}
+
+} // namespace detail
+
+template <typename T>
+requires Polynomial<remove_cvref_t<T>> &&(detail::poly_diff_algo<T &&> != 0) inline detail::poly_diff_ret_t<T &&> diff(
+    T &&x, const ::std::string &s)
+{
+    return detail::poly_diff_impl(::std::forward<T>(x), s);
+}
 
-            // Prepare the first temp poly.
-            tmp_p1.clear_terms();
-            tmp_p1.add_term(k, 1);
+namespace detail
+{
 
-            if (s_present) {
-                // The symbol is present in the symbol set,
-                // need to diff the monomial.
-                auto key_diff(::obake::monomial_diff(k, idx, ss));
+// Meta-programming for the selection of the
+// gradient() algorithm.
+template <typename T>
+constexpr int poly_gradient_algorithm_impl()
+{
+    if constexpr (poly_diff_algo<T> == 0) {
+        // The polynomial is not differentiable.
+        return 0;
+    } else if constexpr (poly_diff_algo<T> == 1) {
+        // The general algorithm: compute
+        // the partial derivatives via diff().
+        return 1;
+    } else {
+        using key_t = series_key_t<remove_cvref_t<T>>;
 
-                // Prepare the second temp poly.
-                tmp_p2.clear_terms();
-                tmp_p2.add_term(::std::move(key_diff.second), 1);
+        if constexpr (is_detected_v<poly_unpack_exp_t, key_t>) {
+            using exp_t = poly_unpack_exp_t<key_t>;
+            using key_diff_t = typename ::obake::detail::monomial_diff_t<const key_t &>::first_type;
 
-                // Put everything together.
-                retval += ::obake::diff(c, s) * ::std::as_const(tmp_p1)
-                          + c * ::std::move(key_diff.first) * ::std::as_const(tmp_p2);
+            // The fast algorithm requires to be able to unpack the monomials,
+            // to construct them from a range of exponents, and to predict the
+            // destination tables of the partial derivatives via homomorphic
+            // hashing.
+            if constexpr (::std::conjunction_v<::std::is_constructible<key_t, const exp_t *, const exp_t *>,
+                                               is_homomorphically_hashable_monomial<const key_t &>,
+                                               ::std::is_constructible<key_diff_t, const exp_t &>>) {
+                return 2;
             } else {
-                // The symbol is not present in the symbol set,
-                // need to diff only the coefficient.
-                retval += ::obake::diff(c, s) * ::std::as_const(tmp_p1);
+                return 1;
             }
+        } else {
+            return 1;
         }
+    }
+}
 
-        return retval;
+template <typename T>
+inline constexpr int poly_gradient_algo = detail::poly_gradient_algorithm_impl<T>();
+
+// Implementation of the gradient.
+template <typename T>
+inline auto poly_gradient_impl(T &&x_)
+{
+    using ret_t = poly_diff_ret_t<T &&>;
+    constexpr auto algo = poly_gradient_algo<T &&>;
+
+    // Sanity checks.
+    static_assert(algo == 1 || algo == 2);
+
+    // Need only const access to x.
+    const auto &x = ::std::as_const(x_);
+
+    // Cache the symbol set.
+    const auto &ss = x.get_symbol_set();
+
+    ::std::vector<ret_t> retval;
+    retval.resize(::obake::safe_cast<decltype(retval.size())>(ss.size()));
+
+    using r_size_t = decltype(retval.size());
+
+    if constexpr (algo == 1) {
+        // The general algorithm: compute the partial
+        // derivatives in parallel via diff().
+        detail::poly_par_for(::tbb::blocked_range<r_size_t>(0, retval.size(), 1), [&](const auto &range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                retval[i] = ::obake::diff(x, *(ss.cbegin() + static_cast<symbol_set::difference_type>(i)));
+            }
+        });
     } else {
-        // Faster implementation via term insertions.
+        // Faster implementation via term insertions,
+        // computing all the partial derivatives of each
+        // monomial after a single unpacking.
         // The return type must be the original poly type.
         static_assert(::std::is_same_v<ret_t, remove_cvref_t<T>>);
 
-        // Init retval, using the same symbol set, tag
-        // and segmentation from x, and reserving
-        // the same size as x.
-        ret_t retval;
-        retval.set_symbol_set_fw(ss_fw);
-        retval.tag() = x.tag();
-        retval.set_n_segments(x.get_s_size());
-        retval.reserve(x.size());
+        using key_t = series_key_t<ret_t>;
+        using exp_t = poly_unpack_exp_t<key_t>;
+        using key_diff_t = typename ::obake::detail::monomial_diff_t<const key_t &>::first_type;
 
-        for (const auto &t : x) {
-            const auto &k = t.first;
-            const auto &c = t.second;
+        // NOTE: because the keys are compatible with the symbol set,
+        // the static cast is safe.
+        const auto n = static_cast<unsigned>(ss.size());
 
-            // Add the term corresponding to the differentiation
-            // of the coefficient.
-            // NOTE: generally speaking, here we probably need
-            // all insertion checks:
-            // - mixing diffed and non-diffed
-            //   monomials in retval will produce non-unique
-            //   monomials,
-            // - diff on coefficients/keys may result in zero,
-            // - table size could end up being anything.
-            // Probably the only check we can currently drop is about
-            // monomial compatibility. Keep it in mind for the future,
-            // if performance becomes a concern. Also, as usual,
-            // we could differentiate between segmented and non
-            // segmented layouts to improve performance.
-            retval.add_term(k, ::obake::diff(c, s));
-
-            if (s_present) {
-                // The symbol is present in the symbol set,
-                // need to diff the monomial too.
-                auto key_diff(::obake::monomial_diff(k, idx, ss));
-                retval.add_term(::std::move(key_diff.second), c * ::std::move(key_diff.first));
+        const auto &s_table = x._get_s_table();
+        using s_size_t = remove_cvref_t<decltype(s_table.size())>;
+        const auto mask = static_cast<::std::size_t>(s_table.size() - 1u);
+
+        // Init the partial derivatives, using the same symbol
+        // set, tag and segmentation from x.
+        for (auto &r : retval) {
+            r.set_symbol_set_fw(x.get_symbol_set_fw());
+            r.tag() = x.tag();
+            r.set_n_segments(x.get_s_size());
+        }
+
+        // Compute the hashes of the monomials representing the symbols.
+        // NOTE: thanks to homomorphic hashing, the hash of the
+        // derivative of a monomial k wrt the i-th symbol is
+        // hash(k) - h_gen[i], and we can thus determine the
+        // destination table of the derivative from the table of k.
+        ::std::vector<::std::size_t> h_gen;
+        h_gen.reserve(retval.size());
+        {
+            ::std::vector<exp_t> tmp;
+            tmp.resize(::obake::safe_cast<decltype(tmp.size())>(n));
+            for (auto &e : tmp) {
+                e = exp_t(0);
+            }
+            for (auto i = 0u; i < n; ++i) {
+                tmp[i] = exp_t(1);
+                h_gen.push_back(::obake::hash(key_t(::std::as_const(tmp).data(), ::std::as_const(tmp).data() + n)));
+                tmp[i] = exp_t(0);
             }
         }
 
-        return retval;
+        // Differentiate the coefficients. Because the keys do not
+        // change, the terms of each table of x end up in the tables
+        // with the same index in the partial derivatives. Thus,
+        // we can process the tables of x in parallel.
+        // NOTE: we do this in a separate pass wrt the differentiation
+        // of the monomials below, otherwise different tasks could
+        // end up writing into the same table.
+        detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, s_table.size()), [&](const auto &range) {
+            for (auto j = range.begin(); j != range.end(); ++j) {
+                for (const auto &t : s_table[j]) {
+                    auto ss_it = ss.cbegin();
+                    for (auto i = 0u; i < n; ++i, ++ss_it) {
+                        auto dc(::obake::diff(t.second, *ss_it));
+                        if (::obake::is_zero(::std::as_const(dc))) {
+                            continue;
+                        }
+
+                        auto &r = retval[static_cast<r_size_t>(i)];
+                        ::obake::detail::series_add_term_table<
+                            true, ::obake::detail::sat_check_zero::on, ::obake::detail::sat_check_compat_key::off,
+                            ::obake::detail::sat_check_table_size::on, ::obake::detail::sat_assume_unique::off>(
+                            r, r._get_s_table()[j], t.first, ::std::move(dc));
+                    }
+                }
+            }
+        });
+
+        // Differentiate the monomials. For each partial derivative,
+        // the tables of x are mapped to distinct destination tables.
+        detail::poly_par_for(::tbb::blocked_range<s_size_t>(0, s_table.size()), [&](const auto &range) {
+            ::std::vector<exp_t> tmp;
+            tmp.resize(::obake::safe_cast<decltype(tmp.size())>(n));
+
+            for (auto j = range.begin(); j != range.end(); ++j) {
+                for (const auto &t : s_table[j]) {
+                    const auto &c = t.second;
+
+                    // Unpack the monomial.
+                    poly_unpack_traits<key_t>::unpack(t.first, n, tmp.data());
+
+                    for (auto i = 0u; i < n; ++i) {
+                        const auto e = tmp[i];
+                        if (e == exp_t(0)) {
+                            continue;
+                        }
+
+                        // Build the derivative of the monomial.
+                        // NOTE: no need for overflow checking here,
+                        // see the implementation of monomial_diff().
+                        --tmp[i];
+                        key_t new_k(::std::as_const(tmp).data(), ::std::as_const(tmp).data() + n);
+                        tmp[i] = e;
+
+                        auto &r = retval[static_cast<r_size_t>(i)];
+                        const auto dest_idx = static_cast<s_size_t>((static_cast<::std::size_t>(j) - h_gen[i]) & mask);
+                        assert((::obake::hash(new_k) & mask) == dest_idx);
+
+                        ::obake::detail::series_add_term_table<
+                            true, ::obake::detail::sat_check_zero::on, ::obake::detail::sat_check_compat_key::off,
+                            ::obake::detail::sat_check_table_size::on, ::obake::detail::sat_assume_unique::off>(
+                            r, r._get_s_table()[dest_idx], ::std::move(new_k), c * key_diff_t(e));
+                    }
+                }
+            }
+        });
     }
-}
 
-} // namespace detail
+    return retval;
+}
 
+// Implementation of the jacobian.
 template <typename T>
-requires Polynomial<remove_cvref_t<T>> &&(detail::poly_diff_algo<T &&> != 0) inline detail::poly_diff_ret_t<T &&> diff(
-    T &&x, const ::std::string &s)
+inline auto poly_jacobian_impl(const ::std::vector<T> &v)
 {
-    return detail::poly_diff_impl(::std::forward<T>(x), s);
+    using ret_t = poly_diff_ret_t<const T &>;
+    using v_size_t = typename ::std::vector<T>::size_type;
+
+    // Determine the union of the symbol sets.
+    symbol_set ss;
+    for (const auto &p : v) {
+        if (p.get_symbol_set() != ss) {
+            ss = ::std::get<0>(::obake::detail::merge_symbol_sets(ss, p.get_symbol_set()));
+        }
+    }
+
+    ::std::vector<::std::vector<ret_t>> retval;
+    retval.resize(v.size());
+
+    detail::poly_par_for(::tbb::blocked_range<v_size_t>(0, v.size(), 1), [&](const auto &range) {
+        for (auto k = range.begin(); k != range.end(); ++k) {
+            const auto &p = v[k];
+            const auto &p_ss = p.get_symbol_set();
+
+            auto grad = detail::poly_gradient_impl(p);
+
+            auto &row = retval[k];
+            row.reserve(ss.size());
+            for (const auto &s : ss) {
+                const auto it = p_ss.find(s);
+                if (it == p_ss.end() || *it != s) {
+                    // The symbol does not appear in p,
+                    // only the coefficients need to be
+                    // differentiated.
+                    row.push_back(::obake::diff(p, s));
+                } else {
+                    row.push_back(::std::move(grad[static_cast<decltype(grad.size())>(p_ss.index_of(it))]));
+                }
+            }
+        }
+    });
+
+    return retval;
 }
 
+} // namespace detail
+
 namespace detail
 {
 
@@ -2766,7 +5482,7 @@ inline auto poly_integrate_impl(T &&x_, const ::std::string &s)
 
         // Cache the symbol set.
         const auto &ss = x.get_symbol_set();
-        const auto &ss_fw = x.get_symbol_set_fw();
+        [[maybe_unused]] const auto &ss_fw = x.get_symbol_set_fw();
         // idx has to be present.
         assert(idx != ss.size());
 
@@ -2777,63 +5493,61 @@ inline auto poly_integrate_impl(T &&x_, const ::std::string &s)
 
         if constexpr (algo == 1) {
             // The general algorithm.
-            // Init temp poly that we will use in the loop below.
-            // This will represent the integral of the original monomial
-            // as a series of type rT.
-            rT tmp_p;
-            tmp_p.set_symbol_set_fw(ss_fw);
-            tmp_p.tag() = x.tag();
-
-            // Produce retval by accumulation.
-            ret_t retval(0);
-            for (const auto &t : x) {
-                const auto &c = t.second;
-
-                if (obake_unlikely(!::obake::is_zero(::obake::diff(c, s)))) {
-                    obake_throw(::std::invalid_argument, cf_diff_err_msg);
-                }
+            // NOTE: the tables of x are processed in parallel
+            // for segmented polynomials.
+            auto tab_integrate = [&x, &ss, &ss_fw, &s, &cf_diff_err_msg, idx](const auto &tab, ret_t &acc) {
+                // Init temp poly that we will use in the loop below.
+                // This will represent the integral of the original monomial
+                // as a series of type rT.
+                rT tmp_p;
+                tmp_p.set_symbol_set_fw(ss_fw);
+                tmp_p.tag() = x.tag();
+
+                for (const auto &t : tab) {
+                    const auto &c = t.second;
+
+                    if (obake_unlikely(!::obake::is_zero(::obake::diff(c, s)))) {
+                        obake_throw(::std::invalid_argument, cf_diff_err_msg);
+                    }
 
-                // Do the monomial integration.
-                auto key_int(::obake::monomial_integrate(t.first, idx, ss));
+                    // Do the monomial integration.
+                    auto key_int(::obake::monomial_integrate(t.first, idx, ss));
 
-                // Prepare the temp poly.
-                tmp_p.clear_terms();
-                tmp_p.add_term(::std::move(key_int.second), 1);
+                    // Prepare the temp poly.
+                    tmp_p.clear_terms();
+                    tmp_p.add_term(::std::move(key_int.second), 1);
 
-                // Put everything together.
-                retval += c / ::std::move(key_int.first) * ::std::as_const(tmp_p);
-            }
+                    // Put everything together.
+                    acc += c / ::std::move(key_int.first) * ::std::as_const(tmp_p);
+                }
+            };
 
-            return retval;
+            return detail::poly_par_accumulate<ret_t>(x, tab_integrate);
         } else {
             // Faster implementation via term insertions.
             // The return type must be the original poly type.
             static_assert(::std::is_same_v<ret_t, rT>);
 
-            // Init retval, using the same symbol set, tag
-            // and segmentation from x, and reserving
-            // the same size as x.
-            ret_t retval;
-            retval.set_symbol_set_fw(ss_fw);
-            retval.tag() = x.tag();
-            retval.set_n_segments(x.get_s_size());
-            retval.reserve(x.size());
+            // NOTE: retval will have the same symbol set, tag
+            // and segmentation as x. The tables of x are processed
+            // in parallel for segmented polynomials.
+            auto tab_integrate = [&ss, &s, &cf_diff_err_msg, idx](const auto &tab, ret_t &out) {
+                for (const auto &t : tab) {
+                    const auto &c = t.second;
 
-            for (const auto &t : x) {
-                const auto &c = t.second;
+                    if (obake_unlikely(!::obake::is_zero(::obake::diff(c, s)))) {
+                        obake_throw(::std::invalid_argument, cf_diff_err_msg);
+                    }
 
-                if (obake_unlikely(!::obake::is_zero(::obake::diff(c, s)))) {
-                    obake_throw(::std::invalid_argument, cf_diff_err_msg);
+                    // Do the monomial integration, mix it with the coefficient.
+                    auto key_int(::obake::monomial_integrate(t.first, idx, ss));
+                    // NOTE: here we could probably avoid most checks in the
+                    // term addition logic. Keep it in mind for the future.
+                    out.add_term(::std::move(key_int.second), c / ::std::move(key_int.first));
                 }
+            };
 
-                // Do the monomial integration, mix it with the coefficient.
-                auto key_int(::obake::monomial_integrate(t.first, idx, ss));
-                // NOTE: here we could probably avoid most checks in the
-                // term addition logic. Keep it in mind for the future.
-                retval.add_term(::std::move(key_int.second), c / ::std::move(key_int.first));
-            }
-
-            return retval;
+            return detail::poly_par_insert<ret_t>(x, tab_integrate);
         }
     };
 
@@ -2885,6 +5599,24 @@ requires Polynomial<remove_cvref_t<T>> &&(
 
 } // namespace polynomials
 
+// Gradient: compute the partial derivatives of x wrt
+// all the symbols in its symbol set, in order.
+template <typename T>
+requires Polynomial<remove_cvref_t<T>> &&(polynomials::detail::poly_gradient_algo<T &&> != 0) inline ::std::vector<
+    polynomials::detail::poly_diff_ret_t<T &&>> gradient(T &&x)
+{
+    return polynomials::detail::poly_gradient_impl(::std::forward<T>(x));
+}
+
+// Jacobian: compute the gradients of the polynomials in v
+// wrt all the symbols in the union of their symbol sets.
+template <typename T>
+requires Polynomial<T> &&(polynomials::detail::poly_gradient_algo<const T &> != 0) inline ::std::vector<
+    ::std::vector<polynomials::detail::poly_diff_ret_t<const T &>>> jacobian(const ::std::vector<T> &v)
+{
+    return polynomials::detail::poly_jacobian_impl(v);
+}
+
 } // namespace obake
 
 #endif
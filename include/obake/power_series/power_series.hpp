@@ -9,7 +9,11 @@
 #ifndef OBAKE_POWER_SERIES_POWER_SERIES_HPP
 #define OBAKE_POWER_SERIES_POWER_SERIES_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstddef>
+#include <optional>
 #include <ostream>
 #include <sstream>
 #include <stdexcept>
@@ -21,25 +25,35 @@
 
 #include <boost/flyweight/flyweight.hpp>
 #include <boost/flyweight/hashed_factory.hpp>
+#include <boost/flyweight/refcounted.hpp>
+#include <boost/flyweight/simple_locking.hpp>
 #include <boost/serialization/split_free.hpp>
 #include <boost/serialization/tracking.hpp>
 #include <boost/serialization/utility.hpp>
 
 #include <fmt/core.h>
 
+#include <obake/config.hpp>
 #include <obake/detail/fw_utils.hpp>
 #include <obake/detail/it_diff_check.hpp>
 #include <obake/detail/make_array.hpp>
+#include <obake/detail/mppp_utils.hpp>
 #include <obake/detail/ss_func_forward.hpp>
+#include <obake/exceptions.hpp>
 #include <obake/hash.hpp>
+#include <obake/key/key_is_one.hpp>
 #include <obake/math/degree.hpp>
+#include <obake/math/is_zero.hpp>
 #include <obake/math/p_degree.hpp>
+#include <obake/math/pow.hpp>
 #include <obake/math/safe_cast.hpp>
+#include <obake/math/safe_convert.hpp>
 #include <obake/polynomials/polynomial.hpp>
 #include <obake/s11n.hpp>
 #include <obake/series.hpp>
 #include <obake/symbols.hpp>
 #include <obake/tex_stream_insert.hpp>
+#include <obake/type_name.hpp>
 #include <obake/type_traits.hpp>
 
 namespace obake
@@ -1366,12 +1380,288 @@ inline ::obake::polynomials::detail::poly_mul_ret_t<p_series<K, C0>, p_series<K,
         ::obake::get_truncation(ps0), ::obake::get_truncation(ps1));
 }
 
-// Exponentiation: we re-use the poly implementation, ensuring
-// that the output is properly truncated.
+// Fused multiply-add: accumulate the product of ps0 and ps1 into acc.
+// If acc, ps0 and ps1 share the same truncation policy and level, the
+// (truncated) product is accumulated directly into acc, without
+// constructing a temporary power series for the product. Otherwise,
+// this is equivalent to acc += ps0 * ps1.
+// NOTE: if the product is accumulated directly into acc and the
+// multiplication throws after it started writing into acc, acc will be
+// cleared via its clear() member function, so the terms acc contained
+// before the call are lost. Errors detected beforehand leave acc
+// unchanged. Callers needing the strong guarantee should accumulate
+// into a copy.
+template <typename K, typename C, typename C0, typename C1>
+    requires(detail::ps_mul_algo<p_series<K, C0>, p_series<K, C1>>() == true)
+            && ::std::is_same_v<::obake::polynomials::detail::poly_mul_ret_t<p_series<K, C0>, p_series<K, C1>>,
+                                p_series<K, C>>
+inline void fma3(p_series<K, C> &acc, const p_series<K, C0> &ps0, const p_series<K, C1> &ps1)
+{
+    // Fetch the (partial) degree type.
+    using deg_t [[maybe_unused]] = decltype(::obake::degree(ps0));
+
+    // NOTE: make a copy of the truncation, as acc
+    // will be modified below.
+    const auto trunc = ::obake::get_truncation(acc);
+
+    if (trunc != ::obake::get_truncation(ps0) || trunc != ::obake::get_truncation(ps1)) {
+        acc += ps0 * ps1;
+
+        return;
+    }
+
+    ::std::visit(
+        [&acc, &ps0, &ps1](const auto &v) {
+            using type = remove_cvref_t<decltype(v)>;
+
+            if constexpr (::std::is_same_v<type, detail::no_truncation>) {
+                // Untruncated multiplication.
+                polynomials::detail::poly_fma3_impl(acc, ps0, ps1);
+            } else if constexpr (::std::is_same_v<type, deg_t>) {
+                // Total degree truncation.
+                polynomials::detail::poly_fma3_impl(acc, ps0, ps1, v);
+            } else {
+                // Partial degree truncation.
+                polynomials::detail::poly_fma3_impl(acc, ps0, ps1, v.first, v.second);
+            }
+        },
+        trunc);
+}
+
+namespace detail
+{
+
+// Detect integral coefficient types, for which the divisions
+// in the J.C.P. Miller recurrence are exact only in special cases.
+template <typename T>
+inline constexpr bool ps_cf_is_integral = is_integral_v<T> || ::obake::detail::is_mppp_integer_v<T>;
+
+// Check if x**y can be computed via the J.C.P. Miller recurrence
+// (see ps_pow_miller() below), with x of type T and y of type U.
+// The requirements are:
+// - the degree type is a C++ integral type,
+// - the coefficient type of the return type, rcf_t, is either
+//   a field-like type (a C++ floating-point type or a rational) or
+//   an integral type (in which case the recurrence is used only
+//   when it is exact, see ps_pow_miller()),
+// - the coefficient type of the return type, rcf_t, is constructible
+//   from the coefficient type of T, from U and from the degree type,
+//   it supports addition, subtraction and multiplication
+//   and it is zero-testable,
+// - the return type supports multiplication, in-place addition
+//   and in-place multiplication/division by rcf_t.
+template <typename T, typename U>
+constexpr bool ps_pow_miller_supported()
+{
+    if constexpr (customisation::internal::series_default_pow_algo<T, U> == 0) {
+        return false;
+    } else {
+        using rT = remove_cvref_t<T>;
+        using rU = remove_cvref_t<U>;
+        using ret_t = customisation::internal::series_default_pow_ret_t<T, U>;
+        using cf_t = series_cf_t<rT>;
+        using rcf_t = series_cf_t<ret_t>;
+        using deg_t = ::obake::detail::psk_deg_t<series_key_t<rT>>;
+
+        return ::std::conjunction_v<
+            ::std::is_integral<deg_t>,
+            ::std::bool_constant<::std::is_floating_point_v<rcf_t> || ::obake::detail::is_mppp_rational_v<rcf_t>
+                                 || ps_cf_is_integral<rcf_t>>,
+            ::std::is_constructible<rcf_t, const cf_t &>,
+            ::std::is_constructible<rcf_t, const rU &>, ::std::is_constructible<rcf_t, deg_t>,
+            ::std::is_same<rcf_t, detected_t<::obake::detail::add_t, const rcf_t &, const rcf_t &>>,
+            ::std::is_same<rcf_t, detected_t<::obake::detail::sub_t, const rcf_t &, const rcf_t &>>,
+            ::std::is_same<rcf_t, detected_t<::obake::detail::mul_t, const rcf_t &, const rcf_t &>>,
+            is_zero_testable<const rcf_t &>,
+            ::std::is_same<ret_t, detected_t<::obake::detail::mul_t, const ret_t &, const ret_t &>>,
+            is_in_place_addable<ret_t &, ret_t>, is_in_place_multipliable<ret_t &, const rcf_t &>,
+            is_in_place_divisible<ret_t &, const rcf_t &>>;
+    }
+}
+
+// Compute x**y via the J.C.P. Miller recurrence, with n the total
+// degree truncation level of x. Writing x = f_0 + f_1 + ... + f_n,
+// where f_k is the homogeneous component of x of degree k, and
+// x**y = g_0 + g_1 + ..., from the identity x * E(x**y) = y * x**y * E(x),
+// where E is the Euler operator (i.e., E(f_k) = k * f_k), it follows that
+// g_0 = f_0**y and, for k > 0,
+//
+// g_k = 1 / (k * f_0) * sum_{j=1}^{k} ((y + 1) * j - k) * f_j * g_{k-j}.
+//
+// The recurrence requires f_0 to be a nonzero constant term, and all the
+// terms of x to have a non-negative degree. With integral coefficients,
+// the divisions are exact only if y is a non-negative integral value or
+// if f_0 is +-1 (in which case the coefficients of x**y are integral).
+// If these conditions are not satisfied, an empty optional is returned.
+// NOTE: the products f_j * g_{k-j} are products of homogeneous
+// components, and thus they do not need any truncation.
+template <typename T, typename U, typename D>
+inline ::std::optional<customisation::internal::series_default_pow_ret_t<const T &, const U &>>
+ps_pow_miller(const T &x, const U &y, const D &n)
+{
+    using ret_t = customisation::internal::series_default_pow_ret_t<const T &, const U &>;
+    using rcf_t = series_cf_t<ret_t>;
+    using key_t = series_key_t<T>;
+    using d_impl = customisation::internal::series_default_degree_impl;
+
+    static_assert(::std::is_same_v<D, ::obake::detail::psk_deg_t<key_t>>);
+
+    if constexpr (::std::is_signed_v<D>) {
+        if (n < 0) {
+            return {};
+        }
+    }
+
+    const auto &ss = x.get_symbol_set();
+    const d_impl::d_extractor<T> d_ext{&ss};
+
+    // Determine the max degree of x and locate
+    // the constant term, checking the degrees.
+    const series_cf_t<T> *f0 = nullptr;
+    D max_deg(0);
+    for (const auto &t : x) {
+        const auto d = d_ext(t);
+
+        if constexpr (::std::is_signed_v<D>) {
+            if (d < 0) {
+                return {};
+            }
+        }
+
+        if (d == 0) {
+            // NOTE: with negative exponents, the key
+            // may have zero degree without being unitary.
+            if (!::obake::key_is_one(t.first, ss)) {
+                return {};
+            }
+
+            f0 = &t.second;
+        }
+
+        max_deg = ::std::max(max_deg, d);
+    }
+
+    if (f0 == nullptr) {
+        return {};
+    }
+
+    if constexpr (ps_cf_is_integral<rcf_t>) {
+        const rcf_t c0(*f0);
+        bool exact = c0 == rcf_t(1) || (!::std::is_unsigned_v<rcf_t> && c0 == rcf_t(-1));
+        if constexpr (is_safely_convertible_v<const U &, unsigned &>) {
+            if (unsigned un; ::obake::safe_convert(un, y)) {
+                exact = true;
+            }
+        }
+
+        if (!exact) {
+            return {};
+        }
+    }
+
+    // Determine the max degree of the result. If y is a non-negative
+    // integral value, the degree of x**y cannot exceed y * max_deg.
+    // NOTE: max_deg <= n, due to the truncation of x.
+    auto kmax = static_cast<::std::size_t>(n);
+    if constexpr (is_safely_convertible_v<const U &, unsigned &>) {
+        if (unsigned un; ::obake::safe_convert(un, y)) {
+            const auto md = static_cast<::std::size_t>(max_deg);
+
+            if (md != 0u && un <= kmax / md) {
+                kmax = un * md;
+            }
+        }
+    }
+
+    // Split x into homogeneous components.
+    ::std::vector<ret_t> f(static_cast<::std::size_t>(max_deg) + 1u);
+    for (auto &c : f) {
+        c.set_symbol_set_fw(x.get_symbol_set_fw());
+    }
+    for (const auto &t : x) {
+        f[static_cast<::std::size_t>(d_ext(t))].add_term(t.first, rcf_t(t.second));
+    }
+
+    // Init the homogeneous components of the result.
+    ::std::vector<ret_t> g(kmax + 1u);
+    for (auto &c : g) {
+        c.set_symbol_set_fw(x.get_symbol_set_fw());
+    }
+    g[0].add_term(key_t(ss), ::obake::pow(*f0, y));
+
+    const rcf_t f0r(*f0), y1 = rcf_t(y) + rcf_t(D(1));
+
+    for (::std::size_t k = 1; k <= kmax; ++k) {
+        auto &acc = g[k];
+        const rcf_t rk(static_cast<D>(k));
+
+        for (::std::size_t j = 1; j <= ::std::min(k, f.size() - 1u); ++j) {
+            if (f[j].empty() || g[k - j].empty()) {
+                continue;
+            }
+
+            const auto c = y1 * rcf_t(static_cast<D>(j)) - rk;
+            if (::obake::is_zero(c)) {
+                continue;
+            }
+
+            auto tmp(f[j]);
+            tmp *= c;
+            acc += tmp * g[k - j];
+        }
+
+        acc /= rk * f0r;
+    }
+
+    // Assemble the result.
+    ::std::optional<ret_t> retval(::std::move(g[0]));
+    for (::std::size_t k = 1; k <= kmax; ++k) {
+        *retval += ::std::move(g[k]);
+    }
+
+    return retval;
+}
+
+// Establish if the J.C.P. Miller recurrence
+// should be preferred for the computation of x**y.
+// For small non-negative integral exponents, the
+// cached repeated multiplications are preferred.
+template <typename U>
+inline bool ps_pow_miller_preferred(const U &y)
+{
+    if constexpr (is_safely_convertible_v<const U &, unsigned &>) {
+        if (unsigned un; ::obake::safe_convert(un, y)) {
+            return un > 2u;
+        }
+    }
+
+    return true;
+}
+
+} // namespace detail
+
+// Exponentiation: for power series with total degree truncation
+// and a constant term, the J.C.P. Miller recurrence is used. Otherwise,
+// we re-use the poly implementation, ensuring that the output
+// is properly truncated.
 template <typename T, typename U>
     requires any_p_series<remove_cvref_t<T>> && (customisation::internal::series_default_pow_algo<T &&, U &&> != 0)
 inline customisation::internal::series_default_pow_ret_t<T &&, U &&> pow(T &&x, U &&y)
 {
+    if constexpr (detail::ps_pow_miller_supported<T &&, U &&>()) {
+        using deg_t = ::obake::detail::psk_deg_t<series_key_t<remove_cvref_t<T>>>;
+
+        if (const auto *n = ::std::get_if<deg_t>(&::obake::get_truncation(x));
+            n != nullptr && x.size() > 1u && detail::ps_pow_miller_preferred(::std::as_const(y))) {
+            if (auto ret = detail::ps_pow_miller(::std::as_const(x), ::std::as_const(y), *n)) {
+                ret->tag() = x.tag();
+                ::obake::truncate(*ret);
+
+                return ::std::move(*ret);
+            }
+        }
+    }
+
     // Store x's tag.
     auto orig_tag = x.tag();
 
@@ -1439,8 +1729,392 @@ inline polynomials::detail::poly_integrate_ret_t<T &&> integrate(T &&x, const ::
     return ret;
 }
 
+namespace detail
+{
+
+// Requirements for the Newton-based elementary functions
+// of power series (see below):
+// - the degree type must be a C++ integral type,
+// - the coefficient type must not be an integral type (as
+//   the Newton iterations require exact coefficient division),
+// - the coefficient type must be constructible from int and
+//   from the degree type, it must be equality comparable and it must
+//   support the basic arithmetic operations (returning C),
+// - the truncated multiplication of power series must be available
+//   and it must return the same power series type.
+// NOTE: the coefficient division is assumed to be exact
+// (e.g., floating-point or rational coefficients).
+template <typename K, typename C>
+concept ps_newton_supported
+    = ::std::is_integral_v<::obake::detail::psk_deg_t<K>> && !ps_cf_is_integral<C> && ::std::is_constructible_v<C, int>
+      && ::std::is_constructible_v<C, ::obake::detail::psk_deg_t<K>> && EqualityComparable<const C &>
+      && ::std::is_same_v<C, detected_t<::obake::detail::add_t, const C &, const C &>>
+      && ::std::is_same_v<C, detected_t<::obake::detail::sub_t, const C &, const C &>>
+      && ::std::is_same_v<C, detected_t<::obake::detail::mul_t, const C &, const C &>>
+      && ::std::is_same_v<C, detected_t<::obake::detail::div_t, const C &, const C &>>
+      && (detail::ps_mul_algo<p_series<K, C>, p_series<K, C>>() == true)
+      && ::std::is_same_v<::obake::polynomials::detail::poly_mul_ret_t<p_series<K, C>, p_series<K, C>>,
+                          p_series<K, C>>;
+
+// Detection of the elementary functions for
+// the coefficients, via std or ADL.
+namespace ps_cf_funcs
+{
+
+using ::std::exp;
+using ::std::log;
+using ::std::sqrt;
+
+template <typename T>
+using exp_t = decltype(exp(::std::declval<const T &>()));
+
+template <typename T>
+using log_t = decltype(log(::std::declval<const T &>()));
+
+template <typename T>
+using sqrt_t = decltype(sqrt(::std::declval<const T &>()));
+
+} // namespace ps_cf_funcs
+
+// Check the input power series ps of the Newton-based function 'name'.
+// ps must have total degree truncation, and its terms must
+// have non-negative degrees. The terms of degree zero must
+// have unitary key (i.e., the degree-zero component of ps must be
+// a constant). The return value is the truncation level and a pointer
+// to the constant term's coefficient (null if ps has no constant term).
+template <typename K, typename C>
+inline auto ps_newton_check(const p_series<K, C> &ps, const char *name)
+{
+    using deg_t = ::obake::detail::psk_deg_t<K>;
+    using d_impl = customisation::internal::series_default_degree_impl;
+
+    const auto *n = ::std::get_if<deg_t>(&::obake::get_truncation(ps));
+    if (obake_unlikely(n == nullptr)) {
+        obake_throw(::std::invalid_argument,
+                    fmt::format("The function {}() requires a power series with total degree truncation", name));
+    }
+
+    const auto &ss = ps.get_symbol_set();
+    const d_impl::d_extractor<p_series<K, C>> d_ext{&ss};
+
+    const C *c0 = nullptr;
+    for (const auto &t : ps) {
+        const auto d = d_ext(t);
+
+        bool neg = false;
+        if constexpr (::std::is_signed_v<deg_t>) {
+            neg = d < 0;
+        }
+
+        if (obake_unlikely(neg || (d == 0 && !::obake::key_is_one(t.first, ss)))) {
+            obake_throw(::std::invalid_argument,
+                        fmt::format("The function {}() requires a power series whose terms have non-negative "
+                                    "degrees, and whose terms of zero degree are constants",
+                                    name));
+        }
+
+        if (d == 0) {
+            c0 = &t.second;
+        }
+    }
+
+    return ::std::make_pair(*n, c0);
+}
+
+// The next degree in the Newton iteration: if the current
+// approximation is exact up to degree d (i.e., with a precision of
+// d + 1), the next one will be exact up to degree 2 * d + 1, capped at n.
+template <typename D>
+inline D ps_newton_next_deg(const D &d, const D &n)
+{
+    assert(d < n);
+
+    // NOTE: 2 * d + 1 >= n if and only if d >= n / 2
+    // (with integer division), the latter form avoids
+    // overflow.
+    return d >= n / 2 ? n : static_cast<D>(2 * d + 1);
+}
+
+// Untruncated copy of ps, retaining only the terms
+// of degree up to d.
+template <typename K, typename C, typename D>
+inline p_series<K, C> ps_newton_trunc(const p_series<K, C> &ps, const D &d)
+{
+    auto retval(ps);
+    ::obake::unset_truncation(retval);
+    power_series::truncate_degree(retval, d);
+
+    return retval;
+}
+
+// Truncated multiplication of two power series
+// without truncation, retaining only the terms
+// of degree up to d.
+template <typename K, typename C, typename D>
+inline p_series<K, C> ps_newton_tmul(const p_series<K, C> &a, const p_series<K, C> &b, const D &d)
+{
+    return polynomials::detail::poly_mul_impl_switch(a, b, d);
+}
+
+// Constant power series with value c and the symbol set of ps.
+template <typename K, typename C>
+inline p_series<K, C> ps_newton_const(const p_series<K, C> &ps, C c)
+{
+    p_series<K, C> retval;
+    retval.set_symbol_set_fw(ps.get_symbol_set_fw());
+    retval.add_term(K(ps.get_symbol_set()), ::std::move(c));
+
+    return retval;
+}
+
+// Apply the Euler operator to ps (i.e., multiply each
+// term by its degree) or, if Inverse is true, its inverse
+// (i.e., divide each term by its degree; terms of
+// degree zero are discarded).
+template <bool Inverse, typename K, typename C>
+inline p_series<K, C> ps_euler(const p_series<K, C> &ps)
+{
+    using d_impl = customisation::internal::series_default_degree_impl;
+
+    p_series<K, C> retval;
+    retval.set_symbol_set_fw(ps.get_symbol_set_fw());
+    retval.reserve(ps.size());
+
+    const d_impl::d_extractor<p_series<K, C>> d_ext{&ps.get_symbol_set()};
+    for (const auto &t : ps) {
+        const auto d = d_ext(t);
+
+        if (d == 0) {
+            continue;
+        }
+
+        if constexpr (Inverse) {
+            retval.add_term(t.first, t.second / C(d));
+        } else {
+            retval.add_term(t.first, t.second * C(d));
+        }
+    }
+
+    return retval;
+}
+
+// Reciprocal of f up to degree n, with c0 the constant term
+// of f (which must be nonzero). The return value has no truncation.
+// This uses the Newton iteration g' = g - g * (f * g - 1),
+// which doubles the precision at each step.
+template <typename K, typename C, typename D>
+inline p_series<K, C> ps_inv_impl(const p_series<K, C> &f, const C &c0, const D &n)
+{
+    auto g = detail::ps_newton_const(f, C(1) / c0);
+
+    for (D d(0); d < n;) {
+        d = detail::ps_newton_next_deg(d, n);
+
+        auto e = detail::ps_newton_tmul(detail::ps_newton_trunc(f, d), g, d);
+        e -= 1;
+        g -= detail::ps_newton_tmul(g, e, d);
+    }
+
+    return g;
+}
+
+// Logarithm of f up to degree n, with c0 the constant term of
+// f (which must be nonzero), excluding the contribution of log(c0).
+// The return value has no truncation. This uses the
+// identity E(log(f)) = E(f) / f, where E is the Euler operator.
+template <typename K, typename C, typename D>
+inline p_series<K, C> ps_log_impl(const p_series<K, C> &f, const C &c0, const D &n)
+{
+    return detail::ps_euler<true>(detail::ps_newton_tmul(detail::ps_euler<false>(detail::ps_newton_trunc(f, n)),
+                                                         detail::ps_inv_impl(f, c0, n), n));
+}
+
+// Throw if the constant term c0 of the input
+// of the Newton-based function 'name' is zero.
+template <typename C>
+inline void ps_newton_check_c0(const C *c0, const char *name)
+{
+    if (obake_unlikely(c0 == nullptr)) {
+        obake_throw(::std::invalid_argument,
+                    fmt::format("The function {}() requires a power series with a nonzero constant term", name));
+    }
+}
+
+// Helper to throw if an elementary function
+// of a coefficient is not available.
+template <typename K, typename C>
+[[noreturn]] inline void ps_newton_cf_func_fail(const char *func)
+{
+    obake_throw(::std::invalid_argument,
+                fmt::format("Cannot compute the {} of the constant term of a power series of type '{}'", func,
+                            ::obake::type_name<p_series<K, C>>()));
+}
+
+// Implementation of p_series_inv().
+template <typename K, typename C>
+inline p_series<K, C> ps_inv(const p_series<K, C> &f)
+{
+    const auto [n, c0] = detail::ps_newton_check(f, "p_series_inv");
+    detail::ps_newton_check_c0(c0, "p_series_inv");
+
+    auto ret = detail::ps_inv_impl(f, *c0, n);
+    ret.tag() = f.tag();
+
+    return ret;
+}
+
+// Implementation of p_series_sqrt().
+// This computes first 1 / sqrt(f) via the Newton iteration
+// h' = h - h * (f * h**2 - 1) / 2, and then sqrt(f) = f * h.
+template <typename K, typename C>
+inline p_series<K, C> ps_sqrt(const p_series<K, C> &f)
+{
+    const auto [n, c0] = detail::ps_newton_check(f, "p_series_sqrt");
+    detail::ps_newton_check_c0(c0, "p_series_sqrt");
+
+    // The square root of the constant term.
+    const auto s0 = [c0 = c0]() -> C {
+        if (*c0 == C(1)) {
+            return C(1);
+        }
+
+        if constexpr (::std::is_constructible_v<C, detected_t<ps_cf_funcs::sqrt_t, C>>) {
+            using ::std::sqrt;
+
+            return C(sqrt(*c0));
+        } else {
+            detail::ps_newton_cf_func_fail<K, C>("square root");
+        }
+    }();
+
+    auto h = detail::ps_newton_const(f, C(1) / s0);
+
+    for (::std::remove_const_t<decltype(n)> d(0); d < n;) {
+        d = detail::ps_newton_next_deg(d, n);
+
+        auto e = detail::ps_newton_tmul(detail::ps_newton_trunc(f, d), detail::ps_newton_tmul(h, h, d), d);
+        e -= 1;
+        auto u = detail::ps_newton_tmul(h, e, d);
+        u /= C(2);
+        h -= u;
+    }
+
+    auto ret = detail::ps_newton_tmul(detail::ps_newton_trunc(f, n), h, n);
+    ret.tag() = f.tag();
+
+    return ret;
+}
+
+// Implementation of p_series_log().
+template <typename K, typename C>
+inline p_series<K, C> ps_log(const p_series<K, C> &f)
+{
+    const auto [n, c0] = detail::ps_newton_check(f, "p_series_log");
+    detail::ps_newton_check_c0(c0, "p_series_log");
+
+    auto ret = detail::ps_log_impl(f, *c0, n);
+
+    // Add the logarithm of the constant term.
+    if (!(*c0 == C(1))) {
+        if constexpr (::std::is_constructible_v<C, detected_t<ps_cf_funcs::log_t, C>>) {
+            using ::std::log;
+
+            ret += C(log(*c0));
+        } else {
+            detail::ps_newton_cf_func_fail<K, C>("logarithm");
+        }
+    }
+
+    ret.tag() = f.tag();
+
+    return ret;
+}
+
+// Implementation of p_series_exp().
+// This computes first exp(f - c0), with c0 the constant term
+// of f, via the Newton iteration g' = g + g * (f - c0 - log(g)),
+// and then exp(f) = exp(c0) * exp(f - c0).
+template <typename K, typename C>
+inline p_series<K, C> ps_exp(const p_series<K, C> &f)
+{
+    const auto [n, c0] = detail::ps_newton_check(f, "p_series_exp");
+
+    // The exponential of the constant term.
+    const auto e0 = [c0 = c0]() -> C {
+        if (c0 == nullptr) {
+            return C(1);
+        }
+
+        if constexpr (::std::is_constructible_v<C, detected_t<ps_cf_funcs::exp_t, C>>) {
+            using ::std::exp;
+
+            return C(exp(*c0));
+        } else {
+            detail::ps_newton_cf_func_fail<K, C>("exponential");
+        }
+    }();
+
+    // f - c0.
+    auto f1 = detail::ps_newton_trunc(f, n);
+    if (c0 != nullptr) {
+        f1 -= *c0;
+    }
+
+    auto g = detail::ps_newton_const(f, C(1));
+
+    for (::std::remove_const_t<decltype(n)> d(0); d < n;) {
+        d = detail::ps_newton_next_deg(d, n);
+
+        auto e = detail::ps_newton_trunc(f1, d);
+        e -= detail::ps_log_impl(g, C(1), d);
+        g += detail::ps_newton_tmul(g, e, d);
+    }
+
+    if (c0 != nullptr) {
+        g *= e0;
+    }
+
+    g.tag() = f.tag();
+
+    return g;
+}
+
+} // namespace detail
+
 } // namespace power_series
 
+// Newton-based elementary functions for power series with
+// total degree truncation. At each step of the Newton iterations,
+// the precision (i.e., the truncation degree) of the result is
+// doubled, so that the total cost is a small multiple of the cost
+// of a truncated multiplication at the final truncation level.
+// The input series must have a constant term (except for
+// p_series_exp()), non-negative degrees and constant
+// components of zero degree.
+inline constexpr auto p_series_inv = []<typename K, typename C>(const p_series<K, C> &ps)
+    requires power_series::detail::ps_newton_supported<K, C>
+{
+    return power_series::detail::ps_inv(ps);
+};
+
+inline constexpr auto p_series_sqrt = []<typename K, typename C>(const p_series<K, C> &ps)
+    requires power_series::detail::ps_newton_supported<K, C>
+{
+    return power_series::detail::ps_sqrt(ps);
+};
+
+inline constexpr auto p_series_exp = []<typename K, typename C>(const p_series<K, C> &ps)
+    requires power_series::detail::ps_newton_supported<K, C>
+{
+    return power_series::detail::ps_exp(ps);
+};
+
+inline constexpr auto p_series_log = []<typename K, typename C>(const p_series<K, C> &ps)
+    requires power_series::detail::ps_newton_supported<K, C>
+{
+    return power_series::detail::ps_log(ps);
+};
+
 } // namespace obake
 
 #endif
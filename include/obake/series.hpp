@@ -11,13 +11,19 @@
 
 #include <algorithm>
 #include <any>
+#include <atomic>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <iterator>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <numeric>
+#include <optional>
 #include <ostream>
 #include <sstream>
 #include <stdexcept>
@@ -43,6 +49,7 @@
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/task_arena.h>
 
 #include <mp++/integer.hpp>
 
@@ -556,6 +563,12 @@ struct series_rref_clearer {
     T &&m_ref;
 };
 
+// Minimum number of terms above which the term-wise operations
+// on a segmented series are run in parallel, one range of tables
+// at a time. These operations perform a small and roughly constant
+// amount of work per term, hence a single threshold is used for all of them.
+inline constexpr ::std::size_t series_par_threshold = 50000;
+
 // Helper to extend the keys of "from" with the symbol insertion map ins_map.
 // The new series will be written to "to". The coefficient type of "to"
 // may be different from the coefficient type of "from", in which case a coefficient
@@ -599,7 +612,124 @@ inline void series_sym_extender(To &to, From &&from, const symbol_idx_map<symbol
         = static_cast<sat_check_zero>(::std::is_same_v<series_cf_t<To>, series_cf_t<remove_cvref_t<From>>>);
 
     // Merge the terms, distinguishing the segmented vs non-segmented case.
-    if (from_log2_size) {
+    if (from_log2_size && from.size() >= series_par_threshold) {
+        // Large segmented series: proceed in three parallel passes.
+        auto &from_table = from._get_s_table();
+        auto &to_table = to._get_s_table();
+
+        using s_size_t = remove_cvref_t<decltype(from_table.size())>;
+        const auto nsegs = from_table.size();
+        assert(to_table.size() == nsegs);
+
+        // The merging of symbols changes the keys, and thus also their
+        // hashes: the terms of a table of "from" end up scattered among
+        // the tables of "to". The terms are redistributed via a counting sort.
+        // The tables of "from" are processed in a fixed number of chunks, so that
+        // the number of counters is bounded and the order in which the terms are
+        // inserted into the tables of "to" does not depend on the scheduling.
+        const auto nchunks = ::std::min(nsegs, s_size_t(64));
+        const auto chunk_size = nsegs / nchunks;
+        assert(chunk_size * nchunks == nsegs);
+
+        // The offsets of the terms of each table of "from"
+        // in the flat vector of destination indices.
+        ::std::vector<::std::size_t> t_offs;
+        t_offs.resize(::obake::safe_cast<decltype(t_offs.size())>(nsegs + 1u));
+        for (s_size_t i = 0; i < nsegs; ++i) {
+            t_offs[i + 1u] = t_offs[i] + from_table[i].size();
+        }
+        const auto n_terms = t_offs.back();
+
+        // In the first pass, the merged keys are computed for each
+        // table of "from", and they are stored, together with pointers
+        // to the original coefficients, in the same order as the terms
+        // of "from". The terms going into each table of "to" are
+        // counted for each chunk.
+        using key_t = series_key_t<remove_cvref_t<From>>;
+        using cf_ptr_t = decltype(&from_table[0].begin()->second);
+        using mk_t = ::std::pair<key_t, cf_ptr_t>;
+        ::std::vector<::std::vector<mk_t>> mkeys;
+        mkeys.resize(::obake::safe_cast<decltype(mkeys.size())>(nsegs));
+        ::std::vector<s_size_t> dests;
+        dests.resize(::obake::safe_cast<decltype(dests.size())>(n_terms));
+        // NOTE: counts[c * nsegs + j] is the number of terms
+        // of the chunk c going into the table j of "to".
+        ::std::vector<::std::size_t> counts;
+        counts.resize(::obake::safe_cast<decltype(counts.size())>(nchunks * nsegs));
+
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nchunks), [&](const auto &range) {
+            for (auto c = range.begin(); c != range.end(); ++c) {
+                for (auto i = c * chunk_size; i < (c + 1u) * chunk_size; ++i) {
+                    auto &mk = mkeys[i];
+                    mk.reserve(::obake::safe_cast<decltype(mk.size())>(from_table[i].size()));
+
+                    auto d_ptr = dests.data() + t_offs[i];
+                    for (auto &term : from_table[i]) {
+                        mk.emplace_back(::obake::key_merge_symbols(term.first, ins_map, orig_ss), &term.second);
+
+                        const auto d = static_cast<s_size_t>(::obake::hash(::std::as_const(mk.back().first))
+                                                             & (nsegs - 1u));
+                        *d_ptr++ = d;
+                        ++counts[c * nsegs + d];
+                    }
+                }
+            }
+        });
+
+        // Turn the counts into offsets in the flat vector of sorted terms,
+        // in which the terms are ordered by destination table, then by chunk.
+        ::std::vector<::std::size_t> d_offs;
+        d_offs.resize(::obake::safe_cast<decltype(d_offs.size())>(nsegs + 1u));
+        ::std::size_t acc = 0;
+        for (s_size_t j = 0; j < nsegs; ++j) {
+            d_offs[j] = acc;
+            for (s_size_t c = 0; c < nchunks; ++c) {
+                acc += ::std::exchange(counts[c * nsegs + j], acc);
+            }
+        }
+        d_offs[nsegs] = acc;
+        assert(acc == n_terms);
+
+        // In the second pass, the pointers to the merged
+        // keys are scattered into the flat vector of sorted terms.
+        ::std::vector<mk_t *> sorted;
+        sorted.resize(::obake::safe_cast<decltype(sorted.size())>(n_terms));
+
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nchunks), [&](const auto &range) {
+            for (auto c = range.begin(); c != range.end(); ++c) {
+                for (auto i = c * chunk_size; i < (c + 1u) * chunk_size; ++i) {
+                    auto d_ptr = dests.data() + t_offs[i];
+                    for (auto &mk : mkeys[i]) {
+                        sorted[counts[c * nsegs + *d_ptr++]++] = &mk;
+                    }
+                }
+            }
+        });
+
+        // In the third pass, each table of "to" is filled
+        // independently from its range of sorted terms.
+        // NOTE: we need the same checks as in the serial implementation below.
+        // The merged keys are unique, as noted below.
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&](const auto &range) {
+            for (auto j = range.begin(); j != range.end(); ++j) {
+                auto &tab = to_table[j];
+
+                for (auto k = d_offs[j]; k < d_offs[j + 1u]; ++k) {
+                    auto &[key, cptr] = *sorted[k];
+
+                    if constexpr (is_mutable_rvalue_reference_v<From &&>) {
+                        detail::series_add_term_table<true, check_zero, sat_check_compat_key::off,
+                                                      sat_check_table_size::on, sat_assume_unique::on>(
+                            to, tab, ::std::move(key), ::std::move(*cptr));
+                    } else {
+                        detail::series_add_term_table<true, check_zero, sat_check_compat_key::off,
+                                                      sat_check_table_size::on, sat_assume_unique::on>(
+                            to, tab, ::std::move(key), ::std::as_const(*cptr));
+                    }
+                }
+            }
+        });
+    } else if (from_log2_size) {
         for (auto &t : from._get_s_table()) {
             for (auto &term : t) {
                 // NOTE: old clang does not like structured
@@ -1572,6 +1702,43 @@ inline void swap(series<K, C, Tag> &s1, series<K, C, Tag> &s2) noexcept
     s1.swap(s2);
 }
 
+// The algorithms for the computation of the
+// powers missing from the series pow cache.
+enum class pow_algo {
+    // Compute (and cache) all the intermediate
+    // powers via repeated multiplications.
+    linear,
+    // Compute (and cache) only the requested
+    // power via square-and-multiply.
+    binary,
+    // Pick binary if it saves more than half of
+    // the multiplications required by linear.
+    automatic
+};
+
+// Statistics about the series pow cache.
+struct pow_cache_stats {
+    // The number of requests for which
+    // the power was already in the cache
+    // (or being computed by another thread).
+    ::std::size_t hits = 0;
+    // The number of requests for which at least
+    // one power had to be computed.
+    ::std::size_t misses = 0;
+    // The number of bases evicted from the cache.
+    ::std::size_t evictions = 0;
+    // The number of bases in the cache.
+    ::std::size_t n_bases = 0;
+    // The total size (in bytes) of the bases
+    // and powers in the cache.
+    ::std::size_t bytes = 0;
+    // The capacity limit (in bytes).
+    ::std::size_t max_bytes = 0;
+    // The size (in bytes) of the bases and powers
+    // in the cache, grouped by series type.
+    ::std::map<::std::string, ::std::size_t> bytes_per_type;
+};
+
 namespace customisation::internal
 {
 
@@ -1628,122 +1795,564 @@ inline bool series_are_identical(const S &s1, const S &s2)
     return s1.get_symbol_set_fw() == s2.get_symbol_set_fw() && internal::series_cmp_identical_ss(s1, s2);
 }
 
+// The key type of the series pow cache. It contains
+// the hash of a base and a type-erased pointer to it.
+// NOTE: the keys stored in the cache point to the bases
+// stored in the cache entries, while the keys used for
+// lookup point to the bases provided by the user, so that
+// the lookup does not require copying or re-hashing the base.
+struct series_pow_cache_key {
+    ::std::size_t hash;
+    const void *ptr;
+};
+
+struct series_pow_cache_key_hasher {
+    ::std::size_t operator()(const series_pow_cache_key &k) const noexcept
+    {
+        return k.hash;
+    }
+};
+
+// An entry of the series pow cache, containing a base
+// and its natural powers.
+struct series_pow_cache_entry {
+    // The base (an instance of the series type).
+    ::std::any base;
+    // The name of the series type.
+    ::std::string type_name;
+    // The series type, and the key under which
+    // the entry is stored in the cache.
+    const ::std::type_info *type = nullptr;
+    series_pow_cache_key key{};
+    // Mutex protecting the vector of powers,
+    // the byte size and the eviction flag.
+    ::std::mutex mutex;
+    // The natural powers of the base (instances of the
+    // series type). powers[i] becomes ready once base**i
+    // has been computed.
+    ::std::vector<::std::shared_future<::std::any>> powers;
+    // The powers beyond the contiguous sequence,
+    // computed via the binary algorithm.
+    ::std::map<unsigned, ::std::shared_future<::std::any>> sparse_powers;
+    // The number of times the vector of powers was truncated
+    // after a failed computation. It allows a thread to determine
+    // whether the powers it published are still in the vector.
+    ::std::uint64_t n_truncations = 0;
+    // The total byte size of the base and
+    // of the powers computed so far.
+    // NOTE: if the computation of a power fails, the
+    // byte sizes of the powers discarded from the cache
+    // are not subtracted (they will be subtracted from the
+    // global counter when the entry is evicted).
+    ::std::size_t bytes = 0;
+    // Flag signalling that the entry was
+    // evicted from the cache.
+    bool evicted = false;
+    // The time of last use (as a value of series_pow_cache_epoch),
+    // and the neighbours of the entry in the LRU list of its shard.
+    // NOTE: these are protected by the mutex of
+    // the shard containing the entry.
+    ::std::uint64_t last_use = 0;
+    series_pow_cache_entry *lru_prev = nullptr;
+    series_pow_cache_entry *lru_next = nullptr;
+};
+
 // The series pow cache for a specific series type.
-// It maps a series instance x to a vector of natural
-// powers of x. Everything is type-erased as we need
-// to store instances of this type as elements of another map.
-// NOTE: the key in this map is the base, the vectors
-// are the base raised to its natural powers. All these
-// std::any will contain instances of the base type.
-using series_te_pow_map_t = ::std::unordered_map<::std::any, ::std::vector<::std::any>,
-                                                 // Hashing functor.
-                                                 ::std::function<::std::size_t(const ::std::any &)>,
-                                                 // Equality comparator.
-                                                 ::std::function<bool(const ::std::any &, const ::std::any &)>>;
+// It maps the base to the cache entry containing its powers.
+// The equality comparator is type-erased as we need to store
+// instances of this type as elements of another map.
+using series_te_pow_map_t
+    = ::std::unordered_map<series_pow_cache_key, ::std::shared_ptr<series_pow_cache_entry>, series_pow_cache_key_hasher,
+                           ::std::function<bool(const series_pow_cache_key &, const series_pow_cache_key &)>>;
 
 // Series pow cache. It maps a C++ series type, represented
 // as a type_index, to a series_te_pow_map_t map.
 using series_pow_map_t = ::std::unordered_map<::std::type_index, series_te_pow_map_t>;
 
-// Function to fetch the global series pow cache and associated mutex.
-OBAKE_DLL_PUBLIC ::std::tuple<series_pow_map_t &, ::std::mutex &> get_series_pow_map();
+// The series pow cache is split into shards, each
+// protected by its own mutex. The entries of a shard are
+// kept in a doubly-linked list in order of last use, from
+// the most recently used (head) to the least recently used (tail).
+// NOTE: align to avoid false sharing between shards.
+struct alignas(64) series_pow_cache_shard {
+    ::std::mutex mutex;
+    series_pow_map_t map;
+    series_pow_cache_entry *lru_head = nullptr;
+    series_pow_cache_entry *lru_tail = nullptr;
+    // The number of hits and misses
+    // for the bases in the shard.
+    ::std::atomic<::std::size_t> hits = 0;
+    ::std::atomic<::std::size_t> misses = 0;
+};
+
+// Fetch the shard of the global series pow
+// cache corresponding to the hash value h.
+OBAKE_DLL_PUBLIC series_pow_cache_shard &get_series_pow_cache_shard(::std::size_t);
 
 // Function to clear the global series pow cache.
 OBAKE_DLL_PUBLIC void clear_series_pow_map();
 
+// Function to fetch the number of bases
+// in the global series pow cache.
+OBAKE_DLL_PUBLIC ::std::size_t series_pow_map_size();
+
+// Global data for the byte accounting and
+// the eviction of the series pow cache.
+// NOTE: the epoch is the clock used to order the entries
+// of different shards for eviction. It is advanced on
+// misses only, so that hits never write to shared data
+// outside their shard.
+OBAKE_DLL_PUBLIC extern ::std::atomic<::std::uint64_t> series_pow_cache_epoch;
+OBAKE_DLL_PUBLIC extern ::std::atomic<::std::size_t> series_pow_cache_bytes;
+OBAKE_DLL_PUBLIC extern ::std::atomic<::std::size_t> series_pow_cache_max_bytes;
+
+// Remove the entry e from the LRU list of the shard s.
+// NOTE: this must be invoked while holding the lock on s.
+inline void series_pow_cache_unlink(series_pow_cache_shard &s, series_pow_cache_entry &e)
+{
+    (e.lru_prev != nullptr ? e.lru_prev->lru_next : s.lru_head) = e.lru_next;
+    (e.lru_next != nullptr ? e.lru_next->lru_prev : s.lru_tail) = e.lru_prev;
+    e.lru_prev = nullptr;
+    e.lru_next = nullptr;
+}
+
+// Mark the entry e of the shard s as used in the current
+// epoch, moving it to the head of the LRU list of s (or
+// inserting it there, if e was just added to s).
+// NOTE: this must be invoked while holding the lock on s.
+inline void series_pow_cache_touch(series_pow_cache_shard &s, series_pow_cache_entry &e)
+{
+    e.last_use = series_pow_cache_epoch.load(::std::memory_order_relaxed);
+
+    if (s.lru_head == &e) {
+        return;
+    }
+
+    if (e.lru_prev != nullptr) {
+        internal::series_pow_cache_unlink(s, e);
+    }
+
+    e.lru_next = s.lru_head;
+    (s.lru_head != nullptr ? s.lru_head->lru_prev : s.lru_tail) = &e;
+    s.lru_head = &e;
+}
+
+// The algorithm used to compute the
+// powers missing from the series pow cache.
+OBAKE_DLL_PUBLIC extern ::std::atomic<pow_algo> series_pow_algo_setting;
+
+// The number of multiplications needed to compute
+// base**m (m > 0) via right-to-left square-and-multiply, that is,
+// floor(log2(m)) squarings plus popcount(m) - 1 multiplications.
+constexpr unsigned series_pow_binary_n_mults(unsigned m)
+{
+    assert(m > 0u);
+
+    unsigned retval = 0;
+    for (; m > 1u; m >>= 1) {
+        retval += 1u + (m & 1u);
+    }
+
+    return retval;
+}
+
+// Determine whether base**n should be computed via
+// the binary algorithm, given the highest power k in the
+// contiguous sequence of cached powers and the highest
+// cached power j (k <= j < n). The linear algorithm needs
+// n - k multiplications, the binary algorithm needs the
+// multiplications for base**(n - j), plus one to multiply
+// the result by base**j (if j > 0).
+constexpr bool series_pow_use_binary(pow_algo algo, unsigned n, unsigned k, unsigned j)
+{
+    assert(k <= j && j < n);
+
+    switch (algo) {
+        case pow_algo::linear:
+            return false;
+        case pow_algo::binary:
+            return true;
+        default:
+            // NOTE: compare 2 * bin < lin as 64-bit
+            // integers in order to avoid overflow.
+            return 2u * (static_cast<::std::uint64_t>(internal::series_pow_binary_n_mults(n - j)) + (j != 0u))
+                   < static_cast<::std::uint64_t>(n - k);
+    }
+}
+
+// Evict the least recently used bases from the series pow
+// cache until its size is within the capacity limit. The entry
+// skip (if not null) is never evicted, so that the powers just
+// computed for a base stay cached even if they alone exceed
+// the capacity limit.
+OBAKE_DLL_PUBLIC void series_pow_cache_evict(const series_pow_cache_entry *);
+
+// Fetch the statistics of the series pow cache.
+OBAKE_DLL_PUBLIC pow_cache_stats get_series_pow_cache_stats();
+
 // Fetch the n-th natural power of the input
 // series 'base' from the global cache. If the
 // power is not present in the cache already,
-// it will be computed on the fly.
+// it will be computed on the fly. If the cache exceeds
+// its capacity limit, the least recently used bases
+// are evicted.
+// The locks on the cache are never held while
+// the powers are being computed: a thread which
+// needs to compute missing powers publishes futures
+// for them, so that other threads requesting the
+// same powers will wait for the results (rather than
+// computing them again), while threads requesting
+// the powers of other bases can proceed in parallel.
 template <typename Base>
 inline Base series_pow_from_cache(const Base &base, unsigned n)
 {
-    // Fetch the global data.
-    auto [map, mutex] = internal::get_series_pow_map();
-
     // Turn the type into a type_index.
-    ::std::type_index t_idx(typeid(Base));
-
-    // The concrete hasher and equality comparator
-    // functors for use in series_te_pow_map_t.
-    // They will be wrapped in a std::function.
-    struct hasher {
-        ::std::size_t operator()(const ::std::any &x) const
-        {
-            const auto &bcast = ::std::any_cast<const Base &>(x);
-
-            // Init retval with the hash of the tag, if available,
-            // zero otherwise.
-            auto retval = [&bcast]() -> ::std::size_t {
-                if constexpr (is_hashable_v<const series_tag_t<Base> &>) {
-                    return ::obake::hash(bcast.tag());
-                } else {
-                    detail::ignore(bcast);
-                    return 0;
-                }
-            }();
-
-            // Combine the hashes of all terms
-            // via addition, so that their order
-            // does not matter.
-            for (const auto &t : bcast) {
-                // NOTE: use the same hasher used in the implementation
-                // of series.
-                // NOTE: parallelisation opportunities here for
-                // segmented tables.
-                retval += detail::series_key_hasher{}(t.first);
+    const ::std::type_index t_idx(typeid(Base));
+
+    // Compute the hash of the base.
+    const auto b_hash = [&base]() {
+        // Init retval with the hash of the tag, if available,
+        // zero otherwise.
+        auto retval = [&base]() -> ::std::size_t {
+            if constexpr (is_hashable_v<const series_tag_t<Base> &>) {
+                return ::obake::hash(base.tag());
+            } else {
+                detail::ignore(base);
+                return 0;
             }
-
-            return retval;
+        }();
+
+        // Combine the hashes of all terms
+        // via addition, so that their order
+        // does not matter.
+        for (const auto &t : base) {
+            // NOTE: use the same hasher used in the implementation
+            // of series.
+            // NOTE: parallelisation opportunities here for
+            // segmented tables.
+            retval += detail::series_key_hasher{}(t.first);
         }
-    };
 
+        return retval;
+    }();
+
+    // The concrete equality comparator for use
+    // in series_te_pow_map_t. It will be wrapped
+    // in a std::function.
     struct comparer {
-        bool operator()(const ::std::any &x, const ::std::any &y) const
+        bool operator()(const series_pow_cache_key &x, const series_pow_cache_key &y) const
         {
             // NOTE: need to use series_are_identical() (and not the comparison operator)
             // because the comparison operator does symbol merging, and thus it is
-            // not consistent with the hasher defined above (i.e., two series may
+            // not consistent with the hash computed above (i.e., two series may
             // compare equal according to operator==() and have different hashes).
-            // NOTE: with these choices of hasher/comparer, the requirement that
+            // NOTE: with these choices of hash/comparer, the requirement that
             // cmp(a, b) == true -> hash(a) == hash(b) is always satisfied (even if, say,
             // the user customises series_equal_to()).
-            return internal::series_are_identical(::std::any_cast<const Base &>(x), ::std::any_cast<const Base &>(y));
+            return x.hash == y.hash
+                   && internal::series_are_identical(*static_cast<const Base *>(x.ptr),
+                                                     *static_cast<const Base *>(y.ptr));
         }
     };
 
-    // Lock down before accessing the cache.
-    ::std::lock_guard lock(mutex);
+    // Fetch the shard.
+    auto &shard = internal::get_series_pow_cache_shard(::std::hash<::std::type_index>{}(t_idx) ^ b_hash);
 
-    // Try first to locate the series_te_pow_map_t for the current type,
-    // then, in that map, try to locate 'base'. Use try_emplace() so that
-    // table elements are created as needed.
-    auto it = map.try_emplace(t_idx, 0, hasher{}, comparer{}).first->second.try_emplace(base).first;
+    // Locate the cache entry for base, creating it if necessary.
+    // NOTE: the shared pointer keeps the entry alive
+    // even if the cache is cleared concurrently.
+    const auto entry = [&]() {
+        {
+            // Lock down before accessing the shard.
+            ::std::lock_guard lock(shard.mutex);
 
-    // Fetch a reference to the base and the corresponding
-    // exponentiation vector.
-    const auto &b = ::std::any_cast<const Base &>(it->first);
-    auto &v = it->second;
+            auto &te_map = shard.map.try_emplace(t_idx, 0, series_pow_cache_key_hasher{}, comparer{}).first->second;
+            if (const auto it = te_map.find(series_pow_cache_key{b_hash, &base}); it != te_map.end()) {
+                internal::series_pow_cache_touch(shard, *it->second);
 
-    // If the exponentiation vector is empty, init it with
-    // base**0 = 1.
-    if (v.empty()) {
+                return it->second;
+            }
+        }
+
+        // The base is not in the cache. Prepare a new entry
+        // (without holding the lock), containing a copy of the
+        // base and base**0 = 1.
         // NOTE: constructability from 1 is ensured by the
         // constructability of the return coefficient type from int
         // (and the return type is guaranteed to be the same as
         // the Base type in this function).
-        v.emplace_back(Base(1));
+        auto new_entry = ::std::make_shared<series_pow_cache_entry>();
+        new_entry->base = base;
+        new_entry->type_name = ::obake::type_name<Base>();
+        new_entry->type = &typeid(Base);
+        new_entry->key = series_pow_cache_key{b_hash, &::std::any_cast<const Base &>(new_entry->base)};
+        Base one(1);
+        new_entry->bytes = ::obake::byte_size(base) + ::obake::byte_size(one);
+        ::std::promise<::std::any> p0;
+        p0.set_value(::std::move(one));
+        new_entry->powers.push_back(p0.get_future().share());
+
+        ::std::lock_guard lock(shard.mutex);
+
+        // NOTE: another thread might have inserted the base in the meantime,
+        // in which case try_emplace() will return the existing entry.
+        auto &te_map = shard.map.try_emplace(t_idx, 0, series_pow_cache_key_hasher{}, comparer{}).first->second;
+        const auto ret = te_map.try_emplace(new_entry->key, new_entry);
+        if (ret.second) {
+            // NOTE: the byte size must be accounted for while
+            // holding the lock, otherwise the entry could be evicted
+            // before the accounting.
+            internal::series_pow_cache_bytes.fetch_add(new_entry->bytes, ::std::memory_order_relaxed);
+        }
+        internal::series_pow_cache_touch(shard, *ret.first->second);
+
+        return ret.first->second;
+    }();
+
+    using fut_t = ::std::shared_future<::std::any>;
+    using idx_t = decltype(entry->powers.size());
+
+    // The future for base**n.
+    fut_t ret_fut;
+
+    // The promises for the powers which will be computed
+    // by this thread via the linear algorithm (if any),
+    // the futures associated to them, the index of the first
+    // such power and the future for the power preceding it.
+    // NOTE: the powers in this range which were already
+    // available as sparse powers are not computed again: their
+    // promises are empty, and their futures are moved from the
+    // sparse powers.
+    ::std::vector<::std::optional<::std::promise<::std::any>>> proms;
+    ::std::vector<fut_t> futs;
+    idx_t first_idx = 0;
+    fut_t prev_fut;
+    // The number of truncations of the vector of
+    // powers at the time the futures were published.
+    ::std::uint64_t n_trunc = 0;
+
+    // The promise for base**n, if it will be computed
+    // by this thread via the binary algorithm, and
+    // the exponent of the cached power from which
+    // the computation will start.
+    ::std::optional<::std::promise<::std::any>> bin_prom;
+    unsigned bin_start = 0;
+
+    {
+        // Lock down before accessing the powers.
+        ::std::lock_guard lock(entry->mutex);
+
+        auto &v = entry->powers;
+        auto &sv = entry->sparse_powers;
+
+        if (n < v.size()) {
+            ret_fut = v[static_cast<idx_t>(n)];
+        } else if (const auto it = sv.find(n); it != sv.end()) {
+            ret_fut = it->second;
+        } else {
+            // The highest power in the contiguous sequence.
+            const auto k = static_cast<unsigned>(v.size() - 1u);
+
+            // The highest power available in the cache.
+            auto j = k;
+            prev_fut = v.back();
+            if (const auto it_sp = sv.lower_bound(n); it_sp != sv.begin() && ::std::prev(it_sp)->first > k) {
+                j = ::std::prev(it_sp)->first;
+                prev_fut = ::std::prev(it_sp)->second;
+            }
+
+            if (internal::series_pow_use_binary(internal::series_pow_algo_setting.load(::std::memory_order_relaxed),
+                                                n, k, j)) {
+                // Publish the future for base**n.
+                bin_prom.emplace();
+                ret_fut = bin_prom->get_future().share();
+                sv.emplace(n, ret_fut);
+                bin_start = j;
+            } else {
+                // Publish the futures for the missing powers.
+                first_idx = v.size();
+                prev_fut = v.back();
+
+                // NOTE: allocate everything before modifying v.
+                proms.resize(static_cast<decltype(proms.size())>(n - first_idx + 1u));
+                futs.reserve(proms.size());
+                for (decltype(proms.size()) i = 0; i < proms.size(); ++i) {
+                    if (const auto it_sp = sv.find(static_cast<unsigned>(first_idx + i)); it_sp != sv.end()) {
+                        futs.push_back(it_sp->second);
+                    } else {
+                        futs.push_back(proms[i].emplace().get_future().share());
+                    }
+                }
+                v.reserve(static_cast<idx_t>(n) + 1u);
+                v.insert(v.end(), futs.begin(), futs.end());
+                n_trunc = entry->n_truncations;
+
+                // The sparse powers up to n are now in
+                // the contiguous sequence, remove them from
+                // sv so that they are not stored twice.
+                // NOTE: their byte sizes were accounted for
+                // when they were computed, and they stay valid.
+                sv.erase(sv.begin(), sv.upper_bound(n));
+
+                ret_fut = v[static_cast<idx_t>(n)];
+            }
+        }
     }
 
-    // Fill in the missing powers as needed.
-    while (v.size() <= n) {
-        v.emplace_back(::std::any_cast<const Base &>(v.back()) * b);
+    // Helper to account for the byte size of a new
+    // power, unless the entry was evicted in the meantime.
+    auto account_bytes = [&entry](const Base &p) {
+        const auto bs = ::obake::byte_size(p);
+
+        ::std::lock_guard lock(entry->mutex);
+
+        if (!entry->evicted) {
+            entry->bytes += bs;
+            internal::series_pow_cache_bytes.fetch_add(bs, ::std::memory_order_relaxed);
+        }
+    };
+
+    // Compute the missing powers, if needed.
+    // NOTE: the powers are computed without holding any lock.
+    if (!proms.empty()) {
+        shard.misses.fetch_add(1, ::std::memory_order_relaxed);
+        internal::series_pow_cache_epoch.fetch_add(1, ::std::memory_order_relaxed);
+
+        const auto &b = ::std::any_cast<const Base &>(entry->base);
+
+        decltype(proms.size()) i = 0;
+        try {
+            // NOTE: the preceding power might still be
+            // in the process of being computed by another thread.
+            const auto *prev = &prev_fut.get();
+
+            // NOTE: run the multiplications in an isolated task arena. Otherwise,
+            // while waiting for the completion of parallel algorithms within
+            // the multiplications, this thread might pick up an unrelated
+            // TBB task which requests one of the powers we are computing,
+            // and which would thus wait forever on one of our futures.
+            ::tbb::this_task_arena::isolate([&]() {
+                while (i < proms.size()) {
+                    const auto owned = proms[i].has_value();
+                    if (owned) {
+                        proms[i]->set_value(::std::any_cast<const Base &>(*prev) * b);
+                    }
+                    // NOTE: if the power was moved from the sparse
+                    // powers, it might still be in the process
+                    // of being computed by another thread (and its
+                    // byte size will be accounted for by that thread).
+                    prev = &futs[i].get();
+                    ++i;
+
+                    if (owned) {
+                        account_bytes(::std::any_cast<const Base &>(*prev));
+                    }
+                }
+            });
+        } catch (...) {
+            // Remove the failed powers from the cache,
+            // so that they will be recomputed by later requests.
+            // NOTE: if the vector of powers was truncated after we published
+            // our futures, our powers were already removed (by a thread which failed
+            // computing a preceding power), and the entries which are now past
+            // first_idx (if any) belong to other threads. Otherwise, our failed powers
+            // are followed only by powers which depend on them (and which are thus
+            // bound to fail as well): remove them all, so that the exponents
+            // keep on matching the indices.
+            if (i < proms.size()) {
+                ::std::lock_guard lock(entry->mutex);
+
+                if (entry->n_truncations == n_trunc) {
+                    auto &v = entry->powers;
+                    assert(v.size() >= first_idx + proms.size());
+
+                    v.erase(v.begin() + static_cast<decltype(v.begin() - v.begin())>(first_idx + i), v.end());
+                    ++entry->n_truncations;
+                }
+            }
+
+            // Propagate the exception to the threads
+            // waiting on the failed powers.
+            const auto eptr = ::std::current_exception();
+            for (; i < proms.size(); ++i) {
+                if (proms[i]) {
+                    proms[i]->set_exception(eptr);
+                }
+            }
+
+            throw;
+        }
+
+        // Enforce the capacity limit.
+        internal::series_pow_cache_evict(entry.get());
+    } else if (bin_prom) {
+        shard.misses.fetch_add(1, ::std::memory_order_relaxed);
+        internal::series_pow_cache_epoch.fetch_add(1, ::std::memory_order_relaxed);
+
+        const auto &b = ::std::any_cast<const Base &>(entry->base);
+
+        try {
+            // Compute base**(n - bin_start) via right-to-left square-and-multiply,
+            // and multiply it by base**bin_start.
+            // NOTE: see above for the isolation.
+            ::tbb::this_task_arena::isolate([&]() {
+                // NOTE: base**bin_start might still be
+                // in the process of being computed by another thread.
+                const auto &start = ::std::any_cast<const Base &>(prev_fut.get());
+
+                ::std::optional<Base> ret, sq;
+                auto m = n - bin_start;
+                assert(m > 0u);
+                while (true) {
+                    const auto &cur = sq ? *sq : b;
+                    if (m & 1u) {
+                        if (ret) {
+                            *ret = *ret * cur;
+                        } else {
+                            ret.emplace(bin_start == 0u ? cur : start * cur);
+                        }
+                    }
+
+                    m >>= 1;
+                    if (m == 0u) {
+                        break;
+                    }
+
+                    sq.emplace(cur * cur);
+                }
+
+                bin_prom->set_value(::std::move(*ret));
+            });
+        } catch (...) {
+            // Remove the failed power from the cache,
+            // so that it will be recomputed by later requests.
+            {
+                ::std::lock_guard lock(entry->mutex);
+
+                entry->sparse_powers.erase(n);
+            }
+
+            // Propagate the exception to the threads
+            // waiting on the failed power.
+            // NOTE: set_value() is the last operation in the try
+            // block, thus the promise is still unsatisfied here.
+            bin_prom->set_exception(::std::current_exception());
+
+            throw;
+        }
+
+        account_bytes(::std::any_cast<const Base &>(ret_fut.get()));
+
+        // Enforce the capacity limit.
+        internal::series_pow_cache_evict(entry.get());
+    } else {
+        shard.hits.fetch_add(1, ::std::memory_order_relaxed);
     }
 
     // Return a copy of the desired power.
     // NOTE: returnability is guaranteed because
     // the return type is a series.
-    return ::std::any_cast<const Base &>(v[static_cast<decltype(v.size())>(n)]);
+    return ::std::any_cast<const Base &>(ret_fut.get());
 }
 
 // Metaprogramming to establish the algorithm/return
@@ -1863,6 +2472,33 @@ inline series_default_pow_ret_t<T &&, U &&> pow(pow_t, T &&b, U &&e_)
 
 } // namespace customisation::internal
 
+// Fetch the statistics of the series pow cache.
+// NOTE: the hits/misses/evictions counters
+// are not reset when the cache is cleared.
+inline constexpr auto get_pow_cache_stats = []() { return customisation::internal::get_series_pow_cache_stats(); };
+
+// Get/set the capacity limit (in bytes) of the series
+// pow cache. Lowering the limit will immediately evict the
+// least recently used bases in excess. By default, the
+// capacity is unlimited.
+inline constexpr auto get_pow_cache_max_bytes
+    = []() { return customisation::internal::series_pow_cache_max_bytes.load(::std::memory_order_relaxed); };
+inline constexpr auto set_pow_cache_max_bytes = [](::std::size_t n) {
+    customisation::internal::series_pow_cache_max_bytes.store(n, ::std::memory_order_relaxed);
+    customisation::internal::series_pow_cache_evict(nullptr);
+};
+
+// Get/set the algorithm used to compute the powers
+// missing from the series pow cache. The default
+// is pow_algo::linear.
+inline constexpr auto get_pow_algo
+    = []() { return customisation::internal::series_pow_algo_setting.load(::std::memory_order_relaxed); };
+inline constexpr auto set_pow_algo
+    = [](pow_algo a) { customisation::internal::series_pow_algo_setting.store(a, ::std::memory_order_relaxed); };
+
+// Clear the series pow cache.
+inline constexpr auto clear_pow_cache = []() { customisation::internal::clear_series_pow_map(); };
+
 // Identity operator for series.
 template <CvrSeries T>
 inline remove_cvref_t<T> operator+(T &&x)
@@ -2516,8 +3152,8 @@ inline series_default_addsub_ret_t<Sign, T &&, U &&> series_default_addsub_impl(
             return merge_with_identical_ss(::std::forward<T>(x), ::std::forward<U>(y));
         } else {
             // Merge the symbol sets.
-            const auto &[merged_ss, ins_map_x, ins_map_y]
-                = detail::merge_symbol_sets(x.get_symbol_set(), y.get_symbol_set());
+            const auto ms_res = detail::merge_symbol_sets_fw(x.get_symbol_set_fw(), y.get_symbol_set_fw());
+            const auto &[merged_ss, ins_map_x, ins_map_y] = *ms_res;
 
             // The insertion maps cannot be both empty, as we already handled
             // the identical symbol sets case above.
@@ -2536,7 +3172,7 @@ inline series_default_addsub_ret_t<Sign, T &&, U &&> series_default_addsub_impl(
                     // x already has the correct symbol
                     // set, extend only y.
                     ret_t b;
-                    b.set_symbol_set(merged_ss);
+                    b.set_symbol_set_fw(merged_ss);
                     detail::series_sym_extender(b, ::std::forward<U>(y), ins_map_y);
 
                     return merge_with_identical_ss(::std::forward<T>(x), ::std::move(b));
@@ -2545,7 +3181,7 @@ inline series_default_addsub_ret_t<Sign, T &&, U &&> series_default_addsub_impl(
                     // y already has the correct symbol
                     // set, extend only x.
                     ret_t a;
-                    a.set_symbol_set(merged_ss);
+                    a.set_symbol_set_fw(merged_ss);
                     detail::series_sym_extender(a, ::std::forward<T>(x), ins_map_x);
 
                     return merge_with_identical_ss(::std::move(a), ::std::forward<U>(y));
@@ -2554,8 +3190,8 @@ inline series_default_addsub_ret_t<Sign, T &&, U &&> series_default_addsub_impl(
 
             // Both x and y need to be extended.
             ret_t a, b;
-            a.set_symbol_set(merged_ss);
-            b.set_symbol_set(merged_ss);
+            a.set_symbol_set_fw(merged_ss);
+            b.set_symbol_set_fw(merged_ss);
             detail::series_sym_extender(a, ::std::forward<T>(x), ins_map_x);
             detail::series_sym_extender(b, ::std::forward<U>(y), ins_map_y);
 
@@ -2754,23 +3390,100 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
             // Distinguish the two cases in which the lhs table
             // is segmented or not.
             if (lhs._get_s_table().size() > 1u) {
-                for (auto &t : rhs) {
-                    // NOTE: old clang does not like structured
-                    // bindings in the for loop.
-                    auto &k = t.first;
-                    auto &c = t.second;
-
+                auto &l_table = lhs._get_s_table();
+                auto &r_table = rhs._get_s_table();
+
+                using s_size_t = remove_cvref_t<decltype(l_table.size())>;
+                const auto nl = l_table.size();
+                const auto nr = static_cast<s_size_t>(r_table.size());
+
+                // Helper to insert the term t of rhs into the table tab of lhs.
+                auto add_to_table = [&lhs](auto &tab, auto &t) {
+                    // NOTE: turn on the zero check, as we might end up
+                    // annihilating terms during insertion.
+                    // Compatibility check is not needed.
                     if constexpr (is_mutable_rvalue_reference_v<rhs_t &&>) {
-                        // NOTE: turn on the zero check, as we might end up
-                        // annihilating terms during insertion.
-                        // Compatibility check is not needed.
-                        detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
-                                                sat_check_table_size::on, sat_assume_unique::off>(lhs, k,
-                                                                                                  ::std::move(c));
+                        detail::series_add_term_table<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                                                      sat_check_table_size::on, sat_assume_unique::off>(
+                            lhs, tab, t.first, ::std::move(t.second));
+                    } else {
+                        detail::series_add_term_table<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                                                      sat_check_table_size::on, sat_assume_unique::off>(
+                            lhs, tab, t.first, ::std::as_const(t.second));
+                    }
+                };
+
+                // NOTE: the segment of a term is given by the lowest bits of
+                // the hash of its key. Thus, if rhs has at least as many segments
+                // as lhs, all the terms in the table i of rhs end up in the table
+                // i % nl of lhs. Each table of lhs can then be
+                // built independently of the others.
+                const auto par = rhs.size() >= series_par_threshold;
+
+                if (nr >= nl) {
+                    auto merge_tables = [&](const auto &range) {
+                        for (auto j = range.begin(); j != range.end(); ++j) {
+                            for (auto i = j; i < nr; i += nl) {
+                                for (auto &t : r_table[i]) {
+                                    add_to_table(l_table[j], t);
+                                }
+                            }
+                        }
+                    };
+
+                    if (par) {
+                        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nl), merge_tables);
                     } else {
-                        detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
-                                                sat_check_table_size::on, sat_assume_unique::off>(lhs, k,
-                                                                                                  ::std::as_const(c));
+                        merge_tables(::tbb::blocked_range<s_size_t>(0, nl));
+                    }
+                } else if (par) {
+                    // rhs has fewer segments than lhs: the terms in the table i
+                    // of rhs are scattered among the tables j of lhs such that
+                    // j % nr == i. Bucket first the terms of rhs by destination
+                    // table, so that each key is hashed only once and each table of
+                    // lhs then visits only the terms which belong to it.
+                    // NOTE: the buckets of the tables j with j % nr == i
+                    // are written only while processing the table i of rhs,
+                    // thus the first pass can run in parallel without races.
+                    using r_term_t = ::std::remove_reference_t<decltype(*r_table[0].begin())>;
+                    ::std::vector<::std::vector<r_term_t *>> buckets;
+                    buckets.resize(::obake::safe_cast<decltype(buckets.size())>(nl));
+
+                    ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nr), [&](const auto &range) {
+                        for (auto i = range.begin(); i != range.end(); ++i) {
+                            for (auto &t : r_table[i]) {
+                                buckets[static_cast<decltype(buckets.size())>(::obake::hash(t.first) & (nl - 1u))]
+                                    .push_back(&t);
+                            }
+                        }
+                    });
+
+                    // Merge into the tables of lhs.
+                    // NOTE: within each bucket, the terms are in the
+                    // same order as in the table of rhs.
+                    ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nl), [&](const auto &range) {
+                        for (auto j = range.begin(); j != range.end(); ++j) {
+                            for (auto *ptr : buckets[static_cast<decltype(buckets.size())>(j)]) {
+                                add_to_table(l_table[j], *ptr);
+                            }
+                        }
+                    });
+                } else {
+                    for (auto &t : rhs) {
+                        // NOTE: old clang does not like structured
+                        // bindings in the for loop.
+                        auto &k = t.first;
+                        auto &c = t.second;
+
+                        if constexpr (is_mutable_rvalue_reference_v<rhs_t &&>) {
+                            detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                                                    sat_check_table_size::on, sat_assume_unique::off>(lhs, k,
+                                                                                                      ::std::move(c));
+                        } else {
+                            detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                                                    sat_check_table_size::on, sat_assume_unique::off>(
+                                lhs, k, ::std::as_const(c));
+                        }
                     }
                 }
             } else {
@@ -2823,8 +3536,8 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
             }
         } else {
             // Merge the symbol sets.
-            const auto &[merged_ss, ins_map_x, ins_map_y]
-                = detail::merge_symbol_sets(x.get_symbol_set(), y.get_symbol_set());
+            const auto ms_res = detail::merge_symbol_sets_fw(x.get_symbol_set_fw(), y.get_symbol_set_fw());
+            const auto &[merged_ss, ins_map_x, ins_map_y] = *ms_res;
 
             // The insertion maps cannot be both empty, as we already handled
             // the identical symbol sets case above.
@@ -2843,8 +3556,8 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
                     // Both x and y need to be extended.
                     rT a;
                     rU b;
-                    a.set_symbol_set(merged_ss);
-                    b.set_symbol_set(merged_ss);
+                    a.set_symbol_set_fw(merged_ss);
+                    b.set_symbol_set_fw(merged_ss);
                     detail::series_sym_extender(a, ::std::forward<T>(x), ins_map_x);
                     detail::series_sym_extender(b, ::std::forward<U>(y), ins_map_y);
                     x = ::std::move(a);
@@ -2856,7 +3569,7 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
                     // x already has the correct symbol
                     // set, extend only y.
                     rU b;
-                    b.set_symbol_set(merged_ss);
+                    b.set_symbol_set_fw(merged_ss);
                     detail::series_sym_extender(b, ::std::forward<U>(y), ins_map_y);
 
                     in_place_with_identical_ss(x, ::std::move(b));
@@ -2866,7 +3579,7 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
                     // y already has the correct symbol
                     // set, extend only x.
                     rT a;
-                    a.set_symbol_set(merged_ss);
+                    a.set_symbol_set_fw(merged_ss);
                     detail::series_sym_extender(a, ::std::forward<T>(x), ins_map_x);
                     x = ::std::move(a);
 
@@ -3045,6 +3758,70 @@ template <typename T, typename U>
 constexpr auto series_mul_impl(T &&x, U &&y, priority_tag<1>)
     OBAKE_SS_FORWARD_FUNCTION(series_mul(::std::forward<T>(x), ::std::forward<U>(y)));
 
+// Detect the overrides of series_mul(), either in the
+// external customisation namespace or via ADL.
+template <typename T, typename U>
+using series_mul_custom_t = decltype((customisation::series_mul<T, U>)(::std::declval<T>(), ::std::declval<U>()));
+
+template <typename T, typename U>
+using series_mul_adl_t = decltype(series_mul(::std::declval<T>(), ::std::declval<U>()));
+
+// Apply the in-place operation f to all the coefficients of the
+// series s, erasing the terms whose coefficients become zero.
+// If Par is true, the tables of a segmented series with at least
+// series_par_threshold terms are processed in parallel.
+template <bool Par, typename S, typename F>
+inline void series_cf_in_place_op(S &s, const F &f)
+{
+    auto &s_table = s._get_s_table();
+
+    auto op_table = [&f](auto &t) {
+        const auto end = t.end();
+        for (auto it = t.begin(); it != end;) {
+            auto &c = it->second;
+
+            f(c);
+
+            if (obake_unlikely(::obake::is_zero(::std::as_const(c)))) {
+                // NOTE: abseil's flat_hash_map returns void on erase(),
+                // thus we need to increase 'it' before possibly erasing.
+                // erase() does not cause rehash and thus will not invalidate
+                // any other iterator apart from the one being erased.
+                t.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    };
+
+    try {
+        if (Par && s_table.size() > 1u && s.size() >= series_par_threshold) {
+            // NOTE: the tables are independent of each other,
+            // and the zero pruning is done table by table.
+            using s_size_t = remove_cvref_t<decltype(s_table.size())>;
+
+            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, s_table.size()), [&](const auto &range) {
+                for (auto i = range.begin(); i != range.end(); ++i) {
+                    op_table(s_table[i]);
+                }
+            });
+        } else {
+            for (auto &t : s_table) {
+                op_table(t);
+            }
+        }
+        // LCOV_EXCL_START
+    } catch (...) {
+        // If something goes wrong, make sure to clear
+        // out s before rethrowing, in order to avoid
+        // a possibly inconsistent state and thus assertion
+        // failures in debug mode.
+        s.clear_terms();
+        throw;
+    }
+    // LCOV_EXCL_STOP
+}
+
 // Meta-programming to establish the algorithm and return type
 // of the default implementation of series mul. It will return
 // a pair containing an integral value (1 or 2) signalling the algorithm
@@ -3160,46 +3937,15 @@ inline series_default_mul_ret_t<T &&, U &&> series_default_mul_impl(T &&x, U &&y
         // Init the return value from the higher-rank series.
         ret_t retval(::std::forward<decltype(a)>(a));
 
-        // Multiply in-place all coefficients of retval by b.
-        // Store in a vector the keys of the terms
-        // whose coefficients become zero after
-        // the multiplication, so that we can remove them.
-        // NOTE: this can be parallelised for a segmented table.
-        auto &s_table = retval._get_s_table();
-        ::std::vector<series_key_t<ret_t>> v_keys;
-        try {
-            for (auto &t : s_table) {
-                // Reset the vector of keys to be removed.
-                v_keys.clear();
-
-                // Perform the multiplications for this table.
-                for (auto &[k, c] : t) {
-                    c *= ::std::as_const(b);
-                    // Check if the coefficient became zero
-                    // after the multiplication.
-                    if (obake_unlikely(::obake::is_zero(::std::as_const(c)))) {
-                        v_keys.push_back(k);
-                    }
-                }
-
-                // Erase any term whose coefficient became zero.
-                for (const auto &k : v_keys) {
-                    assert(t.find(k) != t.end());
-                    t.erase(k);
-                }
-            }
+        // Multiply in-place all coefficients of retval by b,
+        // removing the terms whose coefficients become zero.
+        // NOTE: the coefficients are processed in parallel only
+        // if b is not a series, so that the worker threads never
+        // end up running series multiplications.
+        detail::series_cf_in_place_op<series_rank<rb_t> == 0u>(retval,
+                                                               [&b](auto &c) { c *= ::std::as_const(b); });
 
-            return retval;
-            // LCOV_EXCL_START
-        } catch (...) {
-            // If something goes wrong, make sure to clear
-            // out retval before rethrowing, in order to avoid
-            // a possibly inconsistent state and thus assertion
-            // failures in debug mode.
-            retval.clear();
-            throw;
-        }
-        // LCOV_EXCL_STOP
+        return retval;
     };
 
     if constexpr (algo == 2) {
@@ -3209,6 +3955,51 @@ inline series_default_mul_ret_t<T &&, U &&> series_default_mul_impl(T &&x, U &&y
     }
 }
 
+// Establish if x *= y can be implemented by multiplying in-place
+// the coefficients of x by y. This requires that:
+// - x is a mutable series with a rank higher than y,
+// - series_mul() is not overridden for x and y,
+// - the default implementation of x * y returns the type of x.
+template <typename T, typename U>
+constexpr bool series_default_in_place_mul_algorithm_impl()
+{
+    if constexpr (::std::disjunction_v<::std::is_const<::std::remove_reference_t<T>>,
+                                       is_detected<series_mul_custom_t, T, U>, is_detected<series_mul_adl_t, T, U>,
+                                       ::std::negation<::std::is_constructible<remove_cvref_t<U>, U>>>) {
+        return false;
+    } else if constexpr (series_default_mul_algo<T, U> == 2) {
+        return ::std::is_same_v<series_default_mul_ret_t<T, U>, remove_cvref_t<T>>;
+    } else {
+        return false;
+    }
+}
+
+template <typename T, typename U>
+inline constexpr bool series_default_in_place_mul_algo = detail::series_default_in_place_mul_algorithm_impl<T, U>();
+
+// In-place multiplication of the series x by y.
+template <typename S, typename U>
+inline S &series_default_in_place_mul_impl(S &x, U &&y)
+{
+    using rU = remove_cvref_t<U>;
+
+    if (::obake::is_zero(::std::as_const(y))) {
+        // Like in the binary operator, the result is an empty
+        // series with the symbol set and tag of x.
+        x.clear_terms();
+
+        return x;
+    }
+
+    // NOTE: y might be a coefficient of x (or contained in it),
+    // make a copy before modifying the coefficients.
+    const rU y_copy(::std::forward<U>(y));
+
+    detail::series_cf_in_place_op<series_rank<rU> == 0u>(x, [&y_copy](auto &c) { c *= y_copy; });
+
+    return x;
+}
+
 // Lowest priority: the default implementation for series.
 template <typename T, typename U, ::std::enable_if_t<series_default_mul_algo<T &&, U &&> != 0, int> = 0>
 constexpr auto series_mul_impl(T &&x, U &&y, priority_tag<0>)
@@ -3226,14 +4017,31 @@ template <typename T, typename U>
 constexpr auto operator*(T &&x, U &&y)
     OBAKE_SS_FORWARD_FUNCTION(::obake::series_mul(::std::forward<T>(x), ::std::forward<U>(y)));
 
-// NOTE: for now, implement operator*=() in terms of operator*().
-// This can be optimised later performance-wise.
-// NOTE: if this gets optimised for performance, we will probably
-// need to add specialisations for, e.g., power_series.
+// NOTE: in general, implement operator*=() in terms of operator*().
 template <typename T, typename U>
     requires CvrSeries<T>
 constexpr auto operator*=(T &&x, U &&y) OBAKE_SS_FORWARD_FUNCTION(x = ::std::forward<T>(x) * ::std::forward<U>(y));
 
+// Multiplication by an object of lower rank: multiply
+// in-place the coefficients of x, re-using its tables.
+// NOTE: unlike x = x * y, this overload offers only the basic
+// exception safety guarantee: if the multiplication of a coefficient
+// throws, x is left empty (its terms are cleared, the symbol set
+// and the tag are preserved).
+// NOTE: this overload is disabled for the (T, U) pairs for which
+// series_mul() is customised. E.g., for power series only the
+// product of two power series of the same rank is customised
+// (in order to apply the truncation), thus p_series *= scalar
+// uses this overload, while p_series *= p_series does not.
+// Multiplying by an object of lower rank does not alter the keys
+// or the tag, so that no truncation is needed in the in-place path.
+template <typename T, typename U>
+    requires CvrSeries<T> && detail::series_default_in_place_mul_algo<T &&, U &&>
+inline remove_cvref_t<T> &operator*=(T &&x, U &&y)
+{
+    return detail::series_default_in_place_mul_impl(x, ::std::forward<U>(y));
+}
+
 template <typename T, typename U>
     requires(!CvrSeries<T>) && CvrSeries<U>
 constexpr auto operator*=(T &&x, U &&y)
@@ -3261,6 +4069,14 @@ template <typename T, typename U>
 constexpr auto series_div_impl(T &&x, U &&y, priority_tag<1>)
     OBAKE_SS_FORWARD_FUNCTION(series_div(::std::forward<T>(x), ::std::forward<U>(y)));
 
+// Detect the overrides of series_div(), either in the
+// external customisation namespace or via ADL.
+template <typename T, typename U>
+using series_div_custom_t = decltype((customisation::series_div<T, U>)(::std::declval<T>(), ::std::declval<U>()));
+
+template <typename T, typename U>
+using series_div_adl_t = decltype(series_div(::std::declval<T>(), ::std::declval<U>()));
+
 // Meta-programming to establish the algorithm and return type
 // of the default implementation of series div. It will return
 // a pair containing an integral value signalling the algorithm
@@ -3333,41 +4149,50 @@ inline series_default_div_ret_t<T &&, U &&> series_default_div_impl(T &&x, U &&y
     // Init the return value from the higher-rank series.
     ret_t retval(::std::forward<T>(x));
 
-    // Divide in-place all coefficients of retval by y.
-    // NOTE: this can be parallelised for a segmented table.
-    auto &s_table = retval._get_s_table();
-    try {
-        for (auto &t : s_table) {
-            // Perform the divisions for this table.
-            const auto end = t.end();
-            for (auto it = t.begin(); it != end;) {
-                auto &c = it->second;
-
-                c /= ::std::as_const(y);
-
-                if (obake_unlikely(::obake::is_zero(::std::as_const(c)))) {
-                    // NOTE: abseil's flat_hash_map returns void on erase(),
-                    // thus we need to increase 'it' before possibly erasing.
-                    // erase() does not cause rehash and thus will not invalidate
-                    // any other iterator apart from the one being erased.
-                    t.erase(it++);
-                } else {
-                    ++it;
-                }
-            }
-        }
+    // Divide in-place all coefficients of retval by y,
+    // removing the terms whose coefficients become zero.
+    // NOTE: see the comments in the mul implementation.
+    detail::series_cf_in_place_op<series_rank<remove_cvref_t<U>> == 0u>(retval,
+                                                                         [&y](auto &c) { c /= ::std::as_const(y); });
 
-        return retval;
-    } catch (...) {
-        // If something goes wrong, make sure to clear
-        // out retval before rethrowing, in order to avoid
-        // a possibly inconsistent state and thus assertion
-        // failures in debug mode.
-        retval.clear();
-        throw;
+    return retval;
+}
+
+// Establish if x /= y can be implemented by dividing in-place
+// the coefficients of x by y. The requirements are the same
+// as in the in-place multiplication.
+template <typename T, typename U>
+constexpr bool series_default_in_place_div_algorithm_impl()
+{
+    if constexpr (::std::disjunction_v<::std::is_const<::std::remove_reference_t<T>>,
+                                       is_detected<series_div_custom_t, T, U>, is_detected<series_div_adl_t, T, U>,
+                                       ::std::negation<::std::is_constructible<remove_cvref_t<U>, U>>>) {
+        return false;
+    } else if constexpr (series_default_div_algo<T, U> == 1) {
+        return ::std::is_same_v<series_default_div_ret_t<T, U>, remove_cvref_t<T>>;
+    } else {
+        return false;
     }
 }
 
+template <typename T, typename U>
+inline constexpr bool series_default_in_place_div_algo = detail::series_default_in_place_div_algorithm_impl<T, U>();
+
+// In-place division of the series x by y.
+template <typename S, typename U>
+inline S &series_default_in_place_div_impl(S &x, U &&y)
+{
+    using rU = remove_cvref_t<U>;
+
+    // NOTE: y might be a coefficient of x (or contained in it),
+    // make a copy before modifying the coefficients.
+    const rU y_copy(::std::forward<U>(y));
+
+    detail::series_cf_in_place_op<series_rank<rU> == 0u>(x, [&y_copy](auto &c) { c /= y_copy; });
+
+    return x;
+}
+
 // Lowest priority: the default implementation for series.
 template <typename T, typename U, ::std::enable_if_t<series_default_div_algo<T &&, U &&> != 0, int> = 0>
 constexpr auto series_div_impl(T &&x, U &&y, priority_tag<0>)
@@ -3385,12 +4210,23 @@ template <typename T, typename U>
 constexpr auto operator/(T &&x, U &&y)
     OBAKE_SS_FORWARD_FUNCTION(::obake::series_div(::std::forward<T>(x), ::std::forward<U>(y)));
 
-// NOTE: for now, implement operator/=() in terms of operator/().
-// This can be optimised later performance-wise.
+// NOTE: in general, implement operator/=() in terms of operator/().
 template <typename T, typename U>
     requires CvrSeries<T>
 constexpr auto operator/=(T &&x, U &&y) OBAKE_SS_FORWARD_FUNCTION(x = ::std::forward<T>(x) / ::std::forward<U>(y));
 
+// Division by an object of lower rank: divide
+// in-place the coefficients of x, re-using its tables.
+// NOTE: the exception safety guarantee is the same as in the
+// in-place multiplication. This overload is disabled for the
+// (T, U) pairs for which series_div() is customised.
+template <typename T, typename U>
+    requires CvrSeries<T> && detail::series_default_in_place_div_algo<T &&, U &&>
+inline remove_cvref_t<T> &operator/=(T &&x, U &&y)
+{
+    return detail::series_default_in_place_div_impl(x, ::std::forward<U>(y));
+}
+
 template <typename T, typename U>
     requires(!CvrSeries<T>) && CvrSeries<U>
 constexpr auto operator/=(T &&x, U &&y)
@@ -3489,8 +4325,8 @@ constexpr bool series_equal_to_impl(T &&x, U &&y, priority_tag<0>)
             return customisation::internal::series_cmp_identical_ss(x, y);
         } else {
             // Merge the symbol sets.
-            const auto &[merged_ss, ins_map_x, ins_map_y]
-                = detail::merge_symbol_sets(x.get_symbol_set(), y.get_symbol_set());
+            const auto ms_res = detail::merge_symbol_sets_fw(x.get_symbol_set_fw(), y.get_symbol_set_fw());
+            const auto &[merged_ss, ins_map_x, ins_map_y] = *ms_res;
 
             // The insertion maps cannot be both empty, as we already handled
             // the identical symbol sets case above.
@@ -3509,7 +4345,7 @@ constexpr bool series_equal_to_impl(T &&x, U &&y, priority_tag<0>)
                     // x already has the correct symbol
                     // set, extend only y.
                     rU b;
-                    b.set_symbol_set(merged_ss);
+                    b.set_symbol_set_fw(merged_ss);
                     b.tag() = y.tag();
                     detail::series_sym_extender(b, ::std::forward<U>(y), ins_map_y);
 
@@ -3519,7 +4355,7 @@ constexpr bool series_equal_to_impl(T &&x, U &&y, priority_tag<0>)
                     // y already has the correct symbol
                     // set, extend only x.
                     rT a;
-                    a.set_symbol_set(merged_ss);
+                    a.set_symbol_set_fw(merged_ss);
                     a.tag() = x.tag();
                     detail::series_sym_extender(a, ::std::forward<T>(x), ins_map_x);
 
@@ -3530,9 +4366,9 @@ constexpr bool series_equal_to_impl(T &&x, U &&y, priority_tag<0>)
             // Both x and y need to be extended.
             rT a;
             rU b;
-            a.set_symbol_set(merged_ss);
+            a.set_symbol_set_fw(merged_ss);
             a.tag() = x.tag();
-            b.set_symbol_set(merged_ss);
+            b.set_symbol_set_fw(merged_ss);
             b.tag() = y.tag();
             detail::series_sym_extender(a, ::std::forward<T>(x), ins_map_x);
             detail::series_sym_extender(b, ::std::forward<U>(y), ins_map_y);
@@ -3981,6 +4817,38 @@ inline auto make_p_degree_vector(It begin, It end, const symbol_set &ss, const s
 namespace customisation::internal
 {
 
+// Flag to enable compensated summation in the
+// evaluation of series with floating-point values.
+OBAKE_DLL_PUBLIC extern ::std::atomic<bool> series_evaluate_compensated;
+
+// Compensated accumulator, implementing the
+// Kahan-Babuska-Neumaier summation algorithm.
+template <typename T>
+struct neumaier_acc {
+    void add(const T &x)
+    {
+        const auto t = m_sum + x;
+        if (::std::abs(m_sum) >= ::std::abs(x)) {
+            m_comp += (m_sum - t) + x;
+        } else {
+            m_comp += (x - t) + m_sum;
+        }
+        m_sum = t;
+    }
+    void merge(const neumaier_acc &other)
+    {
+        add(other.m_sum);
+        m_comp += other.m_comp;
+    }
+    T result() const
+    {
+        return m_sum + m_comp;
+    }
+
+    T m_sum = 0;
+    T m_comp = 0;
+};
+
 // Metaprogramming to establish the algorithm/return
 // type of the default series evaluate computation.
 template <typename T, typename U>
@@ -4076,20 +4944,69 @@ struct series_default_evaluate_impl {
         // Thus, si must contain the [0, ss.size()) sequence.
         assert(si.empty() || (si.cend() - 1)->first == (ss.size() - 1u));
 
-        // NOTE: parallelisation opportunities here.
-        ret_t<T &&, U> retval(0);
-        for (const auto &tab : s._get_s_table()) {
-            for (const auto &t : tab) {
-                const auto &k = t.first;
-                const auto &c = t.second;
+        using r_t = ret_t<T &&, U>;
+
+        const auto &s_table = s._get_s_table();
+        using s_size_t = remove_cvref_t<decltype(s_table.size())>;
+
+        // Evaluate a single term.
+        // NOTE: there's an opportunity for fma3 here,
+        // but I am not sure it's worth the hassle.
+        auto term_eval = [&si, &ss, &sm](const auto &t) {
+            return ::obake::key_evaluate(t.first, si, ss) * ::obake::evaluate(t.second, sm);
+        };
 
-                // NOTE: there's an opportunity for fma3 here,
-                // but I am not sure it's worth the hassle.
-                retval += ::obake::key_evaluate(k, si, ss) * ::obake::evaluate(c, sm);
+        // Segmented series with at least series_par_threshold terms
+        // are evaluated in parallel, one range of tables at a time.
+        // NOTE: use the deterministic version of parallel_reduce(),
+        // so that the result does not depend on the scheduling.
+        const auto par = s_table.size() > 1u && s.size() >= ::obake::detail::series_par_threshold;
+
+        if constexpr (::std::is_floating_point_v<r_t>) {
+            if (series_evaluate_compensated.load(::std::memory_order_relaxed)) {
+                auto acc_tables = [&s_table, &term_eval](const auto &range, neumaier_acc<r_t> acc) {
+                    for (auto i = range.begin(); i != range.end(); ++i) {
+                        for (const auto &t : s_table[i]) {
+                            acc.add(term_eval(t));
+                        }
+                    }
+                    return acc;
+                };
+
+                const ::tbb::blocked_range<s_size_t> range(0, s_table.size(), 1);
+
+                if (par) {
+                    return ::tbb::parallel_deterministic_reduce(range, neumaier_acc<r_t>{}, acc_tables,
+                                                                [](neumaier_acc<r_t> a, const neumaier_acc<r_t> &b) {
+                                                                    a.merge(b);
+                                                                    return a;
+                                                                })
+                        .result();
+                } else {
+                    return acc_tables(range, neumaier_acc<r_t>{}).result();
+                }
             }
         }
 
-        return retval;
+        auto acc_tables = [&s_table, &term_eval](const auto &range, r_t acc) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                for (const auto &t : s_table[i]) {
+                    acc += term_eval(t);
+                }
+            }
+            return acc;
+        };
+
+        const ::tbb::blocked_range<s_size_t> range(0, s_table.size(), 1);
+
+        if (par) {
+            return ::tbb::parallel_deterministic_reduce(range, r_t(0), acc_tables, [](r_t a, r_t b) {
+                a += ::std::move(b);
+                return a;
+            });
+        } else {
+            return acc_tables(range, r_t(0));
+        }
     }
 };
 
@@ -4099,6 +5016,14 @@ inline constexpr auto evaluate<T, U> = series_default_evaluate_impl{};
 
 } // namespace customisation::internal
 
+// Get/set the flag for the compensated summation in the
+// evaluation of series whose evaluation type is a
+// floating-point type. The default is false.
+inline constexpr auto get_evaluate_compensated
+    = []() { return customisation::internal::series_evaluate_compensated.load(::std::memory_order_relaxed); };
+inline constexpr auto set_evaluate_compensated
+    = [](bool f) { customisation::internal::series_evaluate_compensated.store(f, ::std::memory_order_relaxed); };
+
 namespace customisation::internal
 {
 
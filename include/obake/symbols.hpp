@@ -10,8 +10,10 @@
 #define OBAKE_SYMBOLS_HPP
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -19,15 +21,10 @@
 #include <boost/container/container_fwd.hpp>
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
-#include <boost/flyweight/flyweight.hpp>
-#include <boost/flyweight/hashed_factory.hpp>
-#include <boost/flyweight/refcounted.hpp>
-#include <boost/flyweight/simple_locking.hpp>
 #include <boost/serialization/split_free.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/tracking.hpp>
 
-#include <obake/detail/fw_utils.hpp>
 #include <obake/detail/visibility.hpp>
 #include <obake/math/safe_cast.hpp>
 
@@ -204,8 +201,121 @@ struct OBAKE_DLL_PUBLIC ss_fw_hasher {
     ::std::size_t operator()(const symbol_set &) const;
 };
 
-// Definition of the symbol_set flyweight.
-using ss_fw = ::boost::flyweight<symbol_set, ::boost::flyweights::hashed_factory<ss_fw_hasher>, fw_holder>;
+// Node of the symbol_set interning table: an immutable
+// symbol set, its hash and a reference counter.
+struct ss_fw_node {
+    ss_fw_node(symbol_set s, ::std::size_t h) : value(::std::move(s)), hash(h) {}
+
+    const symbol_set value;
+    const ::std::size_t hash;
+    ::std::atomic<::std::size_t> n_refs{1};
+};
+
+// Functions to fetch (with an additional reference) the node
+// corresponding to a symbol set, creating it if needed, and
+// to destroy a node whose reference count dropped to zero.
+OBAKE_DLL_PUBLIC ss_fw_node *ss_fw_intern(const symbol_set &);
+OBAKE_DLL_PUBLIC ss_fw_node *ss_fw_intern(symbol_set &&);
+OBAKE_DLL_PUBLIC ss_fw_node *ss_fw_intern_empty();
+OBAKE_DLL_PUBLIC void ss_fw_destroy(ss_fw_node *) noexcept;
+
+// Flyweight for symbol_set.
+//
+// Each distinct symbol set is stored only once, in a global interning
+// table, so that two flyweights can be compared via their addresses.
+// The table is sharded, and each shard has its own lock. Recently-used
+// symbol sets are looked up first in a small per-thread cache, which
+// requires no locking. The symbol sets are reference counted, and they
+// are removed from the table when they are not in use any more.
+class ss_fw
+{
+public:
+    ss_fw() : m_node(detail::ss_fw_intern_empty()) {}
+    ss_fw(const symbol_set &s) : m_node(detail::ss_fw_intern(s)) {}
+    ss_fw(symbol_set &&s) : m_node(detail::ss_fw_intern(::std::move(s))) {}
+    ss_fw(const ss_fw &other) noexcept : m_node(other.m_node)
+    {
+        m_node->n_refs.fetch_add(1, ::std::memory_order_relaxed);
+    }
+    // NOTE: the move constructor copies, so that
+    // a moved-from flyweight is still valid.
+    ss_fw(ss_fw &&other) noexcept : ss_fw(static_cast<const ss_fw &>(other)) {}
+    ss_fw &operator=(const ss_fw &other) noexcept
+    {
+        if (m_node != other.m_node) {
+            other.m_node->n_refs.fetch_add(1, ::std::memory_order_relaxed);
+            release(m_node);
+            m_node = other.m_node;
+        }
+
+        return *this;
+    }
+    ss_fw &operator=(ss_fw &&other) noexcept
+    {
+        ::std::swap(m_node, other.m_node);
+
+        return *this;
+    }
+    ss_fw &operator=(const symbol_set &s)
+    {
+        return *this = ss_fw(s);
+    }
+    ss_fw &operator=(symbol_set &&s)
+    {
+        return *this = ss_fw(::std::move(s));
+    }
+    ~ss_fw()
+    {
+        release(m_node);
+    }
+
+    const symbol_set &get() const noexcept
+    {
+        return m_node->value;
+    }
+
+    friend bool operator==(const ss_fw &a, const ss_fw &b) noexcept
+    {
+        return a.m_node == b.m_node;
+    }
+    friend bool operator!=(const ss_fw &a, const ss_fw &b) noexcept
+    {
+        return a.m_node != b.m_node;
+    }
+    friend void swap(ss_fw &a, ss_fw &b) noexcept
+    {
+        ::std::swap(a.m_node, b.m_node);
+    }
+
+private:
+    static void release(ss_fw_node *n) noexcept
+    {
+        if (n->n_refs.fetch_sub(1, ::std::memory_order_acq_rel) == 1u) {
+            detail::ss_fw_destroy(n);
+        }
+    }
+
+    ss_fw_node *m_node;
+};
+
+// Cached version of merge_symbol_sets(), operating on flyweights.
+// The results are memoised on the identities of the input symbol
+// sets, and the union is returned as a flyweight.
+using ss_merge_result = ::std::tuple<ss_fw, symbol_idx_map<symbol_set>, symbol_idx_map<symbol_set>>;
+
+OBAKE_DLL_PUBLIC ::std::shared_ptr<const ss_merge_result> merge_symbol_sets_fw(const ss_fw &, const ss_fw &);
+
+// Statistics about the cache of merge_symbol_sets_fw().
+struct ss_merge_cache_stats {
+    // Number of cache hits and misses.
+    unsigned long long n_hits = 0;
+    unsigned long long n_misses = 0;
+    // Number of cached results.
+    ::std::size_t size = 0;
+};
+
+OBAKE_DLL_PUBLIC ss_merge_cache_stats get_ss_merge_cache_stats();
+OBAKE_DLL_PUBLIC void clear_ss_merge_cache();
 
 } // namespace obake::detail
 
@@ -0,0 +1,175 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#if defined(__linux__)
+
+#include <unistd.h>
+
+#elif defined(__APPLE__)
+
+#include <sys/sysctl.h>
+#include <sys/types.h>
+
+#endif
+
+#include <obake/detail/cache_sizes.hpp>
+
+namespace obake::detail
+{
+
+namespace
+{
+
+#if defined(__linux__)
+
+// Read the first line of the file at path p.
+// An empty string is returned in case of errors.
+::std::string read_line(const ::std::string &p)
+{
+    ::std::ifstream f(p);
+    ::std::string retval;
+    if (f) {
+        ::std::getline(f, retval);
+    }
+
+    return retval;
+}
+
+// Parse a cache size as represented in sysfs
+// (e.g., "32K", "8192K", "1M"). Zero is
+// returned in case of errors.
+::std::size_t parse_sysfs_size(const ::std::string &s)
+{
+    ::std::size_t retval = 0;
+    ::std::string::size_type i = 0;
+    for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        retval = retval * 10u + static_cast<::std::size_t>(s[i] - '0');
+    }
+
+    if (i == 0u) {
+        return 0;
+    }
+
+    if (i < s.size()) {
+        switch (s[i]) {
+            case 'K':
+                return retval << 10;
+            case 'M':
+                return retval << 20;
+            case 'G':
+                return retval << 30;
+            default:
+                return 0;
+        }
+    }
+
+    return retval;
+}
+
+cache_sizes detect_cache_sizes()
+{
+    cache_sizes retval;
+
+    // Try first sysfs.
+    const ::std::string base = "/sys/devices/system/cpu/cpu0/cache/index";
+    for (auto i = 0; i < 16; ++i) {
+        const auto dir = base + ::std::to_string(i) + "/";
+
+        const auto level = read_line(dir + "level");
+        if (level.empty()) {
+            // No more cache levels.
+            break;
+        }
+
+        const auto type = read_line(dir + "type");
+        if (type != "Data" && type != "Unified") {
+            // Skip the instruction caches.
+            continue;
+        }
+
+        const auto size = parse_sysfs_size(read_line(dir + "size"));
+        if (level == "1") {
+            retval.l1d = size;
+        } else if (level == "2") {
+            retval.l2 = size;
+        } else if (level == "3") {
+            retval.l3 = size;
+        }
+    }
+
+    // Fill in the missing values via sysconf(), if possible
+    // (in glibc, this queries cpuid on x86).
+    [[maybe_unused]] auto sc_size = [](int name) {
+        const auto ret = ::sysconf(name);
+        return ret > 0 ? static_cast<::std::size_t>(ret) : ::std::size_t(0);
+    };
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    if (retval.l1d == 0u) {
+        retval.l1d = sc_size(_SC_LEVEL1_DCACHE_SIZE);
+    }
+#endif
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+    if (retval.l2 == 0u) {
+        retval.l2 = sc_size(_SC_LEVEL2_CACHE_SIZE);
+    }
+#endif
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    if (retval.l3 == 0u) {
+        retval.l3 = sc_size(_SC_LEVEL3_CACHE_SIZE);
+    }
+#endif
+
+    return retval;
+}
+
+#elif defined(__APPLE__)
+
+cache_sizes detect_cache_sizes()
+{
+    auto sc_size = [](const char *name) {
+        ::std::int64_t ret = 0;
+        auto len = sizeof(ret);
+        if (::sysctlbyname(name, &ret, &len, nullptr, 0) != 0 || ret <= 0) {
+            return ::std::size_t(0);
+        }
+        return static_cast<::std::size_t>(ret);
+    };
+
+    cache_sizes retval;
+    retval.l1d = sc_size("hw.l1dcachesize");
+    retval.l2 = sc_size("hw.l2cachesize");
+    retval.l3 = sc_size("hw.l3cachesize");
+
+    return retval;
+}
+
+#else
+
+cache_sizes detect_cache_sizes()
+{
+    // Detection not supported.
+    return cache_sizes{};
+}
+
+#endif
+
+} // namespace
+
+const cache_sizes &get_cache_sizes()
+{
+    static const cache_sizes retval = detect_cache_sizes();
+
+    return retval;
+}
+
+} // namespace obake::detail
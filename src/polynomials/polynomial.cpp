@@ -0,0 +1,172 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+#include <obake/detail/cache_sizes.hpp>
+#include <obake/detail/to_string.hpp>
+#include <obake/exceptions.hpp>
+#include <obake/polynomials/polynomial.hpp>
+
+namespace obake::polynomials::detail
+{
+
+mul_stats &mul_stats_tls()
+{
+    static thread_local mul_stats stats;
+
+    return stats;
+}
+
+namespace
+{
+
+mul_policy make_default_mul_policy()
+{
+    const auto &cs = ::obake::detail::get_cache_sizes();
+
+    // If the detection failed, assume
+    // 32KB of L1 and 256KB of L2.
+    const auto l1d = cs.l1d == 0u ? ::std::size_t(32) * 1024u : cs.l1d;
+    const auto l2 = cs.l2 == 0u ? ::std::size_t(256) * 1024u : cs.l2;
+
+    mul_policy retval;
+
+    // Select the engine automatically.
+    retval.engine = mul_engine::automatic;
+    // Run the simple implementation if the
+    // operands fit in L1.
+    retval.simple_threshold = l1d - l1d / 16u;
+    // NOTE: the idea here is the following. For highly
+    // sparse products we want to pick a relatively large
+    // segment size so that it fits somewhere in L2
+    // cache. The reason is that we won't do much computation
+    // per segment due to the sparsity, thus we aim at reducing
+    // the parallelisation overhead by operating on larger chunks
+    // of the product series. When the sparsity is smaller, then
+    // we have a higher computational density, thus we will spend
+    // more time computing a single segment, and thus we can aim
+    // at staying in L1 cache instead, as the parallelisation overhead
+    // will be smaller.
+    retval.sparse_seg_size = l2 - l2 / 4u;
+    retval.dense_seg_size = l1d - (l1d * 3u) / 8u;
+    retval.sparsity_threshold = 1E-3;
+    retval.estimator = mul_estimator::sampling;
+    // NOTE: this is roughly the number of monomial
+    // multiplications performed in a fraction of a
+    // second on a single core.
+    retval.sketch_max_mults = ::std::size_t(1) << 26;
+
+    return retval;
+}
+
+// The global policy.
+// NOTE: the policy is not trivially copyable
+// into an atomic, protect it with a mutex.
+::std::mutex global_mul_policy_mutex;
+::std::optional<mul_policy> global_mul_policy;
+
+// The generation of the global policy. It is bumped
+// (while holding the mutex) whenever the global policy
+// changes, so that the readers can detect whether their
+// thread-local copy of the global policy is up to date
+// without locking the mutex.
+::std::atomic<::std::uint64_t> global_mul_policy_gen(1);
+
+} // namespace
+
+mul_policy default_mul_policy()
+{
+    static const mul_policy retval = make_default_mul_policy();
+
+    return retval;
+}
+
+void check_mul_policy(const mul_policy &p)
+{
+    if (obake_unlikely(p.engine < mul_engine::automatic || p.engine > mul_engine::heap)) {
+        obake_throw(::std::invalid_argument, "Invalid engine specified in a polynomial multiplication policy");
+    }
+
+    if (obake_unlikely(p.sparse_seg_size == 0u || p.dense_seg_size == 0u)) {
+        obake_throw(::std::invalid_argument, "The segment sizes in a polynomial multiplication policy must be "
+                                             "nonzero, but the policy contains a sparse segment size of "
+                                                 + ::obake::detail::to_string(p.sparse_seg_size)
+                                                 + " and a dense segment size of "
+                                                 + ::obake::detail::to_string(p.dense_seg_size));
+    }
+
+    if (obake_unlikely(!::std::isfinite(p.sparsity_threshold) || p.sparsity_threshold < 0)) {
+        obake_throw(::std::invalid_argument,
+                    "The sparsity threshold in a polynomial multiplication policy must be finite and non-negative, "
+                    "but a value of "
+                        + ::obake::detail::to_string(p.sparsity_threshold) + " was provided instead");
+    }
+
+    if (obake_unlikely(p.estimator != mul_estimator::sampling && p.estimator != mul_estimator::sketch)) {
+        obake_throw(::std::invalid_argument, "Invalid product size estimator specified in a polynomial "
+                                             "multiplication policy");
+    }
+
+    if (obake_unlikely(p.sketch_max_mults == 0u)) {
+        obake_throw(::std::invalid_argument, "The max number of term-by-term multiplications for the sketch-based "
+                                             "estimator in a polynomial multiplication policy must be nonzero");
+    }
+}
+
+mul_policy get_global_mul_policy()
+{
+    // The thread-local copy of the global
+    // policy, and its generation.
+    static thread_local mul_policy cached;
+    static thread_local ::std::uint64_t cached_gen = 0;
+
+    // NOTE: acquire pairs with the release in set_global_mul_policy().
+    if (obake_likely(cached_gen == global_mul_policy_gen.load(::std::memory_order_acquire))) {
+        return cached;
+    }
+
+    ::std::lock_guard<::std::mutex> lock(global_mul_policy_mutex);
+
+    if (!global_mul_policy) {
+        global_mul_policy = default_mul_policy();
+    }
+
+    cached = *global_mul_policy;
+    // NOTE: the generation can change only while
+    // holding the mutex, thus it is consistent
+    // with the policy we just copied.
+    cached_gen = global_mul_policy_gen.load(::std::memory_order_relaxed);
+
+    return cached;
+}
+
+void set_global_mul_policy(const mul_policy &p)
+{
+    check_mul_policy(p);
+
+    ::std::lock_guard<::std::mutex> lock(global_mul_policy_mutex);
+
+    global_mul_policy = p;
+    global_mul_policy_gen.fetch_add(1, ::std::memory_order_release);
+}
+
+::std::optional<mul_policy> &mul_policy_tls()
+{
+    static thread_local ::std::optional<mul_policy> p;
+
+    return p;
+}
+
+} // namespace obake::polynomials::detail
@@ -6,10 +6,18 @@
 // Public License v. 2.0. If a copy of the MPL was not distributed
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <functional>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
-#include <tuple>
+#include <typeindex>
+#include <typeinfo>
 
 #include <obake/series.hpp>
 
@@ -60,24 +68,217 @@ void series_stream_single_term(::std::string &ret, ::std::string &str_cf, const
 namespace customisation::internal
 {
 
-// On-demand instantiation of the global
-// objects used to implement the pow map.
-::std::tuple<series_pow_map_t &, ::std::mutex &> get_series_pow_map()
+::std::atomic<::std::uint64_t> series_pow_cache_epoch = 0;
+::std::atomic<::std::size_t> series_pow_cache_bytes = 0;
+::std::atomic<::std::size_t> series_pow_cache_max_bytes = ::std::numeric_limits<::std::size_t>::max();
+::std::atomic<pow_algo> series_pow_algo_setting(pow_algo::linear);
+::std::atomic<bool> series_evaluate_compensated(false);
+
+namespace
+{
+
+// The number of shards in the series pow cache.
+// NOTE: must be a power of 2.
+constexpr ::std::size_t series_pow_cache_n_shards = 64;
+
+static_assert((series_pow_cache_n_shards & (series_pow_cache_n_shards - 1u)) == 0u);
+
+// On-demand instantiation of the shards
+// of the series pow cache.
+series_pow_cache_shard *get_series_pow_cache_shards()
+{
+    static series_pow_cache_shard shards[series_pow_cache_n_shards];
+
+    return shards;
+}
+
+// The number of evictions from the series pow cache.
+::std::atomic<::std::size_t> series_pow_cache_evictions = 0;
+
+// Mark an entry of the cache as evicted and remove its
+// byte size from the global counter.
+// NOTE: this must be invoked while holding the lock
+// on the shard containing the entry.
+void series_pow_cache_retire(series_pow_cache_entry &e)
+{
+    ::std::lock_guard lock(e.mutex);
+
+    assert(!e.evicted);
+    e.evicted = true;
+    series_pow_cache_bytes.fetch_sub(e.bytes, ::std::memory_order_relaxed);
+}
+
+// Evict the entry e from the shard s.
+// NOTE: this must be invoked while holding the lock on s.
+void series_pow_cache_erase(series_pow_cache_shard &s, series_pow_cache_entry &e)
+{
+    auto &te_map = s.map.find(::std::type_index(*e.type))->second;
+    const auto it = te_map.find(e.key);
+    assert(it != te_map.end());
+    assert(it->second.get() == &e);
+
+    series_pow_cache_unlink(s, e);
+    series_pow_cache_retire(e);
+    // NOTE: this may destroy e.
+    te_map.erase(it);
+
+    series_pow_cache_evictions.fetch_add(1, ::std::memory_order_relaxed);
+}
+
+} // namespace
+
+series_pow_cache_shard &get_series_pow_cache_shard(::std::size_t h)
 {
-    static series_pow_map_t retval;
-    static ::std::mutex mutex;
-    return ::std::make_tuple(::std::ref(retval), ::std::ref(mutex));
+    // NOTE: the hash of a base is computed by combining
+    // additively the hashes of the keys, whose low bits might
+    // be poorly distributed. Mix it before selecting the shard.
+    auto x = static_cast<::std::uint64_t>(h);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+
+    return get_series_pow_cache_shards()[static_cast<::std::size_t>(x) & (series_pow_cache_n_shards - 1u)];
 }
 
 void clear_series_pow_map()
 {
-    // Fetch the global data.
-    auto [map, mutex] = internal::get_series_pow_map();
+    auto shards = get_series_pow_cache_shards();
+
+    for (::std::size_t i = 0; i < series_pow_cache_n_shards; ++i) {
+        // Lock down before accessing the shard.
+        ::std::lock_guard lock(shards[i].mutex);
+
+        for (auto &p : shards[i].map) {
+            for (auto &q : p.second) {
+                series_pow_cache_retire(*q.second);
+            }
+        }
+
+        shards[i].map.clear();
+        shards[i].lru_head = nullptr;
+        shards[i].lru_tail = nullptr;
+    }
+}
+
+void series_pow_cache_evict(const series_pow_cache_entry *skip)
+{
+    auto over_limit = []() {
+        return series_pow_cache_bytes.load(::std::memory_order_relaxed)
+               > series_pow_cache_max_bytes.load(::std::memory_order_relaxed);
+    };
+
+    if (!over_limit()) {
+        // Fast path: the cache is within its capacity limit.
+        return;
+    }
+
+    auto shards = get_series_pow_cache_shards();
+
+    // The eviction candidate of the shard i, that is, the least
+    // recently used entry in the shard other than skip (if any).
+    // NOTE: this must be invoked while holding the lock on the shard.
+    auto candidate = [shards, skip](::std::size_t i) {
+        auto *c = shards[i].lru_tail;
+        if (c != nullptr && c == skip) {
+            c = c->lru_prev;
+        }
+
+        return c;
+    };
+
+    // The times of last use of the eviction candidates
+    // of the shards, or empty optionals for the shards
+    // without candidates.
+    ::std::array<::std::optional<::std::uint64_t>, series_pow_cache_n_shards> cand_use;
+    auto update_cand_use = [&candidate, &cand_use](::std::size_t i) {
+        const auto *c = candidate(i);
+        cand_use[i] = c != nullptr ? ::std::optional<::std::uint64_t>(c->last_use) : ::std::nullopt;
+    };
+
+    for (::std::size_t i = 0; i < series_pow_cache_n_shards; ++i) {
+        ::std::lock_guard lock(shards[i].mutex);
+
+        update_cand_use(i);
+    }
+
+    while (over_limit()) {
+        // Pick the shard whose candidate was used least recently.
+        // NOTE: the shards are locked one at a time, thus the
+        // times of last use of the other candidates might be stale
+        // by now. This only makes the LRU order across shards approximate.
+        auto victim = series_pow_cache_n_shards;
+        for (::std::size_t i = 0; i < series_pow_cache_n_shards; ++i) {
+            if (cand_use[i] && (victim == series_pow_cache_n_shards || *cand_use[i] < *cand_use[victim])) {
+                victim = i;
+            }
+        }
+
+        if (victim == series_pow_cache_n_shards) {
+            // No entry can be evicted. This can happen if
+            // the only entry left is skip, or if the total byte size
+            // is being updated concurrently by threads which are
+            // computing the powers of entries evicted in the meantime.
+            break;
+        }
+
+        ::std::lock_guard lock(shards[victim].mutex);
+
+        // NOTE: the candidate might have changed since it was
+        // recorded, in which case we evict the current one.
+        if (auto *c = candidate(victim)) {
+            series_pow_cache_erase(shards[victim], *c);
+        }
+
+        update_cand_use(victim);
+    }
+}
+
+::std::size_t series_pow_map_size()
+{
+    auto shards = get_series_pow_cache_shards();
+
+    ::std::size_t retval = 0;
+    for (::std::size_t i = 0; i < series_pow_cache_n_shards; ++i) {
+        // Lock down before accessing the shard.
+        ::std::lock_guard lock(shards[i].mutex);
+
+        for (const auto &p : shards[i].map) {
+            retval += p.second.size();
+        }
+    }
+
+    return retval;
+}
+
+pow_cache_stats get_series_pow_cache_stats()
+{
+    pow_cache_stats retval;
 
-    // Lock down before accessing the cache.
-    ::std::lock_guard lock(mutex);
+    retval.evictions = series_pow_cache_evictions.load(::std::memory_order_relaxed);
+    retval.max_bytes = series_pow_cache_max_bytes.load(::std::memory_order_relaxed);
+
+    auto shards = get_series_pow_cache_shards();
+
+    for (::std::size_t i = 0; i < series_pow_cache_n_shards; ++i) {
+        retval.hits += shards[i].hits.load(::std::memory_order_relaxed);
+        retval.misses += shards[i].misses.load(::std::memory_order_relaxed);
+
+        // Lock down before accessing the shard.
+        ::std::lock_guard lock(shards[i].mutex);
+
+        for (const auto &p : shards[i].map) {
+            for (const auto &q : p.second) {
+                ::std::lock_guard e_lock(q.second->mutex);
+
+                retval.bytes_per_type[q.second->type_name] += q.second->bytes;
+                retval.bytes += q.second->bytes;
+            }
+
+            retval.n_bases += p.second.size();
+        }
+    }
 
-    map.clear();
+    return retval;
 }
 
 } // namespace customisation::internal
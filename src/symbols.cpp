@@ -7,12 +7,17 @@
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <functional>
 #include <initializer_list>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <utility>
 
 #include <boost/container/container_fwd.hpp>
@@ -168,6 +173,145 @@ namespace obake::detail
     return ::std::make_tuple(::std::move(u_set), ::std::move(m1), ::std::move(m2));
 }
 
+namespace
+{
+
+// Cache for the results of merge_symbol_sets_fw().
+// The keys are the addresses of the interned symbol sets.
+// NOTE: the entries keep a copy of the input flyweights:
+// like this, the interned symbol sets cannot be destroyed
+// while they are in the cache, and their addresses cannot
+// be re-used for different symbol sets.
+struct ss_merge_cache {
+    using key_t = ::std::pair<const symbol_set *, const symbol_set *>;
+
+    struct hasher {
+        ::std::size_t operator()(const key_t &k) const
+        {
+            ::std::size_t retval = ::std::hash<const symbol_set *>{}(k.first);
+            ::boost::hash_combine(retval, k.second);
+
+            return retval;
+        }
+    };
+
+    struct entry {
+        ss_fw s1, s2;
+        ::std::shared_ptr<const ss_merge_result> res;
+        // Value of the shard's clock at the time
+        // of the last access to the entry.
+        unsigned long long last_use;
+    };
+
+    // Number of shards.
+    static constexpr ::std::size_t n_shards = 64;
+
+    // NOTE: the cache is meant to be small: when a shard
+    // reaches its maximum size, the least recently
+    // used entry in the shard is evicted.
+    static constexpr ::std::size_t max_size = 1024;
+    static constexpr ::std::size_t max_shard_size = max_size / n_shards;
+
+    // NOTE: align to avoid false sharing between
+    // the mutexes of different shards.
+    struct alignas(64) shard {
+        ::std::mutex mutex;
+        ::std::unordered_map<key_t, entry, hasher> map;
+        unsigned long long clock = 0;
+        unsigned long long n_hits = 0;
+        unsigned long long n_misses = 0;
+    };
+
+    shard shards[n_shards];
+};
+
+ss_merge_cache &get_ss_merge_cache()
+{
+    static ss_merge_cache cache;
+
+    return cache;
+}
+
+} // namespace
+
+// Cached version of merge_symbol_sets(). The result is returned
+// via a shared pointer, so that it remains valid even if the
+// entry is evicted from the cache.
+::std::shared_ptr<const ss_merge_result> merge_symbol_sets_fw(const ss_fw &s1, const ss_fw &s2)
+{
+    const ss_merge_cache::key_t key{&s1.get(), &s2.get()};
+    const auto h = ss_merge_cache::hasher{}(key);
+
+    auto &shard = detail::get_ss_merge_cache().shards[h % ss_merge_cache::n_shards];
+
+    {
+        ::std::lock_guard lock{shard.mutex};
+
+        const auto it = shard.map.find(key);
+        if (it != shard.map.end()) {
+            ++shard.n_hits;
+            it->second.last_use = ++shard.clock;
+
+            return it->second.res;
+        }
+
+        ++shard.n_misses;
+    }
+
+    // Compute the result outside the lock.
+    auto [u_set, m1, m2] = detail::merge_symbol_sets(s1.get(), s2.get());
+    auto res = ::std::make_shared<const ss_merge_result>(ss_fw(::std::move(u_set)), ::std::move(m1), ::std::move(m2));
+
+    ::std::lock_guard lock{shard.mutex};
+
+    // NOTE: another thread might have inserted the same
+    // result in the meantime, in which case we keep the existing one.
+    const auto it = shard.map.find(key);
+    if (it != shard.map.end()) {
+        it->second.last_use = ++shard.clock;
+
+        return it->second.res;
+    }
+
+    if (shard.map.size() >= ss_merge_cache::max_shard_size) {
+        // Evict the least recently used entry.
+        const auto lru = ::std::min_element(shard.map.begin(), shard.map.end(), [](const auto &a, const auto &b) {
+            return a.second.last_use < b.second.last_use;
+        });
+        shard.map.erase(lru);
+    }
+
+    return shard.map.emplace(key, ss_merge_cache::entry{s1, s2, ::std::move(res), ++shard.clock}).first->second.res;
+}
+
+ss_merge_cache_stats get_ss_merge_cache_stats()
+{
+    ss_merge_cache_stats retval;
+
+    for (auto &shard : detail::get_ss_merge_cache().shards) {
+        ::std::lock_guard lock{shard.mutex};
+
+        retval.n_hits += shard.n_hits;
+        retval.n_misses += shard.n_misses;
+        retval.size += static_cast<::std::size_t>(shard.map.size());
+    }
+
+    return retval;
+}
+
+// Clear the cache and reset the counters.
+void clear_ss_merge_cache()
+{
+    for (auto &shard : detail::get_ss_merge_cache().shards) {
+        ::std::lock_guard lock{shard.mutex};
+
+        shard.map.clear();
+        shard.clock = 0;
+        shard.n_hits = 0;
+        shard.n_misses = 0;
+    }
+}
+
 // This function first computes the intersection ix of the two sets s and s_ref, and then returns
 // a set with the positional indices of ix in s_ref.
 // NOTE: the implementation of this (and sm_intersect_idx()) can be probably improved
@@ -256,4 +400,180 @@ symbol_idx_set ss_intersect_idx(const symbol_set &s, const symbol_set &s_ref)
     return retval;
 }
 
+namespace
+{
+
+// Number of shards in the symbol_set interning table.
+constexpr ::std::size_t ss_fw_n_shards = 64;
+
+// A shard of the interning table. The nodes are indexed
+// by the hash of their symbol sets.
+// NOTE: align to avoid false sharing between
+// the mutexes of different shards.
+struct alignas(64) ss_fw_shard {
+    ::std::mutex mutex;
+    ::std::unordered_multimap<::std::size_t, ss_fw_node *> map;
+};
+
+ss_fw_shard &get_ss_fw_shard(::std::size_t h)
+{
+    // NOTE: the table is never destroyed, so that flyweights
+    // with static storage duration can be safely destroyed
+    // at program shutdown.
+    static auto *const shards = new ss_fw_shard[ss_fw_n_shards];
+
+    return shards[h % ss_fw_n_shards];
+}
+
+// Flag signalling that the per-thread cache
+// has been destroyed at thread exit.
+// NOTE: this is kept separate from the cache, so that
+// it can be safely read after the destruction of the
+// cache (it is trivially destructible).
+thread_local bool ss_fw_cache_destroyed = false;
+
+// Per-thread cache of recently-used nodes. The cache
+// holds a reference to each node it contains, so that
+// the nodes can be fetched without locking.
+struct ss_fw_tls_cache {
+    static constexpr ::std::size_t size = 16;
+
+    ss_fw_tls_cache() = default;
+    ss_fw_tls_cache(const ss_fw_tls_cache &) = delete;
+    ss_fw_tls_cache &operator=(const ss_fw_tls_cache &) = delete;
+    ~ss_fw_tls_cache()
+    {
+        // NOTE: the destruction of a node may trigger (via the
+        // destructors of other thread-local objects) further
+        // interning on this thread, which must then bypass the cache.
+        ss_fw_cache_destroyed = true;
+
+        for (auto &n : slots) {
+            auto old = n;
+            n = nullptr;
+
+            if (old != nullptr && old->n_refs.fetch_sub(1, ::std::memory_order_acq_rel) == 1u) {
+                detail::ss_fw_destroy(old);
+            }
+        }
+    }
+
+    ss_fw_node *slots[size] = {};
+};
+
+thread_local ss_fw_tls_cache ss_fw_cache;
+
+template <typename S>
+ss_fw_node *ss_fw_intern_impl(S &&s)
+{
+    const auto h = ss_fw_hasher{}(s);
+
+    // Look into the thread-local cache first (unless
+    // it was already destroyed at thread exit).
+    auto *const slot = ss_fw_cache_destroyed ? nullptr : &ss_fw_cache.slots[h % ss_fw_tls_cache::size];
+    if (slot != nullptr && *slot != nullptr && (*slot)->hash == h && (*slot)->value == s) {
+        // NOTE: the cache holds a reference to the node,
+        // thus the node cannot be destroyed concurrently.
+        (*slot)->n_refs.fetch_add(1, ::std::memory_order_relaxed);
+
+        return *slot;
+    }
+
+    ss_fw_node *retval = nullptr;
+
+    {
+        auto &shard = detail::get_ss_fw_shard(h);
+
+        ::std::lock_guard lock{shard.mutex};
+
+        for (auto [it, end] = shard.map.equal_range(h); it != end; ++it) {
+            auto n = it->second;
+
+            if (n->value != s) {
+                continue;
+            }
+
+            // NOTE: a node whose reference count dropped to zero is
+            // about to be removed from the table by another thread,
+            // and it must not be revived.
+            auto cur = n->n_refs.load(::std::memory_order_relaxed);
+            while (cur != 0u) {
+                if (n->n_refs.compare_exchange_weak(cur, cur + 1u, ::std::memory_order_relaxed)) {
+                    retval = n;
+                    break;
+                }
+            }
+
+            if (retval != nullptr) {
+                break;
+            }
+        }
+
+        if (retval == nullptr) {
+            // The symbol set is not in the table, add it.
+            auto new_node = ::std::make_unique<ss_fw_node>(::std::forward<S>(s), h);
+            shard.map.emplace(h, new_node.get());
+            retval = new_node.release();
+        }
+    }
+
+    // Store the node in the cache, replacing
+    // the previous one (if any).
+    if (slot != nullptr) {
+        retval->n_refs.fetch_add(1, ::std::memory_order_relaxed);
+        auto old = *slot;
+        *slot = retval;
+        if (old != nullptr && old->n_refs.fetch_sub(1, ::std::memory_order_acq_rel) == 1u) {
+            detail::ss_fw_destroy(old);
+        }
+    }
+
+    return retval;
+}
+
+} // namespace
+
+ss_fw_node *ss_fw_intern(const symbol_set &s)
+{
+    return detail::ss_fw_intern_impl(s);
+}
+
+ss_fw_node *ss_fw_intern(symbol_set &&s)
+{
+    return detail::ss_fw_intern_impl(::std::move(s));
+}
+
+// Fetch the node of the empty symbol set. This is used in
+// the default constructor of ss_fw, and it is kept alive
+// forever.
+ss_fw_node *ss_fw_intern_empty()
+{
+    static auto *const n = detail::ss_fw_intern(symbol_set{});
+
+    n->n_refs.fetch_add(1, ::std::memory_order_relaxed);
+
+    return n;
+}
+
+// Remove the node n from the table and destroy it.
+void ss_fw_destroy(ss_fw_node *n) noexcept
+{
+    assert(n->n_refs.load() == 0u);
+
+    {
+        auto &shard = detail::get_ss_fw_shard(n->hash);
+
+        ::std::lock_guard lock{shard.mutex};
+
+        for (auto [it, end] = shard.map.equal_range(n->hash); it != end; ++it) {
+            if (it->second == n) {
+                shard.map.erase(it);
+                break;
+            }
+        }
+    }
+
+    delete n;
+}
+
 } // namespace obake::detail
@@ -0,0 +1,179 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <obake/detail/acc_table.hpp>
+
+#include "catch.hpp"
+
+using namespace obake;
+
+// A hasher which maps all keys to the same
+// hash value, in order to stress the probing.
+struct bad_hasher {
+    std::size_t operator()(const int &) const
+    {
+        return 42u;
+    }
+};
+
+// A coefficient type which counts the number of
+// live objects.
+static int n_live = 0;
+
+struct counted_cf {
+    counted_cf(int n) : value(n)
+    {
+        ++n_live;
+    }
+    counted_cf(const counted_cf &other) : value(other.value)
+    {
+        ++n_live;
+    }
+    counted_cf(counted_cf &&other) noexcept : value(other.value)
+    {
+        ++n_live;
+    }
+    ~counted_cf()
+    {
+        --n_live;
+    }
+    int value;
+};
+
+TEST_CASE("acc_table_basic")
+{
+    detail::acc_table<int, std::string, std::hash<int>, std::equal_to<int>> t;
+
+    REQUIRE(t.empty());
+    REQUIRE(t.size() == 0u);
+    REQUIRE(t.capacity() == 0u);
+
+    // Lazy construction: the functor must be invoked
+    // only on actual insertion.
+    int n_calls = 0;
+    auto res = t.lazy_emplace(1, [&n_calls]() {
+        ++n_calls;
+        return std::string("a");
+    });
+    REQUIRE(res.second);
+    REQUIRE(*res.first == "a");
+    REQUIRE(n_calls == 1);
+    REQUIRE(t.size() == 1u);
+    REQUIRE(t.capacity() > 0u);
+
+    res = t.lazy_emplace(1, [&n_calls]() {
+        ++n_calls;
+        return std::string("b");
+    });
+    REQUIRE(!res.second);
+    REQUIRE(*res.first == "a");
+    REQUIRE(n_calls == 1);
+    *res.first += "b";
+
+    // Many insertions, with rehashing.
+    for (int i = 2; i < 1000; ++i) {
+        res = t.lazy_emplace(i, [i]() { return std::to_string(i); });
+        REQUIRE(res.second);
+    }
+    REQUIRE(t.size() == 999u);
+    for (int i = 2; i < 1000; ++i) {
+        res = t.lazy_emplace(i, []() { return std::string{}; });
+        REQUIRE(!res.second);
+        REQUIRE(*res.first == std::to_string(i));
+    }
+
+    // Consume the table.
+    std::map<int, std::string> m;
+    t.consume([&m](int &k, std::string &c) { m.emplace(k, std::move(c)); });
+    REQUIRE(t.empty());
+    REQUIRE(m.size() == 999u);
+    REQUIRE(m[1] == "ab");
+    REQUIRE(m[500] == "500");
+
+    // The table is still usable after consume().
+    const auto old_cap = t.capacity();
+    res = t.lazy_emplace(1, []() { return std::string("c"); });
+    REQUIRE(res.second);
+    REQUIRE(t.capacity() == old_cap);
+    t.clear();
+    REQUIRE(t.empty());
+
+    // Reserve.
+    detail::acc_table<int, int, std::hash<int>, std::equal_to<int>> t2;
+    t2.reserve(100);
+    const auto cap2 = t2.capacity();
+    REQUIRE(cap2 >= 100u);
+    for (int i = 0; i < 100; ++i) {
+        t2.lazy_emplace(i, [i]() { return i; });
+    }
+    REQUIRE(t2.size() == 100u);
+    REQUIRE(t2.capacity() == cap2);
+    t2.reserve(10);
+    REQUIRE(t2.capacity() == cap2);
+}
+
+TEST_CASE("acc_table_collisions")
+{
+    detail::acc_table<int, int, bad_hasher, std::equal_to<int>> t;
+
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(t.lazy_emplace(i, [i]() { return i; }).second);
+    }
+    for (int i = 0; i < 100; ++i) {
+        const auto res = t.lazy_emplace(i, []() { return -1; });
+        REQUIRE(!res.second);
+        REQUIRE(*res.first == i);
+    }
+    REQUIRE(t.size() == 100u);
+}
+
+TEST_CASE("acc_table_exception_safety")
+{
+    {
+        detail::acc_table<int, counted_cf, std::hash<int>, std::equal_to<int>> t;
+
+        for (int i = 0; i < 10; ++i) {
+            t.lazy_emplace(i, [i]() { return counted_cf{i}; });
+        }
+        REQUIRE(n_live == 10);
+
+        // A throwing coefficient constructor must leave
+        // the table unchanged.
+        REQUIRE_THROWS_AS(t.lazy_emplace(10,
+                                         []() -> counted_cf {
+                                             throw std::runtime_error("");
+                                         }),
+                          std::runtime_error);
+        REQUIRE(t.size() == 10u);
+        REQUIRE(n_live == 10);
+
+        // The key can be inserted afterwards.
+        REQUIRE(t.lazy_emplace(10, []() { return counted_cf{10}; }).second);
+        REQUIRE(t.size() == 11u);
+        REQUIRE(n_live == 11);
+
+        // A throwing consume() functor: the remaining
+        // terms are destroyed by the destructor.
+        int n = 0;
+        REQUIRE_THROWS_AS(t.consume([&n](int &, counted_cf &) {
+            if (++n == 5) {
+                throw std::runtime_error("");
+            }
+        }),
+                          std::runtime_error);
+    }
+
+    REQUIRE(n_live == 0);
+}
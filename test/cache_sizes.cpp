@@ -0,0 +1,25 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/detail/cache_sizes.hpp>
+
+#include "catch.hpp"
+
+using namespace obake;
+
+TEST_CASE("cache_sizes_test")
+{
+    // The sizes are either zero (undetected) or at least 1KB.
+    const auto &cs = detail::get_cache_sizes();
+    REQUIRE((cs.l1d == 0u || cs.l1d >= 1024u));
+    REQUIRE((cs.l2 == 0u || cs.l2 >= 1024u));
+    REQUIRE((cs.l3 == 0u || cs.l3 >= 1024u));
+
+    // The detection is performed only once.
+    REQUIRE(&cs == &detail::get_cache_sizes());
+}
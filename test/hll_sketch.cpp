@@ -0,0 +1,61 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cmath>
+#include <cstdint>
+
+#include <obake/detail/hll_sketch.hpp>
+
+#include "catch.hpp"
+
+using namespace obake;
+
+TEST_CASE("hll_sketch_test")
+{
+    // Empty sketch.
+    detail::hll_sketch<> s;
+    REQUIRE(s.estimate() == 0.);
+
+    // Sequential hash values (as produced, e.g., by the
+    // homomorphic hashing of packed monomials).
+    for (auto n : {10u, 1000u, 100000u, 1000000u}) {
+        detail::hll_sketch<> s1;
+        for (auto i = 0u; i < n; ++i) {
+            s1.add(i);
+        }
+        REQUIRE(std::abs(s1.estimate() - n) / n < 0.05);
+
+        // Duplicates do not change the estimate.
+        const auto est = s1.estimate();
+        for (auto i = 0u; i < n; ++i) {
+            s1.add(i);
+        }
+        REQUIRE(s1.estimate() == est);
+    }
+
+    // Merging.
+    detail::hll_sketch<> s1, s2, s3;
+    for (std::uint64_t i = 0; i < 100000u; ++i) {
+        s1.add(i);
+        s3.add(i);
+    }
+    for (std::uint64_t i = 50000; i < 150000u; ++i) {
+        s2.add(i);
+        s3.add(i);
+    }
+    s1.merge(s2);
+    REQUIRE(s1.estimate() == s3.estimate());
+    REQUIRE(std::abs(s1.estimate() - 150000.) / 150000. < 0.05);
+
+    // Lower precision.
+    detail::hll_sketch<8> s4;
+    for (auto i = 0u; i < 100000u; ++i) {
+        s4.add(i);
+    }
+    REQUIRE(std::abs(s4.estimate() - 100000.) / 100000. < 0.25);
+}
@@ -0,0 +1,79 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <string>
+#include <type_traits>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/config.hpp>
+#include <obake/math/square.hpp>
+
+#include "catch.hpp"
+
+using namespace obake;
+
+// A type with a square() overload
+// found via ADL.
+namespace ns
+{
+
+struct sq00 {
+};
+
+inline int square(const sq00 &)
+{
+    return 42;
+}
+
+// A type with an external customisation.
+struct sq01 {
+};
+
+// A non-squarable type.
+struct nosq00 {
+};
+
+} // namespace ns
+
+namespace obake::customisation
+{
+
+inline int square(square_t, const ns::sq01 &)
+{
+    return -42;
+}
+
+} // namespace obake::customisation
+
+TEST_CASE("square_test")
+{
+    REQUIRE(is_squarable_v<int>);
+    REQUIRE(is_squarable_v<int &>);
+    REQUIRE(is_squarable_v<const int &>);
+    REQUIRE(is_squarable_v<double &&>);
+    REQUIRE(!is_squarable_v<void>);
+    REQUIRE(!is_squarable_v<std::string>);
+    REQUIRE(!is_squarable_v<ns::nosq00>);
+
+    REQUIRE(obake::square(3) == 9);
+    REQUIRE(std::is_same_v<int, decltype(obake::square(3))>);
+    REQUIRE(obake::square(-1.5) == 2.25);
+    REQUIRE(obake::square(mppp::integer<1>{-7}) == 49);
+    REQUIRE(obake::square(mppp::rational<1>{1, 3}) == mppp::rational<1>{1, 9});
+
+    REQUIRE(is_squarable_v<ns::sq00>);
+    REQUIRE(obake::square(ns::sq00{}) == 42);
+
+    REQUIRE(is_squarable_v<ns::sq01>);
+    REQUIRE(obake::square(ns::sq01{}) == -42);
+
+    REQUIRE(Squarable<int>);
+    REQUIRE(!Squarable<ns::nosq00>);
+}
@@ -0,0 +1,120 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <mp++/rational.hpp>
+
+#include <obake/math/evaluate.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/evaluator.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+static std::mt19937 rng;
+
+TEST_CASE("evaluator_basic")
+{
+    using rat_t = mppp::rational<1>;
+    using poly_t = polynomial<packed_monomial<std::int32_t>, rat_t>;
+
+    // Type checks.
+    REQUIRE(std::is_same_v<polynomial_evaluator<packed_monomial<std::int32_t>, rat_t>,
+                           decltype(make_evaluator(poly_t{}))>);
+    REQUIRE(std::is_same_v<rat_t, decltype(make_evaluator(poly_t{})(symbol_map<rat_t>{}))>);
+    REQUIRE(std::is_same_v<double, decltype(make_evaluator(poly_t{})(symbol_map<double>{}))>);
+
+    // Empty polynomial.
+    REQUIRE(make_evaluator(poly_t{})(symbol_map<rat_t>{}) == 0);
+    REQUIRE(make_evaluator(poly_t{}).get_n_terms() == 0u);
+
+    auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+    const auto p = (x - 2 * y + z / 3) * (x * x + y - 1) * (x * y * z + rat_t{1, 2});
+    const auto ev = make_evaluator(p);
+
+    REQUIRE(ev.get_symbol_set() == symbol_set{"x", "y", "z"});
+    REQUIRE(ev.get_n_terms() == p.size());
+
+    const symbol_map<rat_t> sm{{"x", rat_t{1, 2}}, {"y", rat_t{-3, 4}}, {"z", rat_t{5}}};
+    REQUIRE(ev(sm) == evaluate(p, sm));
+
+    // Missing symbols.
+    OBAKE_REQUIRES_THROWS_CONTAINS(ev(symbol_map<rat_t>{{"x", rat_t{1}}, {"z", rat_t{1}}}), std::invalid_argument,
+                                   "Cannot evaluate a polynomial: the evaluation map does not contain the symbol 'y'");
+
+    // Negative exponents.
+    poly_t q;
+    q.set_symbol_set(symbol_set{"x", "y"});
+    q.add_term(packed_monomial<std::int32_t>{-2, 1}, 3);
+    q.add_term(packed_monomial<std::int32_t>{1, -1}, 1);
+    q.add_term(packed_monomial<std::int32_t>{0, 0}, 2);
+    REQUIRE(make_evaluator(q)(symbol_map<rat_t>{{"x", rat_t{2}}, {"y", rat_t{3}}})
+            == rat_t{9, 4} + rat_t{2, 3} + 2);
+}
+
+TEST_CASE("evaluator_batch")
+{
+    using poly_t = polynomial<packed_monomial<std::int32_t>, double>;
+    using dpoly_t = polynomial<d_packed_monomial<std::int32_t, 2>, double>;
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+    auto [dx, dy, dz, dt] = make_polynomials<dpoly_t>("x", "y", "z", "t");
+
+    auto p = x + y + 2 * z * z + 3 * t * t * t + 1;
+    auto q = 1 - x + 2 * y * y - z * z * z + t;
+    p *= p;
+    p *= q;
+    p *= q;
+
+    auto dp = dx + dy + 2 * dz * dz + 3 * dt * dt * dt + 1;
+    auto dq = 1 - dx + 2 * dy * dy - dz * dz * dz + dt;
+    dp *= dp;
+    dp *= dq;
+    dp *= dq;
+
+    const auto ev = make_evaluator(p);
+    const auto dev = make_evaluator(dp);
+
+    std::uniform_real_distribution<double> dist(-1., 1.);
+
+    // Test a few numbers of points, including
+    // multiples of the batch size.
+    for (auto n : {std::size_t(0), std::size_t(1), std::size_t(63), std::size_t(64), std::size_t(65),
+                   std::size_t(1000), std::size_t(1024)}) {
+        std::vector<double> pts(n * 4u), out(n), dout(n);
+        for (auto &v : pts) {
+            v = dist(rng);
+        }
+
+        ev(pts.data(), n, out.data());
+        dev(pts.data(), n, dout.data());
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const symbol_map<double> sm{
+                {"t", pts[i * 4u]}, {"x", pts[i * 4u + 1u]}, {"y", pts[i * 4u + 2u]}, {"z", pts[i * 4u + 3u]}};
+            const auto ref = evaluate(p, sm);
+
+            REQUIRE(std::abs(out[i] - ref) <= 1E-12 * (1. + std::abs(ref)));
+            REQUIRE(std::abs(dout[i] - ref) <= 1E-12 * (1. + std::abs(ref)));
+        }
+    }
+}
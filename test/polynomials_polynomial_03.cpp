@@ -14,12 +14,14 @@
 #include <mp++/rational.hpp>
 
 #include <obake/config.hpp>
+#include <obake/math/pow.hpp>
 #include <obake/math/subs.hpp>
 #include <obake/polynomials/packed_monomial.hpp>
 #include <obake/polynomials/polynomial.hpp>
 #include <obake/symbols.hpp>
 
 #include "catch.hpp"
+#include "test_utils.hpp"
 
 using namespace obake;
 
@@ -98,3 +100,63 @@ TEST_CASE("polynomial_subs_test")
     REQUIRE(subs(p, symbol_map<poly_t>{{"x", 3 * x}, {"y", -y}, {"z", x * y}})
             == 3 * x * -y * x * y - 3 * 3 * x + 4 * -y + 5 * 3 * x * -y + -y * -y);
 }
+
+// Substitution into larger polynomials, with
+// single and multiple segments.
+TEST_CASE("polynomial_subs_segmented_test")
+{
+    using int1_t = mppp::integer<1>;
+    using rat1_t = mppp::rational<1>;
+    using pm_t = packed_monomial<std::int32_t>;
+    using poly_t = polynomial<pm_t, int1_t>;
+    using poly2_t = polynomial<pm_t, rat1_t>;
+
+    auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+    auto tmp = 1 + x + y + z;
+    tmp = tmp * tmp * tmp * tmp;
+    const auto prod = tmp * tmp;
+
+    // Copy prod into a single-segment polynomial
+    // and into a polynomial with 8 segments.
+    const auto p1 = obake_test::make_segmented(prod, 0), p8 = obake_test::make_segmented(prod, 3);
+    REQUIRE(p1._get_s_table().size() == 1u);
+    REQUIRE(p8._get_s_table().size() == 8u);
+    REQUIRE(p1 == p8);
+
+    for (const auto &p : {p1, p8}) {
+        // Substitution with polynomial values.
+        const auto s = subs(p, symbol_map<poly_t>{{"x", x + y}, {"z", 2 * z - 1}});
+        REQUIRE(subs(s, symbol_map<int1_t>{{"x", int1_t{2}}, {"y", int1_t{3}}, {"z", int1_t{5}}})
+                == subs(p, symbol_map<int1_t>{{"x", int1_t{5}}, {"y", int1_t{3}}, {"z", int1_t{9}}}));
+
+        // Substituting the variables with themselves.
+        REQUIRE(subs(p, symbol_map<poly_t>{{"x", x}, {"y", y}, {"z", z}}) == prod);
+
+        // Substitution of all variables.
+        REQUIRE(subs(p, symbol_map<int1_t>{{"x", int1_t{1}}, {"y", int1_t{1}}, {"z", int1_t{1}}}) == 65536);
+        REQUIRE(subs(p, symbol_map<rat1_t>{{"x", rat1_t{1, 2}}, {"y", rat1_t{1, 2}}, {"z", rat1_t{-3, 2}}})
+                == rat1_t{1, 256});
+    }
+
+    // Negative exponents.
+    poly_t q;
+    q.set_symbol_set(symbol_set{"x", "y"});
+    q.add_term(pm_t{-2, 1}, 3);
+    q.add_term(pm_t{1, -1}, 1);
+    q.add_term(pm_t{-2, 0}, 2);
+    REQUIRE(subs(q, symbol_map<rat1_t>{{"x", rat1_t{2}}, {"y", rat1_t{3}}})
+            == poly2_t{rat1_t{9, 4} + rat1_t{2, 3} + rat1_t{1, 2}});
+
+    // Sparse exponents, with a large gap.
+    poly_t r;
+    r.set_symbol_set(symbol_set{"x", "y"});
+    r.add_term(pm_t{1000, 1}, 1);
+    r.add_term(pm_t{4, 2}, 1);
+    r.add_term(pm_t{3, 0}, 3);
+    r.add_term(pm_t{2, 0}, 2);
+    r.add_term(pm_t{0, 1}, 5);
+    REQUIRE(subs(r, symbol_map<poly_t>{{"x", 2 * y}})
+            == obake::pow(2 * y, 1000) * y + obake::pow(2 * y, 4) * y * y + 3 * obake::pow(2 * y, 3)
+                   + 2 * obake::pow(2 * y, 2) + 5 * y);
+}
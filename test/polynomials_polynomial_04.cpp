@@ -11,6 +11,7 @@
 #include <stdexcept>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 #include <mp++/integer.hpp>
 #include <mp++/rational.hpp>
@@ -107,6 +108,86 @@ TEST_CASE("polynomial_diff")
     REQUIRE(diff(p, "aa") == 0);
 }
 
+TEST_CASE("polynomial_gradient_jacobian")
+{
+    detail::tuple_for_each(std::make_tuple(1, mppp::integer<1>{}), [](auto n) {
+        using cf_t = decltype(n);
+
+        using pm_t = packed_monomial<exp_t>;
+        using poly_t = polynomial<pm_t, cf_t>;
+
+        auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+        REQUIRE(gradient(poly_t{}).empty());
+        REQUIRE(gradient(x).size() == 1u);
+        REQUIRE(gradient(x)[0] == 1);
+
+        auto p = 3 * x * x * y - 2 * z * y + 4 * x * z * z * z + 5;
+        const auto g = gradient(p);
+        REQUIRE(std::is_same_v<decltype(g[0]), decltype(diff(p, "x")) const &>);
+        REQUIRE(g.size() == 3u);
+        REQUIRE(g[0] == diff(p, "x"));
+        REQUIRE(g[1] == diff(p, "y"));
+        REQUIRE(g[2] == diff(p, "z"));
+
+        // Larger segmented polynomial.
+        auto q = 1 + x + y + z + x * y * z;
+        q = q * q * q;
+        q *= q;
+        q *= q;
+        const auto q16 = obake_test::make_segmented(q, 4);
+
+        const auto gq = gradient(q16);
+        REQUIRE(gq.size() == 3u);
+        REQUIRE(gq[0] == diff(q, "x"));
+        REQUIRE(gq[1] == diff(q, "y"));
+        REQUIRE(gq[2] == diff(q, "z"));
+
+        // Jacobian.
+        REQUIRE(jacobian(std::vector<poly_t>{}).empty());
+
+        const auto jac = jacobian(std::vector<poly_t>{x * y, z * z - 1, poly_t{4}});
+        REQUIRE(jac.size() == 3u);
+        REQUIRE(jac[0].size() == 3u);
+        REQUIRE(jac[0][0] == y);
+        REQUIRE(jac[0][1] == x);
+        REQUIRE(jac[0][2] == 0);
+        REQUIRE(jac[1][0] == 0);
+        REQUIRE(jac[1][1] == 0);
+        REQUIRE(jac[1][2] == 2 * z);
+        REQUIRE(jac[2][0] == 0);
+        REQUIRE(jac[2][1] == 0);
+        REQUIRE(jac[2][2] == 0);
+    });
+
+    // Recursive poly test, with coefficients
+    // depending on the differentiation symbols.
+    using pm_t = packed_monomial<exp_t>;
+    using p1_t = polynomial<pm_t, mppp::integer<1>>;
+    using p11_t = polynomial<pm_t, p1_t>;
+
+    auto [x, y] = make_polynomials<p1_t>("x", "y");
+    auto [z] = make_polynomials<p11_t>("z");
+
+    auto p = 3 * x * x * y - 2 * z * y + 4 * x * z * z * z;
+    const auto g = gradient(p);
+    REQUIRE(g.size() == 1u);
+    REQUIRE(g[0] == -2 * y + 4 * x * 3 * z * z);
+
+    const auto jac = jacobian(std::vector<p11_t>{p, z * x});
+    REQUIRE(jac.size() == 2u);
+    REQUIRE(jac[0].size() == 1u);
+    REQUIRE(jac[0][0] == -2 * y + 4 * x * 3 * z * z);
+    REQUIRE(jac[1][0] == x);
+
+    // Same symbol in the coefficients and in the keys.
+    auto [xo] = make_polynomials<p11_t>("x");
+    const auto gx = gradient(xo * x * x + z * x);
+    REQUIRE(gx.size() == 2u);
+    REQUIRE(gx[0] == diff(xo * x * x + z * x, "x"));
+    REQUIRE(gx[1] == diff(xo * x * x + z * x, "z"));
+}
+
 TEST_CASE("polynomial_integrate")
 {
     detail::tuple_for_each(std::make_tuple(1, mppp::rational<1>{}), [](auto n) {
@@ -188,6 +269,65 @@ TEST_CASE("polynomial_integrate")
     });
 }
 
+TEST_CASE("polynomial_diff_integrate_segmented")
+{
+    detail::tuple_for_each(std::make_tuple(1, mppp::rational<1>{}), [](auto n) {
+        using cf_t = decltype(n);
+
+        using pm_t = packed_monomial<exp_t>;
+        using poly_t = polynomial<pm_t, cf_t>;
+
+        auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+        auto p = 1 + x + y + z + x * y * z;
+        p = p * p * p;
+        p *= p;
+        p *= p;
+
+        // Copy p into a segmented polynomial.
+        const auto p16 = obake_test::make_segmented(p, 4);
+
+        for (const auto &s : {"x", "y", "z", "t"}) {
+            const auto d = diff(p, s), d16 = diff(p16, s);
+            REQUIRE(d16 == d);
+            REQUIRE(d16.get_symbol_set() == d.get_symbol_set());
+
+            const auto i = integrate(p, s), i16 = integrate(p16, s);
+            REQUIRE(i16 == i);
+            REQUIRE(i16.get_symbol_set() == i.get_symbol_set());
+        }
+
+        // The term insertion algorithms preserve the segmentation.
+        if constexpr (std::is_same_v<mppp::rational<1>, cf_t>) {
+            REQUIRE(diff(p16, "x").get_s_size() == 4u);
+            REQUIRE(integrate(p16, "x").get_s_size() == 4u);
+        }
+    });
+
+    // Recursive poly test, with coefficients
+    // depending on the differentiation symbols.
+    using pm_t = packed_monomial<exp_t>;
+    using p1_t = polynomial<pm_t, mppp::integer<1>>;
+    using p11_t = polynomial<pm_t, p1_t>;
+
+    auto [x, y] = make_polynomials<p1_t>("x", "y");
+    auto [z] = make_polynomials<p11_t>("z");
+
+    auto p = obake::pow(x + y + z + x * z + 1, 10);
+
+    const auto p16 = obake_test::make_segmented(p, 4);
+
+    REQUIRE(diff(p16, "x") == diff(p, "x"));
+    REQUIRE(diff(p16, "z") == diff(p, "z"));
+
+    // Error checking in the integration.
+    OBAKE_REQUIRES_THROWS_CONTAINS(
+        integrate(p16, "x"), std::invalid_argument,
+        "The current polynomial integration algorithm requires the derivatives of all "
+        "coefficients with respect to the symbol 'x' to be zero, but a coefficient with nonzero derivative was "
+        "detected");
+}
+
 TEST_CASE("polynomial_truncate_degree")
 {
     using pm_t = packed_monomial<exp_t>;
@@ -0,0 +1,867 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <mp++/integer.hpp>
+
+#include <tbb/global_control.h>
+
+#include <obake/config.hpp>
+#include <obake/detail/hc.hpp>
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/kpack.hpp>
+#include <obake/math/fma3.hpp>
+#include <obake/math/pow.hpp>
+#include <obake/math/square.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Helper to compute the product of x and y via the simple
+// and the mt_hm implementations.
+template <typename P, typename... Args>
+inline auto mul_simple_mt_hm(const P &x, const P &y, const Args &...args)
+{
+    P r_simple, r_mt_hm;
+    r_simple.set_symbol_set(x.get_symbol_set());
+    r_mt_hm.set_symbol_set(x.get_symbol_set());
+
+    polynomials::detail::poly_mul_impl_simple(r_simple, x, y, args...);
+    polynomials::detail::poly_mul_impl_mt_hm(r_mt_hm, x, y, args...);
+
+    return std::make_pair(std::move(r_simple), std::move(r_mt_hm));
+}
+
+// Helper to install in the calling thread, for the lifetime
+// of the returned guard, the current multiplication policy
+// with the engine e.
+inline polynomials::mul_policy_guard engine_guard(polynomials::mul_engine e)
+{
+    auto p = polynomials::get_mul_policy();
+    p.engine = e;
+
+    return polynomials::mul_policy_guard(p);
+}
+
+TEST_CASE("polynomial_mul_dense_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+        using v_t = std::vector<std::pair<pm_t, decltype(xs)>>;
+
+        auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+        // Dense operands, with positive exponents.
+        auto f = x + y + z + 1;
+        const auto tmp_f(f);
+        for (int i = 1; i < 8; ++i) {
+            f *= tmp_f;
+        }
+
+        auto [r0, r1] = mul_simple_mt_hm(f, f + 2);
+        REQUIRE(r0 == r1);
+        REQUIRE(r0.size() == 969u);
+
+        // Check that the dense engine is actually selected
+        // for these operands.
+        {
+            v_t v1(f.begin(), f.end()), v2(f.begin(), f.end());
+            poly_t retval;
+            retval.set_symbol_set(f.get_symbol_set());
+            REQUIRE(polynomials::detail::poly_mul_impl_dense<poly_t, poly_t>(
+                retval, v1, v2, mppp::integer<1>{969}, mppp::integer<1>{165 * 165}, false));
+            REQUIRE(retval == f * f);
+        }
+
+        // Vectors of pointers to the terms of a segmented series.
+        {
+            poly_t g;
+            g.set_symbol_set(f.get_symbol_set());
+            g.set_n_segments(3);
+            for (const auto &t : f) {
+                g.add_term(t.first, t.second);
+            }
+
+            const auto vp = polynomials::detail::poly_mul_impl_par_make_ptr_vector(g);
+            REQUIRE(vp.size() == g.size());
+            for (const auto *ptr : vp) {
+                REQUIRE(g.find(ptr->first) != g.end());
+                REQUIRE(&*g.find(ptr->first) == ptr);
+            }
+            auto vp_sorted(vp);
+            std::sort(vp_sorted.begin(), vp_sorted.end());
+            REQUIRE(std::adjacent_find(vp_sorted.begin(), vp_sorted.end()) == vp_sorted.end());
+
+            // The dense engine must accept vectors of pointers.
+            poly_t retval;
+            retval.set_symbol_set(f.get_symbol_set());
+            REQUIRE(polynomials::detail::poly_mul_impl_dense<poly_t, poly_t>(
+                retval, vp, vp, mppp::integer<1>{969}, mppp::integer<1>{165 * 165}, false));
+            REQUIRE(retval == f * f);
+
+            // Multiplication of segmented operands.
+            std::tie(r0, r1) = mul_simple_mt_hm(g, g + 2 * x);
+            REQUIRE(r0 == r1);
+            REQUIRE(r0 == f * (f + 2 * x));
+        }
+
+        // Cancellations.
+        std::tie(r0, r1) = mul_simple_mt_hm(f, f - 2 * x * f);
+        REQUIRE(r0 == r1);
+
+        // Negative exponents.
+        poly_t xm1;
+        xm1.set_symbol_set(symbol_set{"x", "y", "z"});
+        xm1.add_term(pm_t{-1, 0, 0}, 1);
+        poly_t zm2;
+        zm2.set_symbol_set(symbol_set{"x", "y", "z"});
+        zm2.add_term(pm_t{0, 0, -2}, 1);
+
+        std::tie(r0, r1) = mul_simple_mt_hm(f * xm1 * zm2, f * xm1 - 3);
+        REQUIRE(r0 == r1);
+
+        // Truncated multiplication.
+        std::tie(r0, r1) = mul_simple_mt_hm(f, f, 10);
+        REQUIRE(r0 == r1);
+        std::tie(r0, r1) = mul_simple_mt_hm(f * xm1, f * zm2, -2);
+        REQUIRE(r0 == r1);
+        std::tie(r0, r1) = mul_simple_mt_hm(f, f, 5, symbol_set{"x", "z"});
+        REQUIRE(r0 == r1);
+        std::tie(r0, r1) = mul_simple_mt_hm(f * zm2, f * xm1, -1, symbol_set{"x"});
+        REQUIRE(r0 == r1);
+
+        // Sparse operands: the dense engine must not be selected.
+        {
+            poly_t g;
+            g.set_symbol_set(symbol_set{"x", "y", "z"});
+            g.add_term(pm_t{0, 0, 0}, 1);
+            g.add_term(pm_t{100, 100, 100}, 1);
+
+            v_t v1(g.begin(), g.end()), v2(g.begin(), g.end());
+            poly_t retval;
+            retval.set_symbol_set(g.get_symbol_set());
+            REQUIRE(!polynomials::detail::poly_mul_impl_dense<poly_t, poly_t>(
+                retval, v1, v2, mppp::integer<1>{3}, mppp::integer<1>{4}, false));
+            REQUIRE(retval.empty());
+        }
+    });
+}
+
+TEST_CASE("polynomial_mul_heap_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+
+        auto [x, y, z] = make_polynomials<poly_t>(symbol_set{"x", "y", "z"}, "x", "y", "z");
+
+        // A few simple tests.
+        poly_t retval;
+        retval.set_symbol_set(symbol_set{"x", "y", "z"});
+        polynomials::detail::poly_mul_impl_heap(retval, x + y, x - y);
+        REQUIRE(retval == x * x - y * y);
+        retval.clear_terms();
+
+        polynomials::detail::poly_mul_impl_heap(retval, x + y, x - y - 1, 1);
+        REQUIRE(retval == -x - y);
+        retval.clear_terms();
+
+        polynomials::detail::poly_mul_impl_heap(retval, x + y, x - y, 0);
+        REQUIRE(retval.empty());
+        retval.clear_terms();
+
+        // Compare with the simple implementation on larger operands.
+        auto f = x * x + y + z * 2 - 1;
+        auto g = x + y * z - z * 3 + 1;
+        const auto tmp_f(f), tmp_g(g);
+        for (int i = 1; i < 6; ++i) {
+            f *= tmp_f;
+            g *= tmp_g;
+        }
+
+        poly_t r_simple, r_heap;
+        r_simple.set_symbol_set(symbol_set{"x", "y", "z"});
+        r_heap.set_symbol_set(symbol_set{"x", "y", "z"});
+        const auto [a, b] = f.size() <= g.size() ? std::make_pair(f, g) : std::make_pair(g, f);
+
+        polynomials::detail::poly_mul_impl_simple(r_simple, a, b);
+        polynomials::detail::poly_mul_impl_heap(r_heap, a, b);
+        REQUIRE(r_simple == r_heap);
+        r_simple.clear_terms();
+        r_heap.clear_terms();
+
+        polynomials::detail::poly_mul_impl_simple(r_simple, a, b, 7);
+        polynomials::detail::poly_mul_impl_heap(r_heap, a, b, 7);
+        REQUIRE(r_simple == r_heap);
+        r_simple.clear_terms();
+        r_heap.clear_terms();
+
+        polynomials::detail::poly_mul_impl_simple(r_simple, a, b, 3, symbol_set{"x", "z"});
+        polynomials::detail::poly_mul_impl_heap(r_heap, a, b, 3, symbol_set{"x", "z"});
+        REQUIRE(r_simple == r_heap);
+
+        // Streaming: the terms must be produced in ascending order.
+        std::vector<pm_t> keys;
+        poly_t r_stream;
+        r_stream.set_symbol_set(symbol_set{"x", "y", "z"});
+        polynomials::mul_stream(f, g, [&keys, &r_stream](pm_t &&k, decltype(xs) &&c) {
+            keys.push_back(k);
+            r_stream.add_term(std::move(k), std::move(c));
+        });
+        // NOTE: fetch the statistics before
+        // running other multiplications.
+        const auto stream_stats = polynomials::get_last_mul_stats();
+        REQUIRE(stream_stats.engine == polynomials::mul_engine::heap);
+        REQUIRE(stream_stats.n_terms == r_stream.size());
+        REQUIRE(r_stream == f * g);
+        REQUIRE(std::is_sorted(keys.begin(), keys.end(),
+                               [](const pm_t &k1, const pm_t &k2) { return k1.get_value() < k2.get_value(); }));
+
+        OBAKE_REQUIRES_THROWS_CONTAINS(polynomials::mul_stream(f, make_polynomials<poly_t>("t")[0], [](auto &&...) {}),
+                                       std::invalid_argument,
+                                       "The symbol sets of the operands of mul_stream() must be identical");
+
+        // Engine selection.
+        const auto prod = f * g;
+        for (auto e : {polynomials::mul_engine::simple, polynomials::mul_engine::hash, polynomials::mul_engine::dense,
+                       polynomials::mul_engine::heap}) {
+            const auto eg = engine_guard(e);
+            REQUIRE(polynomials::get_mul_policy().engine == e);
+
+            REQUIRE(f * g == prod);
+
+            const auto stats = polynomials::get_last_mul_stats();
+            if (e == polynomials::mul_engine::dense) {
+                REQUIRE((stats.engine == polynomials::mul_engine::dense
+                         || stats.engine == polynomials::mul_engine::hash));
+            } else {
+                REQUIRE(stats.engine == e);
+            }
+            REQUIRE(stats.n_terms == prod.size());
+
+            // The segment count and the load imbalance
+            // are reported only by the hash-based engine.
+            if (stats.engine == polynomials::mul_engine::hash) {
+                REQUIRE(stats.n_segments > 0u);
+                REQUIRE(stats.load_imbalance >= 0);
+            } else {
+                REQUIRE(stats.n_segments == 0u);
+                REQUIRE(stats.load_imbalance == 0);
+            }
+        }
+    });
+}
+
+TEST_CASE("polynomial_mul_load_imbalance_test")
+{
+    using poly_t = polynomial<packed_monomial<exp_t>, mppp::integer<1>>;
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+    const auto f = obake::pow(1 + x + y + z + t, 10), g = f + 1;
+
+    const auto eg = engine_guard(polynomials::mul_engine::hash);
+
+    // With a single thread available, the first worker task
+    // processes all the segments and the other tasks find no
+    // work left. The idle tasks must not count as imbalance.
+    tbb::global_control gc(tbb::global_control::max_allowed_parallelism, 1);
+
+    const auto prod = f * g;
+    const auto stats = polynomials::get_last_mul_stats();
+    REQUIRE(stats.engine == polynomials::mul_engine::hash);
+    REQUIRE(stats.n_terms == prod.size());
+    REQUIRE(stats.load_imbalance == 1);
+}
+
+TEST_CASE("polynomial_sqr_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+        using v_t = std::vector<std::pair<pm_t, decltype(xs)>>;
+
+        auto [x, y, z] = make_polynomials<poly_t>(symbol_set{"x", "y", "z"}, "x", "y", "z");
+
+        auto f = x * x - y + z * 2 - 1;
+        const auto tmp_f(f);
+        for (int i = 1; i < 8; ++i) {
+            f *= tmp_f;
+        }
+        // A copy of f, used to run the non-squaring
+        // implementations.
+        const auto f_copy(f);
+
+        // Helper to compare the squaring and non-squaring
+        // results of an implementation.
+        auto check = [&f, &f_copy](auto impl, const auto &...args) {
+            poly_t r_sqr, r_mul;
+            r_sqr.set_symbol_set(f.get_symbol_set());
+            r_mul.set_symbol_set(f.get_symbol_set());
+
+            impl(r_sqr, f, f, args...);
+            impl(r_mul, f, f_copy, args...);
+
+            REQUIRE(r_sqr == r_mul);
+        };
+
+        auto simple = [](auto &r, const auto &a, const auto &b, const auto &...args) {
+            polynomials::detail::poly_mul_impl_simple(r, a, b, args...);
+        };
+        auto mt_hm = [](auto &r, const auto &a, const auto &b, const auto &...args) {
+            polynomials::detail::poly_mul_impl_mt_hm(r, a, b, args...);
+        };
+
+        for (auto e : {polynomials::mul_engine::hash, polynomials::mul_engine::dense}) {
+            const auto eg = engine_guard(e);
+
+            check(simple);
+            check(mt_hm);
+            check(simple, 9);
+            check(mt_hm, 9);
+            check(simple, -1);
+            check(mt_hm, -1);
+            check(simple, 5, symbol_set{"x", "y"});
+            check(mt_hm, 5, symbol_set{"x", "y"});
+        }
+
+        // A larger example, so that the multithreaded
+        // implementation uses more segments.
+        {
+            auto [a, b, c, d, e] = make_polynomials<poly_t>("a", "b", "c", "d", "e");
+
+            auto g = a + b + c + d + e + 1;
+            const auto tmp_g(g);
+            for (int i = 1; i < 8; ++i) {
+                g *= tmp_g;
+            }
+            const auto g_copy(g);
+
+            const auto eg = engine_guard(polynomials::mul_engine::hash);
+
+            for (auto n : {-1, 6, 100}) {
+                poly_t r_sqr, r_mul;
+                r_sqr.set_symbol_set(g.get_symbol_set());
+                r_mul.set_symbol_set(g.get_symbol_set());
+
+                polynomials::detail::poly_mul_impl_mt_hm(r_sqr, g, g, n);
+                polynomials::detail::poly_mul_impl_mt_hm(r_mul, g, g_copy, n);
+
+                REQUIRE(r_sqr == r_mul);
+            }
+        }
+
+        // Dense engine in squaring mode.
+        {
+            v_t v1(f.begin(), f.end());
+            poly_t retval;
+            retval.set_symbol_set(f.get_symbol_set());
+            REQUIRE(polynomials::detail::poly_mul_impl_dense<poly_t, poly_t>(
+                retval, v1, v1, mppp::integer<1>{f.size() * f.size()}, mppp::integer<1>{f.size() * f.size()}, true));
+            REQUIRE(retval == f * f_copy);
+        }
+
+        // Top level functions.
+        REQUIRE(f * f == f * f_copy);
+        REQUIRE(square(f) == f * f_copy);
+        REQUIRE(square(poly_t{f}) == f * f_copy);
+        REQUIRE(square(x + y) == x * x + 2 * x * y + y * y);
+    });
+}
+
+TEST_CASE("polynomial_fma3_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+
+        REQUIRE(is_mult_addable_v<poly_t &, const poly_t &, const poly_t &>);
+        REQUIRE(!is_mult_addable_v<const poly_t &, const poly_t &, const poly_t &>);
+
+        auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+        auto f = x + y + z + t + 1;
+        const auto tmp_f(f);
+        for (int i = 1; i < 8; ++i) {
+            f *= tmp_f;
+        }
+        const auto g = f + 2 * x - 3 * t;
+
+        for (auto e : {polynomials::mul_engine::automatic, polynomials::mul_engine::simple,
+                       polynomials::mul_engine::hash, polynomials::mul_engine::dense}) {
+            const auto eg = engine_guard(e);
+
+            // Empty accumulator.
+            poly_t acc;
+            acc.set_symbol_set(f.get_symbol_set());
+            fma3(acc, f, g);
+            REQUIRE(acc == f * g);
+
+            // Non-empty accumulator (possibly segmented).
+            const auto expected = acc + f * g;
+            fma3(acc, f, g);
+            REQUIRE(acc == expected);
+
+            // Non-empty, non-segmented accumulator.
+            acc = x * y - 1;
+            fma3(acc, g, f);
+            REQUIRE(acc == x * y - 1 + f * g);
+
+            // Squaring.
+            acc = x * y - 1;
+            fma3(acc, f, f);
+            REQUIRE(acc == x * y - 1 + f * g - f * (2 * x - 3 * t));
+
+            // Cancellation.
+            acc = -(f * g);
+            fma3(acc, f, g);
+            REQUIRE(acc.empty());
+            acc = -(f * g) + x;
+            fma3(acc, g, f);
+            REQUIRE(acc == x);
+
+            // Aliasing.
+            acc = x - 1;
+            fma3(acc, acc, f);
+            REQUIRE(acc == (x - 1) * (f + 1));
+            acc = x - 1;
+            fma3(acc, f, acc);
+            REQUIRE(acc == (x - 1) * (f + 1));
+
+            // Different symbol sets.
+            auto [a] = make_polynomials<poly_t>("a");
+            acc = a;
+            fma3(acc, f, g);
+            REQUIRE(acc == a + f * g);
+            acc = x;
+            fma3(acc, a, g);
+            REQUIRE(acc == x + a * g);
+
+            // Empty operands.
+            acc = x;
+            fma3(acc, poly_t{}, g);
+            REQUIRE(acc == x);
+
+            // Overflow: the error is detected
+            // before acc is modified.
+            poly_t big;
+            big.set_symbol_set(symbol_set{"x"});
+            big.add_term(pm_t{detail::kpack_get_lims<exp_t>(1).second}, 1);
+            acc = x + 1;
+            OBAKE_REQUIRES_THROWS_CONTAINS(
+                fma3(acc, big, big), std::overflow_error,
+                "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+            REQUIRE(acc == x + 1);
+        }
+    });
+}
+
+TEST_CASE("polynomial_mul_many_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+
+        auto [x, y, z, t, a, b] = make_polynomials<poly_t>("x", "y", "z", "t", "a", "b");
+
+        auto f = x + y + z + t + 1;
+        const auto tmp_f(f);
+        for (int i = 1; i < 8; ++i) {
+            f *= tmp_f;
+        }
+
+        // Empty input vector.
+        REQUIRE(mul_many(f, std::vector<poly_t>{}).empty());
+        REQUIRE(mul_many(f, std::vector<poly_t>{}, 3).empty());
+        REQUIRE(mul_many(f, std::vector<poly_t>{}, 3, symbol_set{"x"}).empty());
+
+        // Mix of larger and smaller operands, different symbol sets
+        // (some shared between multiple operands), empty operands
+        // and x itself.
+        std::vector<poly_t> ys{f + x,   x - 1, f * (z - t), a * x + 2, a - b, poly_t{},
+                               f * a,   f,     b * y * y,   y * a - 3, t};
+
+        for (auto e : {polynomials::mul_engine::automatic, polynomials::mul_engine::simple,
+                       polynomials::mul_engine::hash, polynomials::mul_engine::dense}) {
+            const auto eg = engine_guard(e);
+
+            auto res = mul_many(f, ys);
+            REQUIRE(res.size() == ys.size());
+            for (decltype(ys.size()) i = 0; i < ys.size(); ++i) {
+                REQUIRE(res[i] == f * ys[i]);
+            }
+
+            res = mul_many(f, ys, 5);
+            REQUIRE(res.size() == ys.size());
+            for (decltype(ys.size()) i = 0; i < ys.size(); ++i) {
+                REQUIRE(res[i] == truncated_mul(f, ys[i], 5));
+            }
+
+            res = mul_many(f, ys, 2, symbol_set{"x", "a"});
+            REQUIRE(res.size() == ys.size());
+            for (decltype(ys.size()) i = 0; i < ys.size(); ++i) {
+                REQUIRE(res[i] == truncated_mul(f, ys[i], 2, symbol_set{"x", "a"}));
+            }
+
+            // Truncation limit producing empty results.
+            res = mul_many(f, ys, -1);
+            REQUIRE(std::all_of(res.begin(), res.end(), [](const auto &p) { return p.empty(); }));
+        }
+
+        // The subset of terms used in place of x for the
+        // overflow check must preserve the limits of the
+        // exponents and of the degrees.
+        auto g = x + y + 1;
+        const auto tmp_g(g);
+        for (int i = 1; i < 6; ++i) {
+            g *= tmp_g;
+        }
+        const auto v = polynomials::detail::poly_mul_impl_par_make_ptr_vector(g);
+        const auto ov = polynomials::detail::poly_mul_impl_overflow_subset(v, g.get_symbol_set());
+        REQUIRE(ov.size() < v.size());
+        for (const auto &k : {pm_t{6, 0}, pm_t{0, 6}, pm_t{0, 0}}) {
+            REQUIRE(std::any_of(ov.begin(), ov.end(), [&k](const auto &p) { return p->first == k; }));
+        }
+
+        // Overflow detection.
+        poly_t h;
+        h.set_symbol_set(symbol_set{"a"});
+        for (exp_t i = 0; i < 10; ++i) {
+            h.add_term(pm_t{i}, 1);
+        }
+        h.add_term(pm_t{detail::kpack_get_lims<exp_t>(1).second}, 1);
+
+        for (auto e : {polynomials::mul_engine::simple, polynomials::mul_engine::hash}) {
+            const auto eg = engine_guard(e);
+
+            OBAKE_REQUIRES_THROWS_CONTAINS(mul_many(h, std::vector<poly_t>{h}), std::overflow_error,
+                                           "An overflow in the monomial exponents was detected");
+            OBAKE_REQUIRES_THROWS_CONTAINS(mul_many(h, std::vector<poly_t>{2 * h}, 100), std::overflow_error,
+                                           "An overflow in the monomial exponents was detected");
+        }
+    });
+}
+
+TEST_CASE("polynomial_mul_policy_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+
+    // The default policy.
+    const auto def = polynomials::get_default_mul_policy();
+    REQUIRE(def.simple_threshold > 0u);
+    REQUIRE(def.sparse_seg_size > 0u);
+    REQUIRE(def.dense_seg_size > 0u);
+    REQUIRE(def.sparse_seg_size >= def.dense_seg_size);
+    REQUIRE(def.sparsity_threshold == 1E-3);
+
+    auto cur = polynomials::get_mul_policy();
+    REQUIRE(cur.simple_threshold == def.simple_threshold);
+    REQUIRE(cur.sparse_seg_size == def.sparse_seg_size);
+    REQUIRE(cur.dense_seg_size == def.dense_seg_size);
+
+    // Invalid policies.
+    auto bad = def;
+    bad.sparse_seg_size = 0;
+    OBAKE_REQUIRES_THROWS_CONTAINS(polynomials::set_mul_policy(bad), std::invalid_argument,
+                                   "The segment sizes in a polynomial multiplication policy must be nonzero");
+    bad = def;
+    bad.sparsity_threshold = -1;
+    OBAKE_REQUIRES_THROWS_CONTAINS(polynomials::mul_policy_guard{bad}, std::invalid_argument,
+                                   "The sparsity threshold in a polynomial multiplication policy must be finite");
+    REQUIRE(polynomials::get_mul_policy().sparse_seg_size == def.sparse_seg_size);
+    bad = def;
+    bad.engine = static_cast<polynomials::mul_engine>(-1);
+    OBAKE_REQUIRES_THROWS_CONTAINS(polynomials::mul_policy_guard{bad}, std::invalid_argument,
+                                   "Invalid engine specified in a polynomial multiplication policy");
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    auto f = x + y + z + t + 1;
+    const auto tmp_f(f);
+    for (int i = 1; i < 8; ++i) {
+        f *= tmp_f;
+    }
+    const auto g = f + 2 * x - 3 * t;
+    const auto cmp = f * g;
+
+    // Global policy: always run the simple implementation.
+    auto p = def;
+    p.simple_threshold = std::numeric_limits<std::size_t>::max();
+    polynomials::set_mul_policy(p);
+    REQUIRE(f * g == cmp);
+    auto stats = polynomials::get_last_mul_stats();
+    REQUIRE(stats.engine == polynomials::mul_engine::simple);
+    REQUIRE(stats.policy.simple_threshold == std::numeric_limits<std::size_t>::max());
+    REQUIRE(stats.seg_size == 0u);
+
+    {
+        // Thread-local policy: run the MT implementation
+        // with small segments, without the dense engine.
+        auto p2 = def;
+        p2.simple_threshold = 0;
+        p2.sparse_seg_size = 1024;
+        p2.dense_seg_size = 512;
+        p2.engine = polynomials::mul_engine::hash;
+        const polynomials::mul_policy_guard pg(p2);
+
+        REQUIRE(polynomials::get_mul_policy().simple_threshold == 0u);
+        REQUIRE(polynomials::get_mul_policy().engine == polynomials::mul_engine::hash);
+
+        // The engine of the guard must not
+        // leak into other threads.
+        auto other_engine = polynomials::mul_engine::hash;
+        std::thread([&other_engine]() { other_engine = polynomials::get_mul_policy().engine; }).join();
+        REQUIRE(other_engine == polynomials::mul_engine::automatic);
+
+        REQUIRE(f * g == cmp);
+        stats = polynomials::get_last_mul_stats();
+        if (detail::hc() > 1u) {
+            REQUIRE(stats.engine == polynomials::mul_engine::hash);
+        }
+        REQUIRE(stats.policy.simple_threshold == 0u);
+        REQUIRE((stats.seg_size == 1024u || stats.seg_size == 512u));
+
+        // The policy must be used also in truncated
+        // and one-to-many multiplications.
+        REQUIRE(truncated_mul(f, g, 5) == truncated_mul(g, f, 5));
+        stats = polynomials::get_last_mul_stats();
+        REQUIRE(stats.policy.dense_seg_size == 512u);
+
+        const auto res = mul_many(f, std::vector<poly_t>{g, x * g, y - 1});
+        REQUIRE(res[0] == cmp);
+        REQUIRE(res[1] == x * cmp);
+        REQUIRE(res[2] == f * (y - 1));
+
+        {
+            // Nested guards.
+            const polynomials::mul_policy_guard pg2(def);
+            REQUIRE(polynomials::get_mul_policy().simple_threshold == def.simple_threshold);
+        }
+        REQUIRE(polynomials::get_mul_policy().simple_threshold == 0u);
+    }
+
+    // Back to the global policy.
+    REQUIRE(polynomials::get_mul_policy().simple_threshold == std::numeric_limits<std::size_t>::max());
+
+    polynomials::reset_mul_policy();
+    REQUIRE(polynomials::get_mul_policy().simple_threshold == def.simple_threshold);
+}
+
+// A coefficient type which checks, in each product, that
+// the multiplication policy in effect in the thread computing
+// the product uses the hash-based engine.
+std::atomic<bool> probe_active(false);
+std::atomic<unsigned long long> probe_n_mults(0), probe_n_mismatches(0);
+
+struct probe_cf {
+    probe_cf() = default;
+    explicit probe_cf(int n) : value(n) {}
+
+    probe_cf &operator+=(const probe_cf &other)
+    {
+        value += other.value;
+        return *this;
+    }
+    probe_cf &operator-=(const probe_cf &other)
+    {
+        value -= other.value;
+        return *this;
+    }
+    probe_cf operator-() const
+    {
+        return probe_cf(-value);
+    }
+    friend probe_cf operator*(const probe_cf &a, const probe_cf &b)
+    {
+        if (probe_active.load()) {
+            ++probe_n_mults;
+            if (polynomials::get_mul_policy().engine != polynomials::mul_engine::hash) {
+                ++probe_n_mismatches;
+            }
+        }
+
+        return probe_cf(a.value * b.value);
+    }
+    friend bool operator==(const probe_cf &a, const probe_cf &b)
+    {
+        return a.value == b.value;
+    }
+    friend bool operator!=(const probe_cf &a, const probe_cf &b)
+    {
+        return a.value != b.value;
+    }
+    friend std::ostream &operator<<(std::ostream &os, const probe_cf &c)
+    {
+        return os << c.value;
+    }
+
+    int value = 0;
+};
+
+TEST_CASE("polynomial_mul_policy_nested_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+    using p_t = polynomial<pm_t, probe_cf>;
+    using pp_t = polynomial<pm_t, p_t>;
+
+    REQUIRE(polynomials::get_mul_policy().engine == polynomials::mul_engine::automatic);
+
+    // Build polynomials of polynomials with the global policy.
+    auto [a, b] = make_polynomials<p_t>("a", "b");
+    auto [x, y, z] = make_polynomials<pp_t>("x", "y", "z");
+
+    auto f = x * (a + b) + y * (a - b) + z * a + b;
+    const auto tmp_f(f);
+    for (int i = 1; i < 4; ++i) {
+        f *= tmp_f;
+    }
+    const auto g = f + x * b;
+    const auto cmp = f * g;
+
+    // Thread-local policy: the products of the coefficients, computed
+    // in the worker threads of the outer multiplication, must use it
+    // as well.
+    {
+        const auto eg = engine_guard(polynomials::mul_engine::hash);
+
+        probe_n_mults.store(0);
+        probe_n_mismatches.store(0);
+        probe_active.store(true);
+        const auto prod = f * g;
+        probe_active.store(false);
+
+        REQUIRE(polynomials::get_last_mul_stats().engine == polynomials::mul_engine::hash);
+        REQUIRE(prod == cmp);
+        REQUIRE(probe_n_mults.load() > 0u);
+        REQUIRE(probe_n_mismatches.load() == 0u);
+    }
+
+    REQUIRE(polynomials::get_mul_policy().engine == polynomials::mul_engine::automatic);
+}
+
+TEST_CASE("polynomial_mul_estimator_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+
+    const auto def = polynomials::get_default_mul_policy();
+    REQUIRE(def.estimator == polynomials::mul_estimator::sampling);
+    REQUIRE(def.sketch_max_mults > 0u);
+
+    auto bad = def;
+    bad.sketch_max_mults = 0;
+    OBAKE_REQUIRES_THROWS_CONTAINS(polynomials::set_mul_policy(bad), std::invalid_argument,
+                                   "The max number of term-by-term multiplications for the sketch-based estimator");
+
+    auto [x, y, z, t, u] = make_polynomials<poly_t>("x", "y", "z", "t", "u");
+
+    // Dense.
+    auto f = x + y + z + t + 1;
+    const auto tmp_f(f);
+    for (int i = 1; i < 8; ++i) {
+        f *= tmp_f;
+    }
+    const auto g = f + 2 * x - 3 * t;
+
+    // Sparse.
+    auto h = x + y + z * z * 2 + t * t * t * 3 + u * u * u * u * u * 5 + 1;
+    const auto tmp_h(h);
+    auto l = u + t + z * z * 2 + y * y * y * 3 + x * x * x * x * x * 5 + 1;
+    const auto tmp_l(l);
+    for (int i = 1; i < 5; ++i) {
+        h *= tmp_h;
+        l *= tmp_l;
+    }
+
+    // Rectangular.
+    // NOTE: use positive coefficients, so that there are
+    // no cancellations in the product (which the estimator
+    // cannot account for).
+    const auto r = x * y + z + 1;
+
+    // Compute the reference products with the sampling estimator.
+    const auto eg = engine_guard(polynomials::mul_engine::hash);
+    const auto fg = f * g, hl = h * l, fr = f * r, fg_t = truncated_mul(f, g, 6), hl_t = truncated_mul(h, l, 10);
+
+    for (auto max_mults : {def.sketch_max_mults, std::size_t(1000), std::size_t(1)}) {
+        auto p = def;
+        p.engine = polynomials::mul_engine::hash;
+        p.estimator = polynomials::mul_estimator::sketch;
+        p.sketch_max_mults = max_mults;
+        const polynomials::mul_policy_guard pg(p);
+
+        // Helper to check the accuracy of the estimate
+        // in the last multiplication.
+        auto check_est = [max_mults, &def](double tol) {
+            const auto stats = polynomials::get_last_mul_stats();
+            REQUIRE(stats.est_n_terms > 0u);
+            REQUIRE(stats.est_time >= 0);
+            if (max_mults == def.sketch_max_mults) {
+                // All the products are streamed.
+                REQUIRE(std::abs(static_cast<double>(stats.est_n_terms) - static_cast<double>(stats.n_terms))
+                            / static_cast<double>(stats.n_terms)
+                        < tol);
+            }
+        };
+
+        REQUIRE(f * g == fg);
+        check_est(0.05);
+        REQUIRE(h * l == hl);
+        check_est(0.05);
+        REQUIRE(f * r == fr);
+        check_est(0.05);
+        REQUIRE(truncated_mul(f, g, 6) == fg_t);
+        check_est(0.05);
+        REQUIRE(truncated_mul(h, l, 10) == hl_t);
+        check_est(0.05);
+
+        // Truncation limit producing an empty result.
+        REQUIRE(truncated_mul(f, g, -1).empty());
+    }
+}
@@ -7,6 +7,7 @@
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <sstream>
 #include <stdexcept>
@@ -16,9 +17,13 @@
 
 #include <fmt/core.h>
 
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
 #include <obake/cf/cf_tex_stream_insert.hpp>
 #include <obake/math/degree.hpp>
 #include <obake/math/diff.hpp>
+#include <obake/math/fma3.hpp>
 #include <obake/math/integrate.hpp>
 #include <obake/math/p_degree.hpp>
 #include <obake/math/pow.hpp>
@@ -1047,6 +1052,241 @@ TEST_CASE("pow")
     }
 }
 
+TEST_CASE("pow miller")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using ps_t = p_series<pm_t, double>;
+    using ps_q_t = p_series<pm_t, mppp::rational<1>>;
+
+    // Rational coefficients, integral exponents.
+    {
+        auto [x, y, z] = make_p_series_t<ps_q_t>(8, "x", "y", "z");
+
+        const auto f = 2 + x - 3 * y + x * z / 2;
+
+        auto cmp = f;
+        for (auto i = 1; i < 5; ++i) {
+            cmp *= f;
+        }
+
+        auto ret = obake::pow(f, 5);
+        REQUIRE(ret == cmp);
+        REQUIRE(obake::get_truncation(ret).index() == 1u);
+        REQUIRE(std::get<1>(obake::get_truncation(ret)) == 8);
+        REQUIRE(ret.get_symbol_set() == symbol_set{"x", "y", "z"});
+
+        // Negative exponents.
+        const auto fm1 = obake::pow(f, -1);
+        REQUIRE(obake::get_truncation(fm1).index() == 1u);
+        REQUIRE(std::get<1>(obake::get_truncation(fm1)) == 8);
+        REQUIRE(fm1 * f == 1);
+        REQUIRE(obake::pow(f, -3) == fm1 * fm1 * fm1);
+        REQUIRE(obake::pow(f, -3) * f * f * f == 1);
+
+        // The degree of the result is bounded for
+        // non-negative integral exponents.
+        auto [a, b] = make_p_series_t<ps_q_t>(1000000, "a", "b");
+        REQUIRE(obake::pow(1 + a - b, 3) == (1 + a - b) * (1 + a - b) * (1 + a - b));
+    }
+
+    // FP coefficients, non-integral exponents.
+    {
+        auto [x, y] = make_p_series_t<ps_t>(10, "x", "y");
+
+        const auto f = 1 + x + y / 2 - x * y;
+
+        auto check_small = [](const ps_t &p) {
+            return std::all_of(p.begin(), p.end(), [](const auto &t) { return std::abs(t.second) < 1E-12; });
+        };
+
+        const auto r2 = obake::pow(f, .5);
+        REQUIRE(obake::get_truncation(r2).index() == 1u);
+        REQUIRE(std::get<1>(obake::get_truncation(r2)) == 10);
+        REQUIRE(check_small(r2 * r2 - f));
+
+        const auto r3 = obake::pow(f, 1. / 3);
+        REQUIRE(check_small(r3 * r3 * r3 - f));
+
+        const auto rm2 = obake::pow(f, -.5);
+        REQUIRE(check_small(rm2 * r2 - 1));
+
+        // Check the first few coefficients of (1 + x)**.5.
+        const auto s = obake::pow(1 + x, .5);
+        REQUIRE(s.size() == 11u);
+        for (const auto &t : s) {
+            if (t.first == pm_t{0, 0}) {
+                REQUIRE(t.second == 1);
+            } else if (t.first == pm_t{1, 0}) {
+                REQUIRE(t.second == .5);
+            } else if (t.first == pm_t{2, 0}) {
+                REQUIRE(t.second == -.125);
+            } else if (t.first == pm_t{3, 0}) {
+                REQUIRE(t.second == 1. / 16);
+            }
+        }
+    }
+
+    // Integral coefficients.
+    {
+        using ps_z_t = p_series<pm_t, mppp::integer<1>>;
+
+        auto [x, y] = make_p_series_t<ps_z_t>(6, "x", "y");
+
+        // Non-negative integral exponents.
+        const auto f = 2 + x - 3 * y;
+        REQUIRE(obake::pow(f, 4) == f * f * f * f);
+
+        // Negative exponents with unitary constant term.
+        const auto g = 1 + x - 3 * y;
+        const auto gm1 = obake::pow(g, -1);
+        REQUIRE(gm1 * g == 1);
+        REQUIRE(obake::pow(-1 + x * y, -2) * (-1 + x * y) * (-1 + x * y) == 1);
+
+        // The reciprocal of 2 + x has non-integral
+        // coefficients and it cannot be computed.
+        REQUIRE_THROWS_AS(obake::pow(2 + x, -1), std::invalid_argument);
+        REQUIRE_THROWS_AS(obake::pow(f, -2), std::invalid_argument);
+    }
+
+    // Cases in which the recurrence cannot be used.
+    {
+        auto [x, y] = make_p_series_t<ps_t>(4, "x", "y");
+
+        // No constant term.
+        REQUIRE_THROWS_AS(obake::pow(x + y, -1), std::invalid_argument);
+
+        // Terms with negative degree.
+        REQUIRE_THROWS_AS(obake::pow(1 + x + obake::pow(y, -1), -1), std::invalid_argument);
+
+        // Partial degree truncation.
+        auto [a, b] = make_p_series_p<ps_t>(4, symbol_set{"a"}, "a", "b");
+        REQUIRE_THROWS_AS(obake::pow(1 + a + b, -1), std::invalid_argument);
+
+        // No truncation.
+        auto [c, d] = make_p_series<ps_t>("c", "d");
+        REQUIRE_THROWS_AS(obake::pow(1 + c + d, -1), std::invalid_argument);
+    }
+}
+
+TEST_CASE("newton")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using ps_t = p_series<pm_t, double>;
+    using ps_q_t = p_series<pm_t, mppp::rational<1>>;
+    using q_t = mppp::rational<1>;
+
+    auto check_small = [](const ps_t &p) {
+        return std::all_of(p.begin(), p.end(), [](const auto &t) { return std::abs(t.second) < 1E-10; });
+    };
+
+    auto check_trunc = [](const auto &p, int n) {
+        return obake::get_truncation(p).index() == 1u && std::get<1>(obake::get_truncation(p)) == n;
+    };
+
+    // FP coefficients.
+    for (auto n : {0, 1, 2, 5, 10, 17}) {
+        auto [x, y, z] = make_p_series_t<ps_t>(n, "x", "y", "z");
+
+        const auto f = 1 + x + y / 2 - x * y + z * z * z;
+        const auto f2 = 4 + x - y * z / 3 + x * y * y;
+
+        // Reciprocal.
+        auto ret = p_series_inv(f);
+        REQUIRE(check_trunc(ret, n));
+        REQUIRE(check_small(ret * f - 1));
+        REQUIRE(check_small(p_series_inv(f2) * f2 - 1));
+        REQUIRE(check_small(p_series_inv(f2) - obake::pow(f2, -1)));
+
+        // Square root.
+        ret = p_series_sqrt(f);
+        REQUIRE(check_trunc(ret, n));
+        REQUIRE(check_small(ret * ret - f));
+        ret = p_series_sqrt(f2);
+        REQUIRE(check_small(ret * ret - f2));
+
+        // Logarithm and exponential.
+        ret = p_series_log(f);
+        REQUIRE(check_trunc(ret, n));
+        REQUIRE(check_small(p_series_exp(ret) - f));
+        REQUIRE(check_small(p_series_exp(p_series_log(f2)) - f2));
+
+        ret = p_series_exp(f - 1);
+        REQUIRE(check_trunc(ret, n));
+        REQUIRE(check_small(p_series_log(ret) - (f - 1)));
+        REQUIRE(check_small(p_series_log(p_series_exp(f2)) - f2));
+
+        // exp() of a series without constant term.
+        ret = p_series_exp(x);
+        REQUIRE(ret.size() == static_cast<decltype(ret.size())>(n + 1));
+        double fact = 1;
+        for (auto i = 0; i <= n; ++i) {
+            fact *= (i == 0 ? 1 : i);
+            const auto it
+                = std::find_if(ret.begin(), ret.end(), [i](const auto &t) { return t.first == pm_t{i, 0, 0}; });
+            REQUIRE(it != ret.end());
+            REQUIRE(std::abs(it->second - 1 / fact) < 1E-15);
+        }
+    }
+
+    // Rational coefficients: the results are exact.
+    {
+        auto [x, y] = make_p_series_t<ps_q_t>(9, "x", "y");
+
+        const auto f = 1 + x - q_t{2, 3} * y + 5 * x * y;
+
+        REQUIRE(p_series_inv(f) * f == 1);
+        REQUIRE(p_series_inv(2 * f) * f == q_t{1, 2});
+        REQUIRE(p_series_sqrt(f) * p_series_sqrt(f) == f);
+        REQUIRE(p_series_exp(p_series_log(f)) == f);
+        REQUIRE(p_series_log(p_series_exp(f - 1)) == f - 1);
+
+        // The elementary functions of the constant
+        // terms are not available.
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_sqrt(f + 1), std::invalid_argument,
+                                       "Cannot compute the square root of the constant term of a power series");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_log(f + 1), std::invalid_argument,
+                                       "Cannot compute the logarithm of the constant term of a power series");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_exp(f), std::invalid_argument,
+                                       "Cannot compute the exponential of the constant term of a power series");
+    }
+
+    // Error handling.
+    {
+        auto [x, y] = make_p_series_t<ps_t>(4, "x", "y");
+        auto [a, b] = make_p_series<ps_t>("a", "b");
+        auto [c, d] = make_p_series_p<ps_t>(4, symbol_set{"c"}, "c", "d");
+
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_inv(1 + a + b), std::invalid_argument,
+                                       "The function p_series_inv() requires a power series with "
+                                       "total degree truncation");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_exp(1 + c + d), std::invalid_argument,
+                                       "The function p_series_exp() requires a power series with "
+                                       "total degree truncation");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_inv(x + y), std::invalid_argument,
+                                       "The function p_series_inv() requires a power series with "
+                                       "a nonzero constant term");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_sqrt(x + y), std::invalid_argument,
+                                       "The function p_series_sqrt() requires a power series with "
+                                       "a nonzero constant term");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_log(x + y), std::invalid_argument,
+                                       "The function p_series_log() requires a power series with "
+                                       "a nonzero constant term");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_log(1 + x + obake::pow(y, -1)), std::invalid_argument,
+                                       "The function p_series_log() requires a power series whose terms have "
+                                       "non-negative degrees, and whose terms of zero degree are constants");
+        OBAKE_REQUIRES_THROWS_CONTAINS(p_series_exp(x * obake::pow(y, -1)), std::invalid_argument,
+                                       "The function p_series_exp() requires a power series whose terms have "
+                                       "non-negative degrees, and whose terms of zero degree are constants");
+    }
+
+    // Integral coefficients are not supported.
+    REQUIRE(std::is_invocable_v<decltype(p_series_inv), const ps_q_t &>);
+    REQUIRE(!std::is_invocable_v<decltype(p_series_inv), const p_series<pm_t, int> &>);
+    REQUIRE(!std::is_invocable_v<decltype(p_series_sqrt), const p_series<pm_t, mppp::integer<1>> &>);
+    REQUIRE(!std::is_invocable_v<decltype(p_series_exp), const p_series<pm_t, mppp::integer<1>> &>);
+    REQUIRE(!std::is_invocable_v<decltype(p_series_log), const p_series<pm_t, long> &>);
+}
+
 // Check that trimming preserves the tag.
 TEST_CASE("trim")
 {
@@ -1240,6 +1480,117 @@ TEST_CASE("integrate")
         REQUIRE(obake::get_truncation(ret).index() == 2u);
         REQUIRE(std::get<2>(obake::get_truncation(ret)) == std::pair{std::int32_t(4), symbol_set{"x", "z"}});
     }
+
+    // Segmented input.
+    {
+        auto [x, y, z] = make_p_series_t<ps_t>(10, "x", "y", "z");
+
+        auto orig = obake::pow(x + y + z + 1, 10);
+
+        const auto orig16 = obake_test::make_segmented(orig, 4);
+
+        auto ret = obake::integrate(orig16, "x");
+
+        REQUIRE(ret == obake::integrate(orig, "x"));
+        REQUIRE(obake::degree(ret) <= 10);
+        REQUIRE(obake::get_truncation(ret).index() == 1u);
+        REQUIRE(std::get<1>(obake::get_truncation(ret)) == 10);
+
+        ret = obake::diff(orig16, "y");
+        REQUIRE(ret == obake::diff(orig, "y"));
+        REQUIRE(obake::get_truncation(ret).index() == 1u);
+    }
+}
+
+TEST_CASE("fma3")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using ps_t = p_series<pm_t, double>;
+
+    REQUIRE(is_mult_addable_v<ps_t &, const ps_t &, const ps_t &>);
+    REQUIRE(!is_mult_addable_v<const ps_t &, const ps_t &, const ps_t &>);
+
+    // No truncation.
+    {
+        auto [x, y, z] = make_p_series<ps_t>("x", "y", "z");
+
+        const auto a = obake::pow(x + y + z + 1, 4);
+        const auto b = a - 2. * x;
+
+        auto acc = x * y - 1.;
+        const auto expected = acc + a * b;
+        obake::fma3(acc, a, b);
+        REQUIRE(acc == expected);
+        REQUIRE(get_truncation(acc).index() == 0u);
+
+        // Cancellation.
+        acc = -(a * b);
+        obake::fma3(acc, a, b);
+        REQUIRE(acc.empty());
+    }
+
+    // Total degree truncation.
+    {
+        auto [x, y, z] = make_p_series_t<ps_t>(5, "x", "y", "z");
+
+        const auto a = obake::pow(x + y + z + 1, 4);
+        const auto b = a - 2. * x;
+
+        auto acc = x * y - 1.;
+        const auto expected = acc + a * b;
+        obake::fma3(acc, a, b);
+        REQUIRE(acc == expected);
+        REQUIRE(obake::degree(acc) <= 5);
+        REQUIRE(get_truncation(acc).index() == 1u);
+        REQUIRE(std::get<1>(get_truncation(acc)) == 5);
+
+        // Squaring and aliasing.
+        auto acc2 = acc;
+        const auto expected2 = acc + a * a;
+        obake::fma3(acc, a, a);
+        REQUIRE(acc == expected2);
+        const auto expected3 = acc2 + acc2 * b;
+        obake::fma3(acc2, acc2, b);
+        REQUIRE(acc2 == expected3);
+    }
+
+    // Partial degree truncation.
+    {
+        auto [x, y, z] = make_p_series_p<ps_t>(3, symbol_set{"x", "y"}, "x", "y", "z");
+
+        const auto a = obake::pow(x + y + z + 1, 4);
+        const auto b = a - 2. * x;
+
+        auto acc = x * z - 1.;
+        const auto expected = acc + a * b;
+        obake::fma3(acc, a, b);
+        REQUIRE(acc == expected);
+        REQUIRE(obake::p_degree(acc, symbol_set{"x", "y"}) <= 3);
+        REQUIRE(get_truncation(acc).index() == 2u);
+    }
+
+    // Different truncations: fall back to acc += x * y.
+    {
+        auto [x, y] = make_p_series_t<ps_t>(3, "x", "y");
+
+        ps_t acc;
+        obake::fma3(acc, x + 1., y - 1.);
+        REQUIRE(acc == (x + 1.) * (y - 1.));
+        REQUIRE(get_truncation(acc).index() == 1u);
+        REQUIRE(std::get<1>(get_truncation(acc)) == 3);
+    }
+    {
+        auto [x] = make_p_series_t<ps_t>(3, "x");
+        auto [y] = make_p_series_t<ps_t>(2, "y");
+
+        // NOTE: the error is detected before
+        // acc is modified, acc is left unchanged.
+        auto acc = x + 1.;
+        OBAKE_REQUIRES_THROWS_CONTAINS(obake::fma3(acc, x, y), std::invalid_argument,
+                                       "Unable to multiply two power series if their truncation levels do not match");
+        REQUIRE(acc == x + 1.);
+        REQUIRE(acc.get_symbol_set() == symbol_set{"x"});
+    }
 }
 
 // Check the fmt formatter specialisation.
@@ -854,3 +854,59 @@ TEST_CASE("series_in_place_sub_custom")
     REQUIRE(is_in_place_subtractable_v<s2_t &, const s2_t &>);
     REQUIRE(!is_in_place_subtractable_v<s2a_t &, const s2a_t &>);
 }
+
+TEST_CASE("series_in_place_add_sub_segmented")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using s1_t = polynomial<pm_t, rat_t>;
+
+    // Build a series with the terms x**i * y**j, i in [i0, i1), j in [0, nj),
+    // with coefficients sign * (i + j + 1) and the given segmentation.
+    auto make_s = [](int i0, int i1, int nj, int sign, unsigned log2_segs) {
+        s1_t retval;
+        retval.set_symbol_set(symbol_set{"x", "y"});
+        retval.set_n_segments(log2_segs);
+        for (auto i = i0; i < i1; ++i) {
+            for (auto j = 0; j < nj; ++j) {
+                retval.add_term(pm_t{i, j}, sign * (i + j + 1));
+            }
+        }
+        return retval;
+    };
+
+    // Test both below and above the parallel threshold.
+    for (auto nj : {2, 200}) {
+        // The reference results, computed with non-segmented series.
+        auto ref_add = make_s(0, 300, nj, 1, 0);
+        ref_add += make_s(100, 400, nj, -1, 0);
+        auto ref_sub = make_s(0, 300, nj, 1, 0);
+        ref_sub -= make_s(100, 400, nj, 1, 0);
+
+        // Some cancellations must have taken place.
+        REQUIRE(ref_add.size() == static_cast<s1_t::size_type>(200 * nj));
+        REQUIRE(ref_sub.size() == static_cast<s1_t::size_type>(200 * nj));
+
+        const std::vector<std::pair<unsigned, unsigned>> segs{{1, 1}, {2, 2}, {2, 4}, {4, 2}, {3, 0}};
+
+        for (auto [l_segs, r_segs] : segs) {
+            auto a = make_s(0, 300, nj, 1, l_segs);
+            const auto b = make_s(100, 400, nj, -1, r_segs);
+            a += b;
+            REQUIRE(a == ref_add);
+            REQUIRE(a.get_s_size() == l_segs);
+
+            // Move semantics.
+            a = make_s(0, 300, nj, 1, l_segs);
+            a += make_s(100, 400, nj, -1, r_segs);
+            REQUIRE(a == ref_add);
+
+            a = make_s(0, 300, nj, 1, l_segs);
+            a -= make_s(100, 400, nj, 1, r_segs);
+            REQUIRE(a == ref_sub);
+
+            // Self subtraction.
+            a -= a;
+            REQUIRE(a.empty());
+        }
+    }
+}
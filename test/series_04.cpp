@@ -6,20 +6,27 @@
 // Public License v. 2.0. If a copy of the MPL was not distributed
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <initializer_list>
+#include <limits>
+#include <random>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <fmt/core.h>
 
 #include <mp++/integer.hpp>
 #include <mp++/rational.hpp>
 
-#include <obake/detail/ignore.hpp>
+#include <obake/kpack.hpp>
 #include <obake/math/evaluate.hpp>
 #include <obake/math/pow.hpp>
 #include <obake/math/trim.hpp>
@@ -36,6 +43,8 @@ using rat_t = mppp::rational<1>;
 
 using namespace obake;
 
+static std::mt19937 rng;
+
 struct tag {
 };
 
@@ -110,14 +119,318 @@ TEST_CASE("series_pow_test")
               "series/coefficient types do not support the necessary operations)");
 
     // Test clearing of the cache.
-    auto [map, _] = customisation::internal::get_series_pow_map();
-    detail::ignore(_);
+    REQUIRE(customisation::internal::series_pow_map_size() > 0u);
+
+    customisation::internal::clear_series_pow_map();
+
+    REQUIRE(customisation::internal::series_pow_map_size() == 0u);
+}
 
-    REQUIRE(!map.empty());
+TEST_CASE("series_pow_cache_mt_test")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using p1_t = polynomial<pm_t, rat_t>;
+
+    auto impl = [](auto &&a, auto &&b) {
+        return customisation::internal::pow(customisation::internal::pow_t{}, std::forward<decltype(a)>(a),
+                                            std::forward<decltype(b)>(b));
+    };
+
+    auto [x, y, z] = make_polynomials<p1_t>("x", "y", "z");
 
     customisation::internal::clear_series_pow_map();
 
-    REQUIRE(map.empty());
+    // A few bases, and their powers computed
+    // via repeated multiplications.
+    const std::vector<p1_t> bases{x - y, x + y + z, x * y - 2 * z, rat_t{1, 2} * x - z + 1};
+    std::vector<std::vector<p1_t>> cmp;
+    for (const auto &b : bases) {
+        cmp.emplace_back();
+        cmp.back().emplace_back(1);
+        for (auto i = 1; i <= 10; ++i) {
+            cmp.back().push_back(cmp.back().back() * b);
+        }
+    }
+
+    // Request concurrently the powers of the bases from
+    // multiple threads, in different orders.
+    std::atomic<bool> ok(true);
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < 8u; ++t) {
+        threads.emplace_back([&, t]() {
+            for (auto i = 0u; i <= 10u; ++i) {
+                const auto e = t % 2u == 0u ? i : 10u - i;
+                for (decltype(bases.size()) j = 0; j < bases.size(); ++j) {
+                    const auto &b = bases[(j + t) % bases.size()];
+                    if (impl(b, e) != cmp[(j + t) % bases.size()][e]) {
+                        ok.store(false);
+                    }
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    REQUIRE(ok.load());
+    REQUIRE(customisation::internal::series_pow_map_size() == bases.size());
+
+    customisation::internal::clear_series_pow_map();
+    REQUIRE(customisation::internal::series_pow_map_size() == 0u);
+
+    // The cache must keep working after clearing.
+    REQUIRE(impl(bases[0], 3) == cmp[0][3]);
+    REQUIRE(customisation::internal::series_pow_map_size() == 1u);
+
+    // Failed computations must not leave
+    // stale powers in the cache.
+    const auto lim = detail::kpack_get_lims<std::int32_t>(3).second;
+    p1_t ob;
+    ob.set_symbol_set(symbol_set{"x", "y", "z"});
+    ob.add_term(pm_t{lim / 2 + 1, 1, 0}, 1);
+    ob.add_term(pm_t{0, 0, 1}, 1);
+
+    for (auto k = 0; k < 2; ++k) {
+        REQUIRE(impl(ob, 1) == ob);
+        REQUIRE_THROWS_AS(impl(ob, 3), std::overflow_error);
+        REQUIRE_THROWS_AS(impl(ob, 2), std::overflow_error);
+    }
+
+    threads.clear();
+    std::atomic<int> n_fails(0);
+    for (auto t = 0u; t < 8u; ++t) {
+        threads.emplace_back([&, t]() {
+            try {
+                impl(ob, 2u + t % 4u);
+            } catch (const std::overflow_error &) {
+                ++n_fails;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    REQUIRE(n_fails.load() == 8);
+    REQUIRE(impl(ob, 1) == ob);
+    REQUIRE_THROWS_AS(impl(ob, 2), std::overflow_error);
+}
+
+TEST_CASE("series_pow_cache_stats_test")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using p1_t = polynomial<pm_t, rat_t>;
+    using p2_t = polynomial<pm_t, mppp::integer<1>>;
+
+    auto impl = [](auto &&a, auto &&b) {
+        return customisation::internal::pow(customisation::internal::pow_t{}, std::forward<decltype(a)>(a),
+                                            std::forward<decltype(b)>(b));
+    };
+
+    auto [x, y, z] = make_polynomials<p1_t>("x", "y", "z");
+    auto [a, b] = make_polynomials<p2_t>("a", "b");
+
+    REQUIRE(get_pow_cache_max_bytes() == std::numeric_limits<std::size_t>::max());
+
+    clear_pow_cache();
+
+    auto st = get_pow_cache_stats();
+    REQUIRE(st.n_bases == 0u);
+    REQUIRE(st.bytes == 0u);
+    REQUIRE(st.bytes_per_type.empty());
+    REQUIRE(st.max_bytes == std::numeric_limits<std::size_t>::max());
+
+    const auto hits0 = st.hits, misses0 = st.misses, evictions0 = st.evictions;
+
+    // Hits and misses.
+    REQUIRE(impl(x - y, 3) == (x - y) * (x - y) * (x - y));
+    REQUIRE(impl(x - y, 2) == (x - y) * (x - y));
+    REQUIRE(impl(x - y, 0) == 1);
+    REQUIRE(impl(x - y, 4) == (x - y) * (x - y) * (x - y) * (x - y));
+    REQUIRE(impl(a + b, 2) == (a + b) * (a + b));
+
+    // NOTE: the zero exponent is handled
+    // without looking into the cache.
+    st = get_pow_cache_stats();
+    REQUIRE(st.misses - misses0 == 3u);
+    REQUIRE(st.hits - hits0 == 1u);
+    REQUIRE(st.evictions == evictions0);
+    REQUIRE(st.n_bases == 2u);
+    REQUIRE(st.bytes_per_type.size() == 2u);
+    REQUIRE(st.bytes_per_type[type_name<p1_t>()] > 0u);
+    REQUIRE(st.bytes_per_type[type_name<p2_t>()] > 0u);
+    REQUIRE(st.bytes == st.bytes_per_type[type_name<p1_t>()] + st.bytes_per_type[type_name<p2_t>()]);
+    REQUIRE(st.bytes == customisation::internal::series_pow_cache_bytes.load());
+
+    // Lowering the capacity limit evicts the least recently used base.
+    const auto a_bytes = st.bytes_per_type[type_name<p2_t>()];
+    set_pow_cache_max_bytes(a_bytes);
+    REQUIRE(get_pow_cache_max_bytes() == a_bytes);
+
+    st = get_pow_cache_stats();
+    REQUIRE(st.evictions - evictions0 == 1u);
+    REQUIRE(st.n_bases == 1u);
+    REQUIRE(st.bytes == a_bytes);
+    REQUIRE(st.bytes_per_type.size() == 1u);
+    REQUIRE(st.bytes_per_type.count(type_name<p2_t>()) == 1u);
+
+    // The results are correct after eviction.
+    REQUIRE(impl(x - y, 4) == (x - y) * (x - y) * (x - y) * (x - y));
+
+    // A tight limit: the cache keeps only the base whose
+    // powers were computed last, and the results stay correct.
+    set_pow_cache_max_bytes(1);
+    REQUIRE(get_pow_cache_stats().n_bases == 0u);
+    REQUIRE(get_pow_cache_stats().bytes == 0u);
+
+    const std::vector<p1_t> bases{x - y, x + y + z, x * y - 2 * z};
+    for (auto i = 0; i < 3; ++i) {
+        for (const auto &bb : bases) {
+            REQUIRE(impl(bb, 5) == bb * bb * bb * bb * bb);
+        }
+    }
+    st = get_pow_cache_stats();
+    REQUIRE(st.n_bases == 1u);
+    REQUIRE(st.bytes > 0u);
+    REQUIRE(st.bytes_per_type.size() == 1u);
+    REQUIRE(st.evictions - evictions0 >= 11u);
+
+    // The powers of the last base are cached even
+    // if they exceed the capacity limit on their own.
+    const auto hits1 = st.hits;
+    REQUIRE(impl(bases.back(), 3) == bases.back() * bases.back() * bases.back());
+    REQUIRE(get_pow_cache_stats().hits == hits1 + 1u);
+    REQUIRE(get_pow_cache_stats().n_bases == 1u);
+
+    // Lowering the limit again evicts it.
+    set_pow_cache_max_bytes(1);
+    REQUIRE(get_pow_cache_stats().n_bases == 0u);
+    REQUIRE(get_pow_cache_stats().bytes == 0u);
+
+    // Restore the unlimited capacity.
+    set_pow_cache_max_bytes(std::numeric_limits<std::size_t>::max());
+
+    REQUIRE(impl(x - y, 2) == (x - y) * (x - y));
+    REQUIRE(get_pow_cache_stats().n_bases == 1u);
+
+    clear_pow_cache();
+
+    st = get_pow_cache_stats();
+    REQUIRE(st.n_bases == 0u);
+    REQUIRE(st.bytes == 0u);
+    REQUIRE(customisation::internal::series_pow_cache_bytes.load() == 0u);
+}
+
+TEST_CASE("series_pow_algo_test")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using p1_t = polynomial<pm_t, rat_t>;
+
+    auto impl = [](auto &&a, auto &&b) {
+        return customisation::internal::pow(customisation::internal::pow_t{}, std::forward<decltype(a)>(a),
+                                            std::forward<decltype(b)>(b));
+    };
+
+    auto [x, y, z] = make_polynomials<p1_t>("x", "y", "z");
+
+    REQUIRE(get_pow_algo() == pow_algo::linear);
+
+    REQUIRE(customisation::internal::series_pow_binary_n_mults(1) == 0u);
+    REQUIRE(customisation::internal::series_pow_binary_n_mults(2) == 1u);
+    REQUIRE(customisation::internal::series_pow_binary_n_mults(3) == 2u);
+    REQUIRE(customisation::internal::series_pow_binary_n_mults(8) == 3u);
+    REQUIRE(customisation::internal::series_pow_binary_n_mults(70) == 8u);
+
+    const std::vector<p1_t> bases{x - y, x + y + z, rat_t{1, 2} * x - z + 1};
+    std::vector<std::vector<p1_t>> cmp;
+    for (const auto &b : bases) {
+        cmp.emplace_back();
+        cmp.back().emplace_back(1);
+        for (auto i = 1; i <= 40; ++i) {
+            cmp.back().push_back(cmp.back().back() * b);
+        }
+    }
+
+    for (auto algo : {pow_algo::binary, pow_algo::automatic, pow_algo::linear}) {
+        set_pow_algo(algo);
+        REQUIRE(get_pow_algo() == algo);
+
+        clear_pow_cache();
+
+        // Request the powers in a scrambled order, so that
+        // both the contiguous and the sparse powers are reused.
+        for (decltype(bases.size()) j = 0; j < bases.size(); ++j) {
+            for (auto e : {0u, 40u, 3u, 17u, 40u, 1u, 2u, 33u, 5u, 21u, 4u, 17u, 39u}) {
+                REQUIRE(impl(bases[j], e) == cmp[j][e]);
+            }
+        }
+
+        REQUIRE(customisation::internal::series_pow_map_size() == bases.size());
+
+        // The mixed linear/binary computations from multiple threads.
+        clear_pow_cache();
+
+        std::atomic<bool> ok(true);
+        std::vector<std::thread> threads;
+        for (auto t = 0u; t < 4u; ++t) {
+            threads.emplace_back([&, t]() {
+                for (auto i = 0u; i <= 40u; i += 3u) {
+                    const auto e = t % 2u == 0u ? i : 40u - i;
+                    for (decltype(bases.size()) j = 0; j < bases.size(); ++j) {
+                        if (impl(bases[(j + t) % bases.size()], e) != cmp[(j + t) % bases.size()][e]) {
+                            ok.store(false);
+                        }
+                    }
+                }
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+
+        REQUIRE(ok.load());
+    }
+
+    // With the linear algorithm, a single request
+    // fills the cache with all the intermediate powers.
+    clear_pow_cache();
+    impl(bases[0], 10);
+    const auto lin_bytes = get_pow_cache_stats().bytes;
+
+    // With the binary algorithm, only the requested
+    // power is stored.
+    set_pow_algo(pow_algo::binary);
+    clear_pow_cache();
+    impl(bases[0], 10);
+    REQUIRE(get_pow_cache_stats().bytes < lin_bytes);
+
+    // When the contiguous sequence grows past a sparse
+    // power, the sparse power is moved into the sequence,
+    // rather than being computed and stored twice.
+    // NOTE: use a monomial base, so that the byte sizes
+    // of its powers do not depend on how they are computed.
+    const auto mb = rat_t{1, 2} * x * y;
+    set_pow_algo(pow_algo::linear);
+    clear_pow_cache();
+    impl(mb, 12);
+    const auto lin12_bytes = get_pow_cache_stats().bytes;
+
+    set_pow_algo(pow_algo::binary);
+    clear_pow_cache();
+    impl(mb, 10);
+    set_pow_algo(pow_algo::linear);
+    impl(mb, 12);
+    REQUIRE(get_pow_cache_stats().bytes == lin12_bytes);
+    p1_t mb_pow(1);
+    for (auto e = 0u; e <= 12u; ++e) {
+        REQUIRE(impl(mb, e) == mb_pow);
+        mb_pow *= mb;
+    }
+
+    // Restore the default.
+    set_pow_algo(pow_algo::linear);
+    clear_pow_cache();
 }
 
 TEST_CASE("series_evaluate_test")
@@ -201,6 +514,106 @@ TEST_CASE("series_evaluate_test")
         "contain all the symbols in the series' symbol set, {'x', 'y', 'z'}");
 }
 
+// Evaluation of large segmented series.
+TEST_CASE("series_evaluate_par_test")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using p1_t = polynomial<pm_t, rat_t>;
+
+    REQUIRE(!get_evaluate_compensated());
+
+    auto [x, y, z, t] = make_polynomials<p1_t>("x", "y", "z", "t");
+
+    auto tmp = obake::pow(1 + x + y + z + t, 16);
+    tmp *= tmp;
+
+    // Copy tmp into a polynomial with 16 segments
+    // and into a single-segment polynomial.
+    const auto p = obake_test::make_segmented(tmp, 4), p_ser = obake_test::make_segmented(tmp, 0);
+    REQUIRE(p.size() >= obake::detail::series_par_threshold);
+
+    // Exact evaluation.
+    const symbol_map<rat_t> sm_q{{"t", rat_t{1, 2}}, {"x", rat_t{-1, 3}}, {"y", rat_t{1, 4}}, {"z", rat_t{-1}}};
+    REQUIRE(evaluate(p, sm_q) == obake::pow(rat_t{5, 12}, 32));
+
+    // Floating-point evaluation, with and without
+    // compensated summation.
+    // NOTE: use positive values, so that the relative
+    // error is not amplified by cancellation.
+    const symbol_map<double> sm{{"t", .1}, {"x", .3}, {"y", .7}, {"z", .45}};
+    const symbol_map<rat_t> sm_rat{{"t", rat_t{.1}}, {"x", rat_t{.3}}, {"y", rat_t{.7}}, {"z", rat_t{.45}}};
+    const auto exact = static_cast<double>(evaluate(p, sm_rat));
+
+    const auto res = evaluate(p, sm);
+    REQUIRE(std::abs((res - exact) / exact) < 1E-6);
+    REQUIRE(evaluate(p, sm) == res);
+
+    set_evaluate_compensated(true);
+    REQUIRE(get_evaluate_compensated());
+
+    const auto res_comp = evaluate(p, sm);
+    REQUIRE(std::abs((res_comp - exact) / exact) < 1E-6);
+    REQUIRE(evaluate(p, sm) == res_comp);
+
+    // Non-floating-point evaluation is not affected.
+    REQUIRE(evaluate(p, sm_q) == obake::pow(rat_t{5, 12}, 32));
+
+    // Compensated summation in the serial case.
+    REQUIRE(std::abs((evaluate(p_ser, sm) - exact) / exact) < 1E-6);
+
+    set_evaluate_compensated(false);
+
+    // Heavy cancellation: terms of magnitude 2**60 and
+    // alternating sign, interleaved with unitary terms.
+    // When evaluating with all the variables set to 1,
+    // the terms are exact and the large terms cancel out,
+    // thus the exact result is the number of unitary terms.
+    // The naive summation loses the unitary terms accumulated
+    // onto a large partial sum.
+    // NOTE: shuffle the keys before assigning the coefficients,
+    // so that the iteration order of the series does not
+    // correlate with the signs of the terms.
+    REQUIRE(tmp.size() % 3u == 0u);
+    std::vector<pm_t> keys;
+    for (const auto &t : tmp) {
+        keys.push_back(t.first);
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    const auto big = obake::pow(rat_t{2}, 60);
+    p1_t tmp_c;
+    tmp_c.set_symbol_set(tmp.get_symbol_set());
+    for (decltype(keys.size()) i = 0; i < keys.size(); ++i) {
+        switch (i % 3u) {
+            case 0u:
+                tmp_c.add_term(keys[i], big);
+                break;
+            case 1u:
+                tmp_c.add_term(keys[i], -big);
+                break;
+            default:
+                tmp_c.add_term(keys[i], 1);
+        }
+    }
+
+    const auto p_c = obake_test::make_segmented(tmp_c, 4), p_c_ser = obake_test::make_segmented(tmp_c, 0);
+    REQUIRE(p_c.size() >= obake::detail::series_par_threshold);
+
+    const symbol_map<double> sm_one{{"t", 1.}, {"x", 1.}, {"y", 1.}, {"z", 1.}};
+    const auto exact_c = static_cast<double>(tmp.size() / 3u);
+    REQUIRE(evaluate(p_c, symbol_map<rat_t>{{"t", 1}, {"x", 1}, {"y", 1}, {"z", 1}}) == tmp.size() / 3u);
+
+    REQUIRE(std::abs((evaluate(p_c, sm_one) - exact_c) / exact_c) >= 1E-6);
+    REQUIRE(std::abs((evaluate(p_c_ser, sm_one) - exact_c) / exact_c) >= 1E-6);
+
+    set_evaluate_compensated(true);
+
+    REQUIRE(std::abs((evaluate(p_c, sm_one) - exact_c) / exact_c) < 1E-6);
+    REQUIRE(std::abs((evaluate(p_c_ser, sm_one) - exact_c) / exact_c) < 1E-6);
+
+    set_evaluate_compensated(false);
+}
+
 TEST_CASE("series_trim_test")
 {
     using pm_t = packed_monomial<std::int32_t>;
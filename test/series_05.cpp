@@ -23,11 +23,13 @@
 #include <obake/polynomials/packed_monomial.hpp>
 #include <obake/polynomials/polynomial.hpp>
 #include <obake/s11n.hpp>
+#include <obake/series.hpp>
 #include <obake/symbols.hpp>
 #include <obake/tex_stream_insert.hpp>
 #include <obake/type_traits.hpp>
 
 #include "catch.hpp"
+#include "test_utils.hpp"
 
 using int_t = mppp::integer<1>;
 using rat_t = mppp::rational<1>;
@@ -251,6 +253,38 @@ TEST_CASE("series_add_symbols_test")
     REQUIRE(is_detected_v<add_symbols_t, const p1_t &>);
 }
 
+TEST_CASE("series_sym_extender_par_test")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using p1_t = polynomial<pm_t, rat_t>;
+
+    auto [x, y, z] = make_polynomials<p1_t>("x", "y", "z");
+
+    const auto tmp = obake::pow(1 + x, 39) * obake::pow(1 + y, 39) * obake::pow(1 + z, 39);
+
+    // Large segmented series and its
+    // non-segmented counterpart.
+    const auto p = obake_test::make_segmented(tmp, 3), q = obake_test::make_segmented(tmp, 0);
+    REQUIRE(p.size() >= obake::detail::series_par_threshold);
+
+    // NOTE: extend by a single symbol in the middle of
+    // the symbol set, so that the exponents remain within
+    // the packing limits.
+    const auto pe = add_symbols(p, symbol_set{"y0"});
+    REQUIRE(pe.get_symbol_set() == symbol_set{"x", "y", "y0", "z"});
+    REQUIRE(pe.get_s_size() == 3u);
+    REQUIRE(pe.size() == p.size());
+    REQUIRE(pe == add_symbols(q, symbol_set{"y0"}));
+
+    // Extension in a binary operation, with move semantics.
+    auto [t] = make_polynomials<p1_t>("t");
+    auto p2(p);
+    const auto r = std::move(p2) + t;
+    REQUIRE(r == q + t);
+    REQUIRE(r.get_symbol_set() == symbol_set{"t", "x", "y", "z"});
+    REQUIRE(r.size() == p.size() + 1u);
+}
+
 #if !defined(_MSC_VER) || defined(__clang__)
 
 TEST_CASE("series_s11n_test")
@@ -157,6 +157,71 @@ TEST_CASE("series_div")
     REQUIRE(!is_in_place_divisible_v<int &, const s1_t &>);
 }
 
+TEST_CASE("series_in_place_mul_div")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using s1_t = polynomial<pm_t, rat_t>;
+    using s11_t = polynomial<pm_t, s1_t>;
+    using s2_t = polynomial<pm_t, double>;
+
+    REQUIRE(std::is_same_v<s1_t &, decltype(std::declval<s1_t &>() *= 3)>);
+    REQUIRE(std::is_same_v<s1_t &, decltype(std::declval<s1_t &>() /= 3)>);
+    REQUIRE(std::is_same_v<s11_t &, decltype(std::declval<s11_t &>() *= std::declval<const s1_t &>())>);
+
+    auto [t, x, y] = make_polynomials<s1_t>("t", "x", "y");
+    auto [z] = make_polynomials<s11_t>("z");
+
+    // Large segmented series.
+    const auto tmp = obake::pow(1 + t, 39) * obake::pow(1 + x, 39) * obake::pow(1 + y, 39);
+    const auto p = obake_test::make_segmented(tmp, 3);
+    REQUIRE(p.size() >= obake::detail::series_par_threshold);
+
+    // Floating-point counterpart, in which the terms
+    // of odd degree have tiny coefficients.
+    s2_t tmp_d;
+    tmp_d.set_symbol_set(tmp.get_symbol_set());
+    for (const auto &term : tmp) {
+        tmp_d.add_term(term.first, obake::key_degree(term.first, tmp.get_symbol_set()) % 2 == 0 ? 1. : 1E-300);
+    }
+    const auto pd = obake_test::make_segmented(tmp_d, 3);
+
+    auto q(p);
+    q *= rat_t{3, 2};
+    REQUIRE(q == p * rat_t{3, 2});
+    REQUIRE(q.get_s_size() == 3u);
+    q /= rat_t{3, 2};
+    REQUIRE(q == p);
+    REQUIRE(q.get_s_size() == 3u);
+
+    q *= 0;
+    REQUIRE(q.empty());
+    REQUIRE(q.get_symbol_set() == symbol_set{"t", "x", "y"});
+
+    // Zero pruning via underflow.
+    auto qd(pd);
+    qd *= 1E-300;
+    REQUIRE(qd == pd * 1E-300);
+    REQUIRE(qd.size() == pd.size() / 2u);
+    qd = pd;
+    qd /= 1E300;
+    REQUIRE(qd == pd / 1E300);
+    REQUIRE(qd.size() == pd.size() / 2u);
+
+    // Operand which is a coefficient of the series.
+    q = 2 * x + 2 * y;
+    q /= q.begin()->second;
+    REQUIRE(q == x + y);
+    q = 3 * x + 3 * y;
+    q *= q.begin()->second;
+    REQUIRE(q == 9 * x + 9 * y);
+
+    // Lower-rank series operand.
+    auto w = (x + y) * z + 3;
+    const auto w_ref = w * (x - y);
+    w *= x - y;
+    REQUIRE(w == w_ref);
+}
+
 struct tag {
 };
 
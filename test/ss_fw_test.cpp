@@ -8,11 +8,13 @@
 
 #include <string>
 
+#include <obake/detail/fw_utils.hpp>
 #include <obake/symbols.hpp>
 
 #include "catch.hpp"
 
 std::string *get_test_address();
+obake::detail::ss_fw get_test_ss_fw(bool);
 
 using namespace obake;
 
@@ -22,3 +24,25 @@ TEST_CASE("ss fw storage address")
 
     REQUIRE(get_test_address() == &detail::fw_holder_class<std::string>::get());
 }
+
+TEST_CASE("ss fw interning")
+{
+    // The symbol sets interned in the library and in
+    // the executable must be stored at the same address.
+    const auto fw_lib = get_test_ss_fw(false);
+    const detail::ss_fw fw_exe{symbol_set{"x", "y", "z"}};
+
+    REQUIRE(fw_lib == fw_exe);
+    REQUIRE(&fw_lib.get() == &fw_exe.get());
+    REQUIRE(fw_lib.get() == symbol_set{"x", "y", "z"});
+
+    // Same for the empty symbol set.
+    const auto efw_lib = get_test_ss_fw(true);
+    const detail::ss_fw efw_exe;
+
+    REQUIRE(efw_lib == efw_exe);
+    REQUIRE(&efw_lib.get() == &efw_exe.get());
+    REQUIRE(efw_lib.get().empty());
+
+    REQUIRE(fw_lib != efw_exe);
+}
@@ -8,6 +8,7 @@
 
 #include <string>
 
+#include <obake/detail/fw_utils.hpp>
 #include <obake/symbols.hpp>
 
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -19,3 +20,17 @@ __attribute__((visibility("default")))
 {
     return &::obake::detail::fw_holder_class<std::string>::get();
 }
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+__declspec(dllexport)
+#elif defined(__clang__) || defined(__GNUC__)
+__attribute__((visibility("default")))
+#endif
+    ::obake::detail::ss_fw get_test_ss_fw(bool empty)
+{
+    if (empty) {
+        return ::obake::detail::ss_fw{};
+    }
+
+    return ::obake::detail::ss_fw{::obake::symbol_set{"x", "y", "z"}};
+}
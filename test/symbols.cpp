@@ -6,9 +6,13 @@
 // Public License v. 2.0. If a copy of the MPL was not distributed
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <atomic>
 #include <initializer_list>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <tuple>
+#include <vector>
 
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
@@ -110,6 +114,105 @@ TEST_CASE("merge_symbol_sets_test")
     REQUIRE((std::get<2>(ret) == symbol_idx_map<symbol_set>{{1, {"b"}}, {6, {"n"}}, {7, {"t"}}}));
 }
 
+TEST_CASE("merge_symbol_sets_fw_test")
+{
+    detail::clear_ss_merge_cache();
+
+    auto stats = detail::get_ss_merge_cache_stats();
+    REQUIRE(stats.n_hits == 0u);
+    REQUIRE(stats.n_misses == 0u);
+    REQUIRE(stats.size == 0u);
+
+    const detail::ss_fw s1(symbol_set{"b", "c", "e"}), s2(symbol_set{"a", "c", "d", "f", "g"});
+
+    auto ret = detail::merge_symbol_sets_fw(s1, s2);
+    REQUIRE((std::get<0>(*ret).get() == symbol_set{"a", "b", "c", "d", "e", "f", "g"}));
+    REQUIRE((std::get<1>(*ret) == symbol_idx_map<symbol_set>{{0, {"a"}}, {2, {"d"}}, {3, {"f", "g"}}}));
+    REQUIRE((std::get<2>(*ret) == symbol_idx_map<symbol_set>{{1, {"b"}}, {3, {"e"}}}));
+
+    stats = detail::get_ss_merge_cache_stats();
+    REQUIRE(stats.n_hits == 0u);
+    REQUIRE(stats.n_misses == 1u);
+    REQUIRE(stats.size == 1u);
+
+    // Repeat the operation, with flyweights
+    // constructed independently.
+    auto ret2 = detail::merge_symbol_sets_fw(detail::ss_fw(symbol_set{"b", "c", "e"}), s2);
+    REQUIRE(ret2 == ret);
+
+    stats = detail::get_ss_merge_cache_stats();
+    REQUIRE(stats.n_hits == 1u);
+    REQUIRE(stats.n_misses == 1u);
+    REQUIRE(stats.size == 1u);
+
+    // The order of the arguments matters.
+    ret2 = detail::merge_symbol_sets_fw(s2, s1);
+    REQUIRE((std::get<0>(*ret2).get() == symbol_set{"a", "b", "c", "d", "e", "f", "g"}));
+    REQUIRE((std::get<1>(*ret2) == symbol_idx_map<symbol_set>{{1, {"b"}}, {3, {"e"}}}));
+    REQUIRE((std::get<2>(*ret2) == symbol_idx_map<symbol_set>{{0, {"a"}}, {2, {"d"}}, {3, {"f", "g"}}}));
+
+    stats = detail::get_ss_merge_cache_stats();
+    REQUIRE(stats.n_hits == 1u);
+    REQUIRE(stats.n_misses == 2u);
+    REQUIRE(stats.size == 2u);
+
+    // The results survive the clearing of the cache.
+    detail::clear_ss_merge_cache();
+    stats = detail::get_ss_merge_cache_stats();
+    REQUIRE(stats.n_hits == 0u);
+    REQUIRE(stats.n_misses == 0u);
+    REQUIRE(stats.size == 0u);
+    REQUIRE((std::get<0>(*ret).get() == symbol_set{"a", "b", "c", "d", "e", "f", "g"}));
+
+    // Concurrent access.
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([&s1, &s2, &failed]() {
+            for (auto j = 0; j < 100; ++j) {
+                const auto r = detail::merge_symbol_sets_fw(s1, s2);
+                if (std::get<0>(*r).get() != symbol_set{"a", "b", "c", "d", "e", "f", "g"}) {
+                    failed.store(true);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    REQUIRE(!failed.load());
+
+    stats = detail::get_ss_merge_cache_stats();
+    REQUIRE(stats.n_hits + stats.n_misses == 400u);
+    REQUIRE(stats.size == 1u);
+
+    // Eviction.
+    detail::clear_ss_merge_cache();
+    std::vector<detail::ss_fw> fws;
+    for (auto i = 0; i < 2000; ++i) {
+        fws.emplace_back(symbol_set{"x_" + std::to_string(i)});
+    }
+    for (const auto &fw : fws) {
+        const auto r = detail::merge_symbol_sets_fw(s1, fw);
+        REQUIRE(std::get<0>(*r).get().size() == 4u);
+    }
+    stats = detail::get_ss_merge_cache_stats();
+    REQUIRE(stats.n_hits == 0u);
+    REQUIRE(stats.n_misses == 2000u);
+    REQUIRE(stats.size > 0u);
+    REQUIRE(stats.size <= 1024u);
+
+    // A recently-used entry survives the eviction
+    // of the other entries in the cache.
+    detail::clear_ss_merge_cache();
+    ret = detail::merge_symbol_sets_fw(s1, s2);
+    for (const auto &fw : fws) {
+        detail::merge_symbol_sets_fw(s1, s2);
+        detail::merge_symbol_sets_fw(s1, fw);
+    }
+    REQUIRE(detail::merge_symbol_sets_fw(s1, s2) == ret);
+}
+
 TEST_CASE("ss_intersect_idx_test")
 {
     REQUIRE(detail::ss_intersect_idx(symbol_set{}, symbol_set{}).size() == 0u);
@@ -227,4 +330,61 @@ TEST_CASE("ss fw")
 
     REQUIRE(&ssfw1.get() == &ssfw2.get());
     REQUIRE(&ssfw2.get() == &ssfw3.get());
+    REQUIRE(ssfw1 == ssfw2);
+    REQUIRE(ssfw1.get() == symbol_set{"x", "y", "z"});
+
+    // Default construction.
+    REQUIRE(detail::ss_fw{}.get().empty());
+    REQUIRE(detail::ss_fw{} == detail::ss_fw{});
+    REQUIRE(detail::ss_fw{} == detail::ss_fw(symbol_set{}));
+    REQUIRE(detail::ss_fw{} != ssfw1);
+
+    // Copy/move semantics.
+    detail::ss_fw ssfw4(symbol_set{"a"});
+    REQUIRE(ssfw4 != ssfw1);
+    auto ssfw5(ssfw4);
+    REQUIRE(ssfw5 == ssfw4);
+    auto ssfw6(std::move(ssfw5));
+    REQUIRE(ssfw6 == ssfw4);
+    REQUIRE(ssfw5.get() == symbol_set{"a"});
+    ssfw6 = ssfw1;
+    REQUIRE(ssfw6 == ssfw1);
+    ssfw6 = std::move(ssfw4);
+    REQUIRE(ssfw6.get() == symbol_set{"a"});
+    REQUIRE(ssfw4.get() == symbol_set{"x", "y", "z"});
+    ssfw6 = symbol_set{"b", "c"};
+    REQUIRE(ssfw6.get() == symbol_set{"b", "c"});
+    swap(ssfw6, ssfw1);
+    REQUIRE(ssfw1.get() == symbol_set{"b", "c"});
+    REQUIRE(ssfw6.get() == symbol_set{"x", "y", "z"});
+
+    // Symbol sets which are not in use any more
+    // can be interned again.
+    for (auto i = 0; i < 100; ++i) {
+        REQUIRE(detail::ss_fw(symbol_set{"q", std::to_string(i)}).get() == symbol_set{"q", std::to_string(i)});
+    }
+
+    // Concurrent interning. Some of the symbol sets are kept
+    // alive by this thread, the others are repeatedly
+    // created and destroyed.
+    const detail::ss_fw held(symbol_set{"h0", "h1"});
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (auto i = 0; i < 8; ++i) {
+        threads.emplace_back([&held, &failed]() {
+            for (auto j = 0; j < 1000; ++j) {
+                const detail::ss_fw a(symbol_set{"h0", "h1"});
+                const detail::ss_fw b(symbol_set{"t", std::to_string(j % 10)});
+                const detail::ss_fw c(symbol_set{"t", std::to_string(j % 10)});
+
+                if (a != held || b != c || b.get() != symbol_set{"t", std::to_string(j % 10)}) {
+                    failed.store(true);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    REQUIRE(!failed.load());
 }
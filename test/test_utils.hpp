@@ -31,6 +31,22 @@ inline void disable_slow_stack_traces()
 #endif
 }
 
+// Copy the terms of the series x into a series
+// of the same type with 2**l segments.
+template <typename S>
+inline S make_segmented(const S &x, unsigned l)
+{
+    S retval;
+    retval.set_symbol_set(x.get_symbol_set());
+    retval.tag() = x.tag();
+    retval.set_n_segments(l);
+    for (const auto &t : x) {
+        retval.add_term(t.first, t.second);
+    }
+
+    return retval;
+}
+
 } // namespace obake_test
 
 #define OBAKE_REQUIRES_THROWS_CONTAINS(expr, exc, msg)                                                                 \